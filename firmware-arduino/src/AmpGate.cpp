@@ -0,0 +1,65 @@
+#include "AmpGate.h"
+
+void AmpGate::begin(const AmpGateConfig &config, uint32_t now_ms) {
+    cfg = config;
+    _stats = AmpGateStats();
+    on = false;
+    holding = false;
+    awaiting_audio = false;
+    last_ms = now_ms;
+}
+
+AmpGate::Action AmpGate::update(uint32_t now_ms, bool wanted, bool audio) {
+    uint32_t elapsed = now_ms - last_ms;
+    last_ms = now_ms;
+    if (on) {
+        _stats.on_ms += elapsed;
+    } else {
+        _stats.off_ms += elapsed;
+    }
+
+    if (wanted || audio) {
+        holding = false;
+        if (!on) {
+            on = true;
+            enabled_ms = now_ms;
+            _stats.enables++;
+            if (audio) {
+                // the first block waits behind the pre-roll
+                _stats.cold_starts++;
+            } else {
+                awaiting_audio = true;
+            }
+            return AMP_ENABLE;
+        }
+        if (audio && awaiting_audio) {
+            awaiting_audio = false;
+            _stats.warm_starts++;
+            _stats.last_lead_ms = now_ms - enabled_ms;
+        }
+        return AMP_KEEP;
+    }
+
+    if (!on) {
+        return AMP_KEEP;
+    }
+    if (!holding) {
+        holding = true;
+        idle_since_ms = now_ms;
+    }
+    if (now_ms - idle_since_ms >= cfg.idle_hold_ms) {
+        on = false;
+        holding = false;
+        awaiting_audio = false;
+        return AMP_DISABLE;
+    }
+    return AMP_KEEP;
+}
+
+uint32_t AmpGate::msUntilOff(uint32_t now_ms) const {
+    if (!on || !holding) {
+        return UINT32_MAX;
+    }
+    uint32_t idle = now_ms - idle_since_ms;
+    return idle >= cfg.idle_hold_ms ? 0 : cfg.idle_hold_ms - idle;
+}
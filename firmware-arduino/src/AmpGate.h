@@ -0,0 +1,63 @@
+#ifndef AMPGATE_H
+#define AMPGATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Power state of the speaker amplifier (its SD/enable pin). The amp is switched
+// on as soon as audio is wanted, which for an answer is RESPONSE.CREATED, while
+// the jitter buffer is still filling, so it has settled before the first
+// sample. It is switched off only after `idle_hold_ms` without audio, so a
+// short pause between answers or an earcon does not cycle it (and pop).
+// The caller writes `preroll` of silence after every switch-on so the amp
+// starts up on zeros rather than on the first word.
+// Plain C++ (no Arduino/FreeRTOS) so it can be exercised on the host.
+
+struct AmpGateConfig {
+    uint32_t idle_hold_ms = 2000;  // audio-free time before switching off
+};
+
+struct AmpGateStats {
+    uint32_t enables = 0;
+    uint32_t warm_starts = 0;   // audio found the amp already on
+    uint32_t cold_starts = 0;   // audio had to wait for a switch-on and its pre-roll
+    uint32_t last_lead_ms = 0;  // switch-on to first audio of the latest warm start
+    uint32_t on_ms = 0;         // total time switched on, up to the last update()
+    uint32_t off_ms = 0;
+};
+
+class AmpGate {
+public:
+    enum Action {
+        AMP_KEEP,      // nothing to do
+        AMP_ENABLE,    // raise the enable pin and write the pre-roll
+        AMP_DISABLE    // lower the enable pin
+    };
+
+    void begin(const AmpGateConfig &config, uint32_t now_ms);
+    void setIdleHoldMs(uint32_t ms) { cfg.idle_hold_ms = ms; }
+
+    // Call whenever the wish for audio may have changed and at least when
+    // msUntilOff() runs out. `wanted` is true while audio plays or is expected
+    // (an answer is being received); `audio` is true when the current output
+    // block holds sound, which is what warm and cold starts are counted on.
+    Action update(uint32_t now_ms, bool wanted, bool audio);
+
+    // Time left in the idle hold, UINT32_MAX when no switch-off is pending.
+    uint32_t msUntilOff(uint32_t now_ms) const;
+
+    bool isOn() const { return on; }
+    const AmpGateStats &stats() const { return _stats; }
+
+protected:
+    AmpGateConfig cfg;
+    AmpGateStats _stats;
+    bool on = false;
+    bool holding = false;
+    bool awaiting_audio = false;  // switched on, no audio played since
+    uint32_t enabled_ms = 0;
+    uint32_t idle_since_ms = 0;
+    uint32_t last_ms = 0;
+};
+
+#endif
@@ -1,7 +1,7 @@
 #include "OTA.h"
 #include "Audio.h"
-#include "PitchShift.h"
 #include "BhajanAudio.h" // Add include for Bhajan Audio
+#include "JitterBuffer.h"
 
 // WEBSOCKET
 SemaphoreHandle_t wsMutex;
@@ -14,7 +14,9 @@ bool isWebSocketConnected = false;
 // TASK HANDLES
 TaskHandle_t speakerTaskHandle = NULL;
 TaskHandle_t micTaskHandle = NULL;
+TaskHandle_t micEncodeTaskHandle = NULL; // created by startMicEncoder()
 TaskHandle_t networkTaskHandle = NULL;
+TaskHandle_t decodeTaskHandle = NULL;
 
 // TIMING REGISTERS
 volatile bool scheduleListeningRestart = false;
@@ -24,58 +26,106 @@ unsigned long speakingStartTime = 0;
 // AUDIO SETTINGS
 int currentVolume = 70;
 float currentPitchFactor = 1.0f;
+volatile WsolaQuality pitchQuality = PITCH_QUALITY_DEFAULT;
 const int CHANNELS = 1;         // Mono
 const int BITS_PER_SAMPLE = 16; // 16-bit audio
 
 // AUDIO OUTPUT
-class BufferPrint : public Print {
-public:
-  explicit BufferPrint(BufferRTOS<uint8_t>& buf) : _buffer(buf) {}
-
-  // networkTask -> webSocket.loop() -> webSocketEvent(WStype_BIN, ...) -> opusDecoder.write() -> bufferPrint.write()
-  virtual size_t write(uint8_t data) override {
-    if (webSocket.isConnected() && deviceState == SPEAKING) {
-        return _buffer.writeArray(&data, 1);
-    }
-    return 1; //let opusDecoder write, otherwise thread will stuck
-  }
-
-  // networkTask -> webSocket.loop() -> webSocketEvent(WStype_BIN, ...) -> opusDecoder.write() -> bufferPrint.write()
-  virtual size_t write(const uint8_t *buffer, size_t size) override {
-    if (webSocket.isConnected() && deviceState == SPEAKING) {
-        return _buffer.writeArray(buffer, size);
-    }
-    return size; //let opusDecoder write, otherwise thread will stuck
-  }
-
-private:
-  BufferRTOS<uint8_t>& _buffer;
-};
-
-BufferPrint bufferPrint(audioBuffer);
-OpusAudioDecoder opusDecoder;  //access guarded by wsmutex
-BufferRTOS<uint8_t> audioBuffer(AUDIO_BUFFER_SIZE, AUDIO_CHUNK_SIZE);  //producer: networkTask, consumer: audioStreamTask. Thread safe in single producer->single consumer scenario.
+OpusFrameDecoder opusDecoder;  //access from audioDecodeTask only
+volatile bool audioSeqEnabled = false;
+volatile bool opusFecEnabled = false;
+// Mixer sources: each producer fills frames in place, audioStreamTask mixes them
+PcmFramePool speechFrames; // producer: audioDecodeTask
+PcmFramePool bhajanFrames; // producer: bhajanAudioTask
+PcmFramePool earconFrames; // producer: queueEarcon() callers, or audioStreamTask for the thinking cue
+volatile bool thinkingCueEnabled = true;
+volatile bool thinkingCueRequested = false;
+ThinkingCueStats thinkingCueStats;  // written by audioStreamTask only
+static EarconPlayer thinkingCue;    //access from audioStreamTask only
+static uint32_t thinkingStartMs = 0;
+static uint32_t thinkingFadeStartMs = 0; // crossfade into the answer started, 0 = not yet
+AudioMixer audioMixer;     // mix() and clear() from audioStreamTask only
 I2SStream i2s; //access from audioStreamTask only
 // Flag that indicates the Opus decoder has been initialized and is safe to call
 volatile bool opusDecoderReady = false;
 
-// OLD with no pitch shift
-VolumeStream volume(i2s); //access from audioStreamTask only
-QueueStream<uint8_t> queue(audioBuffer); //access from audioStreamTask only
-StreamCopy copier(volume, queue);
-
-// NEW for pitch shift (lossy)
-PitchShiftFixedOutput pitchShift(i2s);
-VolumeStream volumePitch(pitchShift); //access from audioStreamTask only
-StreamCopy pitchCopier(volumePitch, queue);
-
-AudioInfo info(SAMPLE_RATE, CHANNELS, BITS_PER_SAMPLE);
+// Opus packets between the WebSocket and the decoder
+// producer: networkTask, consumer: audioDecodeTask, access guarded by jitterMutex
+SemaphoreHandle_t jitterMutex;
+SemaphoreHandle_t jitterSpace; // given by audioDecodeTask whenever a slot is freed
+JitterBuffer jitterBuffer;
+static uint8_t jitterPacket[OPUS_MAX_PACKET_BYTES]; //access from audioDecodeTask only
+static uint8_t fecPacket[OPUS_MAX_PACKET_BYTES];    //access from audioDecodeTask only
+static uint16_t rxSequence = 0; //access from networkTask only
+static volatile bool jitterThrottled = false; // networkTask had to wait for a free slot
+
+// Speech is trimmed to the server's clock by the jitter buffer depth
+DriftEstimator speechDrift;          //access from audioDecodeTask only
+static Resampler speechResampler;    //access from audioDecodeTask only
+static volatile bool speechDriftReset = false; // a new turn or session starts, set by networkTask
+
+TimingStats decodeTiming;      // per packet, audioDecodeTask
+TimingStats networkLoopTiming; // per webSocket.loop(), networkTask
+TimingStats wsHoldTiming;      // wsMutex take to give per networkTask pass: interrupt, mic send and loop()
+DownlinkStats downlinkStats;
+TimingStats mixerTiming;       // per mixed block, audioStreamTask
+TimingStats speakerProtectionTiming; // per block, audioStreamTask
+LevelMeter speakerLevels;
+LevelMeter micLevels;
+static SpeakerProtection speakerProtection; //access from audioStreamTask only
+TaskLoad speakerLoad;          // written by audioStreamTask only
+TimingStats bargeInTiming;     // per cancel, audioStreamTask
+AmpGate ampGate;
+volatile uint32_t ampIdleHoldMs = AMP_IDLE_HOLD_MS;
+
+// I2S DMA ring sizes, see DmaTuner
+DmaTuner outputDma;
+DmaTuner micDma;
+volatile bool dmaAutoTune = true;
+volatile uint32_t outputDmaRequest = 0;
+volatile uint32_t micDmaRequest = 0;
+static const char *DMA_NVS_NAMESPACE = "audio";
+
+// Barge-in state, set by requestSpeechCancel()
+static volatile uint32_t cancelStartUs = 0;
+static volatile bool speechCancelActive = false; // cleared by audioStreamTask once speech has played out
+static volatile bool interruptPending = false;   // cleared by networkTask once the server is told
+
+// Pitch shift, applied in place on speech frames. Auth sizes it (reserveSpeechPitch)
+// under speechPitchMutex; audioStreamTask only re-parameterises and runs it.
+static WsolaPitchShift speechPitch;
+static SemaphoreHandle_t speechPitchMutex = NULL;   // audioStreamTask never waits for it
+static uint32_t speechPitchMaxRate = 0;             // reserved up to this rate, 0 = nothing reserved
+static WsolaQuality speechPitchTier = PITCH_QUALITY_DEFAULT; // ... at this tier
+static bool speechPitchDirty = false; // holds audio from the last answer
+
+AudioInfo info(SAMPLE_RATE, CHANNELS, BITS_PER_SAMPLE); // info.sample_rate follows outputSampleRate
 volatile bool i2sOutputFlushScheduled = false;
+volatile uint32_t sessionSampleRate = SAMPLE_RATE;
+volatile uint16_t sessionFrameMs = 0;
+volatile uint32_t outputSampleRate = SAMPLE_RATE;
 // Diagnostics: track frames received/decoded after RESPONSE.CREATED
-volatile unsigned long lastResponseCreatedTime = 0;
+TurnTiming turnTiming;
+volatile uint16_t prebufferMs = JITTER_PREBUFFER_MS;
 volatile int framesReceivedThisTurn = 0;
 volatile unsigned long lastDecodedBytes = 0;
 
+bool isSupportedSampleRate(uint32_t rate) {
+    for (uint32_t supported : SUPPORTED_SAMPLE_RATES) {
+        if (rate == supported) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Opus frame durations from 10 ms up to 120 ms packets, as long as a packet
+// still fits a speech frame at that rate.
+bool isSupportedFrameMs(uint16_t ms, uint32_t rate) {
+    bool opus = ms == 10 || (ms % 20 == 0 && ms >= 20 && ms <= 120);
+    return opus && (size_t)ms * rate / 1000 <= OPUS_MAX_FRAME_SAMPLES;
+}
+
 unsigned long getSpeakingDuration() {
     if (deviceState == SPEAKING && speakingStartTime > 0) {
         return millis() - speakingStartTime;
@@ -83,15 +133,315 @@ unsigned long getSpeakingDuration() {
     return 0;
 }
 
+// audioDecodeTask -> decodeNextPacket() -> decodePlayoutSlot() (into the frame)
+// Missing packets are rebuilt from the next packet's FEC data when the server
+// sends it, otherwise concealed with Opus PLC. Returns false while the jitter
+// buffer has nothing to play.
+static bool decodeNextPacket(PcmFrame *frame) {
+    xSemaphoreTake(jitterMutex, portMAX_DELAY);
+    PlayoutSlot slot = takePlayoutSlot(jitterBuffer, millis(), opusFecEnabled, jitterPacket, sizeof(jitterPacket),
+                                       fecPacket, sizeof(fecPacket));
+    uint32_t depthMs = jitterBuffer.depthMs();
+    uint32_t targetMs = jitterBuffer.targetDepthMs();
+    xSemaphoreGive(jitterMutex);
+
+    if (slot.result == JitterBuffer::POP_BUFFERING) {
+        return false;
+    }
+    xSemaphoreGive(jitterSpace);
+
+    // the frame is resampled in place, so the output at the I2S rate has to fit too
+    size_t maxSamples = (uint64_t)frame->capacity * speechResampler.inputRate() / speechResampler.outputRate();
+    if (maxSamples > OPUS_MAX_FRAME_SAMPLES) {
+        maxSamples = OPUS_MAX_FRAME_SAMPLES;
+    }
+    uint32_t start = micros();
+    int samples = decodePlayoutSlot(opusDecoder, slot, jitterPacket, fecPacket, frame->samples, (int)maxSamples);
+    decodeTiming.add(micros() - start);
+
+    // A server running at its own clock keeps the depth around the target; one
+    // that sends ahead fills the buffer up and waits for slots, which says nothing
+    bool throttled = jitterThrottled;
+    jitterThrottled = false;
+    speechDrift.setTarget(targetMs * SAMPLE_RATE / 1000);
+    int32_t ppm = speechDrift.update(millis(), depthMs * SAMPLE_RATE / 1000, !throttled && depthMs > 0);
+    if (ppm != speechResampler.rateAdjust()) {
+        speechResampler.setRateAdjust(ppm);
+    }
+    if (samples > 0) {
+        size_t consumed = 0;
+        samples = (int)speechResampler.process(frame->samples, samples, consumed, frame->samples, frame->capacity);
+    }
+
+    frame->count = samples * CHANNELS;
+    size_t processed = frame->count * sizeof(int16_t);
+    lastDecodedBytes = processed;
+    if (processed == 0) {
+        Serial.printf("Warning: decoder produced no audio for packet %u\n", (unsigned)slot.seq);
+    }
+    return true;
+}
+
+// networkTask -> webSocket.loop() -> webSocketEvent(WStype_BIN, ...) -> queueOpusPacket()
+// Never decodes. When all slots are taken the network task waits for the decoder
+// to free one, then drops the oldest packet.
+//
+// The wait runs with wsMutex held, so it stalls the mic uplink and every other
+// sender; in exchange a server sending ahead of real time is slowed by TCP flow
+// control instead of losing audio. It is capped at the packet's own duration
+// (at most JITTER_PUSH_WAIT_MS): a decoder playing in real time frees a slot
+// within one packet, and the stall stays about one frame long.
+static bool queueOpusPacket(uint16_t seq, const uint8_t *payload, size_t length, uint16_t durationMs) {
+    xSemaphoreTake(jitterMutex, portMAX_DELAY);
+    bool queued = jitterBuffer.push(seq, payload, length, durationMs, millis());
+    bool full = !queued && jitterBuffer.isFull();
+    xSemaphoreGive(jitterMutex);
+
+    if (full) {
+        jitterThrottled = true;
+        xSemaphoreTake(jitterSpace, 0); // clear a stale signal
+        xTaskNotifyGive(decodeTaskHandle);
+        uint32_t waitMs = durationMs < JITTER_PUSH_WAIT_MS ? durationMs : JITTER_PUSH_WAIT_MS;
+        bool freed = xSemaphoreTake(jitterSpace, pdMS_TO_TICKS(waitMs)) == pdTRUE;
+
+        xSemaphoreTake(jitterMutex, portMAX_DELAY);
+        if (!freed || jitterBuffer.isFull()) {
+            jitterBuffer.dropOldest();
+        }
+        queued = jitterBuffer.push(seq, payload, length, durationMs, millis());
+        xSemaphoreGive(jitterMutex);
+    }
+
+    if (queued) {
+        xTaskNotifyGive(decodeTaskHandle);
+    }
+    return queued;
+}
+
+static void resetJitterBuffer() {
+    xSemaphoreTake(jitterMutex, portMAX_DELAY);
+    jitterBuffer.reset();
+    jitterBuffer.setPrebufferMs(prebufferMs);
+    xSemaphoreGive(jitterMutex);
+    speechDriftReset = true;
+}
+
+DriftEstimatorConfig driftConfig() {
+    DriftEstimatorConfig cfg;
+    cfg.sample_rate = SAMPLE_RATE;
+    cfg.window_ms = DRIFT_WINDOW_MS;
+    cfg.center_ms = DRIFT_CENTER_MS;
+    cfg.max_ppm = DRIFT_MAX_PPM;
+    return cfg;
+}
+
+static void appendDriftTelemetry(JsonObject obj, const DriftStats &stats) {
+    obj["drift_ppm"] = stats.drift_ppm;
+    obj["correction_ppm"] = stats.correction_ppm;
+    obj["fill_error_ms"] = stats.fill_error * 1000 / (int32_t)SAMPLE_RATE;
+    obj["windows"] = stats.windows;
+    obj["skipped"] = stats.skipped_windows;
+}
+
+void appendAudioTelemetry(JsonDocument &doc) {
+    const JitterBufferStats &jb = jitterBuffer.stats();
+    JsonObject jitter = doc["jitter_buffer"].to<JsonObject>();
+    jitter["packets"] = jb.packets_received;
+    jitter["played"] = jb.packets_played;
+    jitter["underruns"] = jb.underruns;
+    jitter["late"] = jb.late_packets;
+    jitter["drops"] = jb.overflow_drops;
+    jitter["depth_ms"] = jb.depth_ms;
+    jitter["max_depth_ms"] = jb.max_depth_seen_ms;
+    jitter["target_ms"] = jb.target_depth_ms;
+    jitter["jitter_ms"] = jb.jitter_ms;
+    jitter["prebuffer_ms"] = jitterBuffer.prebufferMs();
+
+    // time to first audio, relative to RESPONSE.CREATED of the latest turn
+    JsonObject turn = doc["turn"].to<JsonObject>();
+    uint32_t created = turnTiming.created_ms;
+    if (created != 0) {
+        uint32_t rx = turnTiming.first_rx_ms;
+        uint32_t decoded = turnTiming.first_decoded_ms;
+        uint32_t written = turnTiming.first_write_ms;
+        uint32_t drained = turnTiming.drained_ms;
+        turn["first_rx_ms"] = rx ? (int32_t)(rx - created) : -1;
+        turn["first_decoded_ms"] = decoded ? (int32_t)(decoded - created) : -1;
+        turn["first_audio_ms"] = written ? (int32_t)(written - created) : -1;
+        turn["drained_ms"] = drained ? (int32_t)(drained - created) : -1;
+    }
+
+    JsonObject format = doc["downlink"].to<JsonObject>();
+    format["sample_rate"] = sessionSampleRate;
+    format["frame_ms"] = sessionFrameMs;
+    format["i2s_rate"] = outputSampleRate;
+    format["messages"] = downlinkStats.messages;
+    format["frames"] = downlinkStats.frames;
+    format["bytes"] = downlinkStats.bytes;
+    format["rejected"] = downlinkStats.rejected;
+    // messages per second of speech, the number the frame duration is chosen for
+    format["msgs_per_s"] = downlinkStats.audio_ms ? downlinkStats.messages * 1000.0f / downlinkStats.audio_ms : 0.0f;
+    format["dispatch_avg_us"] = downlinkStats.dispatch.avg_us;
+    format["dispatch_max_us"] = downlinkStats.dispatch.max_us;
+
+    JsonObject drift = doc["clock_drift"].to<JsonObject>();
+    appendDriftTelemetry(drift["speech"].to<JsonObject>(), speechDrift.stats());
+    appendDriftTelemetry(drift["bhajan"].to<JsonObject>(), bhajanDrift.stats());
+
+    JsonObject decode = doc["decode"].to<JsonObject>();
+    decode["frames"] = decodeTiming.count;
+    decode["last_us"] = decodeTiming.last_us;
+    decode["avg_us"] = decodeTiming.avg_us;
+    decode["max_us"] = decodeTiming.max_us;
+
+    JsonObject loop = doc["network_loop"].to<JsonObject>();
+    loop["avg_us"] = networkLoopTiming.avg_us;
+    loop["max_us"] = networkLoopTiming.max_us;
+    // how long other tasks wanting the socket can be kept waiting
+    loop["ws_hold_avg_us"] = wsHoldTiming.avg_us;
+    loop["ws_hold_max_us"] = wsHoldTiming.max_us;
+
+    // load since the previous status update
+    static uint32_t lastReportMs = 0;
+    static TaskLoad lastSpeakerLoad;
+    uint32_t now = millis();
+    uint32_t windowMs = now - lastReportMs;
+    TaskLoad load = speakerLoad;
+    JsonObject speaker = doc["speaker_task"].to<JsonObject>();
+    if (lastReportMs != 0 && windowMs > 0) {
+        speaker["wakeups_per_s"] = (load.wakeups - lastSpeakerLoad.wakeups) * 1000 / windowMs;
+        speaker["cpu_permille"] = (load.busy_us - lastSpeakerLoad.busy_us) / windowMs;
+    }
+    speaker["mix_avg_us"] = mixerTiming.avg_us;
+    speaker["mix_max_us"] = mixerTiming.max_us;
+    speaker["mix_budget_us"] = MIXER_CPU_BUDGET_US;
+    speaker["over_budget"] = load.over_budget;
+    speaker["protection_avg_us"] = speakerProtectionTiming.avg_us;
+    speaker["protection_max_us"] = speakerProtectionTiming.max_us;
+    speaker["protection_budget_us"] = SPEAKER_PROTECTION_BUDGET_US;
+    speaker["limited_samples"] = speakerProtection.stats().limited_samples;
+    speaker["min_limiter_gain_q15"] = speakerProtection.stats().min_gain_q15;
+    speaker["speech_underruns"] = audioMixer.underruns(MIXER_SPEECH);
+    speaker["bhajan_underruns"] = audioMixer.underruns(MIXER_BHAJAN);
+    if (speakerTaskHandle) {
+        // the least free stack ever seen, bytes on the ESP32
+        speaker["stack_free_bytes"] = uxTaskGetStackHighWaterMark(speakerTaskHandle);
+        speaker["stack_bytes"] = SPEAKER_TASK_STACK_BYTES;
+    }
+    if (speechPitch.active()) {
+        JsonObject pitch = speaker["pitch"].to<JsonObject>();
+        pitch["quality"] = (int)speechPitch.quality();
+        pitch["latency_ms"] = speechPitch.latencySamples() * 1000 / speechPitch.sampleRate();
+        pitch["underrun_samples"] = speechPitch.underruns();
+    }
+    lastReportMs = now;
+    lastSpeakerLoad = load;
+
+    JsonObject plc = doc["plc"].to<JsonObject>();
+    plc["decoded"] = opusDecoder.decodedFrames();
+    plc["concealed"] = opusDecoder.concealedFrames();
+    plc["recovered"] = opusDecoder.recoveredFrames();
+    // "arrival" numbers packets as they come, which leaves no gaps to conceal
+    plc["seq"] = audioSeqEnabled ? "server" : "arrival";
+
+    JsonObject dma = doc["i2s_dma"].to<JsonObject>();
+    dma["autotune"] = (bool)dmaAutoTune;
+    JsonObject out = dma["out"].to<JsonObject>();
+    out["buffers"] = outputDma.settings().buffers;
+    out["frames"] = outputDma.settings().frames;
+    out["ring_ms"] = outputDma.settings().totalFrames() * 1000 / SAMPLE_RATE;
+    out["underruns"] = outputDma.xruns();
+    out["grows"] = outputDma.grows();
+    out["shrinks"] = outputDma.shrinks();
+    JsonObject mic = dma["mic"].to<JsonObject>();
+    mic["buffers"] = micDma.settings().buffers;
+    mic["frames"] = micDma.settings().frames;
+    mic["overruns"] = micDma.xruns();
+    mic["grows"] = micDma.grows();
+    mic["shrinks"] = micDma.shrinks();
+
+    JsonObject uplink = doc["mic_uplink"].to<JsonObject>();
+    uplink["frame_ms"] = micFrameMs;
+    uplink["messages"] = micUplink.messages;
+    uplink["bytes"] = micUplink.bytes;
+    uplink["wire_bytes"] = micUplink.wire_bytes;
+    // messages per second of audio and the share of the wire that is framing,
+    // the numbers frame_ms trades against latency
+    uplink["msgs_per_s"] = micUplink.audio_ms ? micUplink.messages * 1000.0f / micUplink.audio_ms : 0.0f;
+    uplink["overhead_permille"] =
+        micUplink.wire_bytes ? (micUplink.wire_bytes - micUplink.bytes) * 1000ULL / micUplink.wire_bytes : 0;
+    // time in sendBIN() for the mic alone; the whole wsMutex hold is network_loop.ws_hold_*
+    uplink["send_time_avg_us"] = micUplink.send.avg_us;
+    uplink["send_time_max_us"] = micUplink.send.max_us;
+    uplink["copied_frames"] = micReader.copiedFrames();
+    uplink["ring_drops"] = micUplink.ring_drops;
+    uplink["max_fill_bytes"] = micUplink.max_fill_bytes;
+    uplink["codec"] = micOpusEnabled ? "opus" : "pcm16";
+    if (micOpusEnabled) {
+        uplink["bitrate"] = micOpusBitrate;
+        uplink["complexity"] = micOpusComplexity;
+        uplink["encode_avg_us"] = micUplink.encode.avg_us;
+        uplink["encode_max_us"] = micUplink.encode.max_us;
+        // share of micEncodeTask's core spent encoding, per mille of each frame
+        uplink["encode_permille"] = micUplink.encode.avg_us / micFrameMs;
+        // headroom left in MIC_ENCODER_STACK_BYTES, to size it from
+        uplink["stack_free_bytes"] = uxTaskGetStackHighWaterMark(micEncodeTaskHandle);
+        uplink["latency_avg_us"] = micUplink.latency.avg_us;
+        uplink["latency_max_us"] = micUplink.latency.max_us;
+    }
+
+    // a warm start should skip the old fixed 50 ms wake and the amp's own
+    // start-up; saved_uah is the off time at the datasheet quiescent current,
+    // an estimate since the device cannot measure its supply current
+    const AmpGateStats &ampStats = ampGate.stats();
+    JsonObject amp = doc["amp"].to<JsonObject>();
+    amp["on"] = ampGate.isOn();
+    amp["enables"] = ampStats.enables;
+    amp["warm_starts"] = ampStats.warm_starts;
+    amp["cold_starts"] = ampStats.cold_starts;
+    amp["lead_ms"] = ampStats.last_lead_ms;
+    amp["hold_ms"] = ampIdleHoldMs;
+    uint64_t ampTotalMs = (uint64_t)ampStats.on_ms + ampStats.off_ms;
+    amp["on_permille"] = ampTotalMs ? (uint32_t)((uint64_t)ampStats.on_ms * 1000 / ampTotalMs) : 0;
+    amp["saved_uah"] = (uint32_t)((uint64_t)ampStats.off_ms * AMP_QUIESCENT_UA / 3600000);
+
+    JsonObject cue = doc["thinking_cue"].to<JsonObject>();
+    cue["played"] = thinkingCueStats.played;
+    cue["crossfaded"] = thinkingCueStats.crossfaded;
+    cue["last_ms"] = thinkingCueStats.last_ms;
+
+    // clipped counts since boot: at the speaker, samples the limiter had to
+    // pull back from past full scale; at the mic, samples at full scale
+    JsonObject levels = doc["levels"].to<JsonObject>();
+    const LevelMeter *meters[] = {&speakerLevels, &micLevels};
+    const char *meterNames[] = {"speaker", "mic"};
+    for (size_t i = 0; i < 2; i++) {
+        DspLevels now = meters[i]->current();
+        JsonObject m = levels[meterNames[i]].to<JsonObject>();
+        m["rms"] = now.rms;
+        m["peak"] = now.peak;
+        m["blocks"] = meters[i]->blockCount();
+        m["clipped_samples"] = meters[i]->clippedSamples();
+        m["clipped_blocks"] = meters[i]->clippedBlocks();
+    }
+
+    JsonObject bargeIn = doc["barge_in"].to<JsonObject>();
+    bargeIn["count"] = bargeInTiming.count;
+    bargeIn["last_us"] = bargeInTiming.last_us;
+    bargeIn["avg_us"] = bargeInTiming.avg_us;
+    bargeIn["max_us"] = bargeInTiming.max_us;
+    bargeIn["budget_us"] = BARGE_IN_BUDGET_SAMPLES * 1000000ULL / SAMPLE_RATE;
+}
+
 // networkTask -> webSocket.loop() -> webSocketEvent(WStype_TEXT, ...) -> transitionToSpeaking()
+// The amp is switched on by audioStreamTask as soon as it sees SPEAKING, while
+// the jitter buffer fills.
 void transitionToSpeaking() {
-    vTaskDelay(50);
-
     i2sInputFlushScheduled = true;
     
     deviceState = SPEAKING;
-    digitalWrite(I2S_SD_OUT, HIGH);
     speakingStartTime = millis();
+    notifySpeakerTask(SPEAKER_EVT_STATE);
     
     // webSocket.enableHeartbeat(30000, 15000, 3);
     
@@ -107,123 +457,709 @@ void transitionToListening() {
 
     i2sInputFlushScheduled = true;
     i2sOutputFlushScheduled = true;
+    resetJitterBuffer();
 
     Serial.println("Transitioned to listening mode");
 
     deviceState = LISTENING;
-    digitalWrite(I2S_SD_OUT, LOW);
+    // audioStreamTask switches the amplifier off once nothing has played for the idle hold
+    notifySpeakerTask(SPEAKER_EVT_FLUSH | SPEAKER_EVT_STATE);
     // webSocket.disableHeartbeat();
 }
 
-// audioStreamTask -> copier.copy() (conditional on webSocket.isConnected())
-void audioStreamTask(void *parameter) {
-    Serial.println("Starting I2S stream pipeline...");
-    
-    pinMode(I2S_SD_OUT, OUTPUT);
+// touchTask -> requestSpeechCancel()
+// Barge-in: networkTask stops queueing audio, tells the server how much of the
+// answer was heard and returns to listening; audioStreamTask fades speech out.
+void requestSpeechCancel() {
+    if (deviceState != SPEAKING || speechCancelActive) {
+        return;
+    }
+    cancelStartUs = micros();
+    speechCancelActive = true;
+    interruptPending = true;
+    scheduledTime = millis();
+    scheduleListeningRestart = true; // also drops audio still arriving for this answer
+    notifySpeakerTask(SPEAKER_EVT_CANCEL);
+}
 
-    OpusSettings cfg;
-    cfg.sample_rate = SAMPLE_RATE;
-    cfg.channels = CHANNELS;
-    cfg.bits_per_sample = BITS_PER_SAMPLE;
-    cfg.max_buffer_size = 6144;
+// networkTask -> sendInterrupt() (wsMutex held)
+// Lets the server truncate the answer to what was actually played.
+static void sendInterrupt() {
+    JsonDocument doc;
+    doc["type"] = "instruction";
+    doc["msg"] = "INTERRUPT";
+    doc["audio_end_ms"] = (uint64_t)turnTiming.played_samples * 1000 / SAMPLE_RATE;
+
+    String jsonString;
+    serializeJson(doc, jsonString);
+    webSocket.sendTXT(jsonString);
+}
 
-    xSemaphoreTake(wsMutex, portMAX_DELAY);
-    opusDecoder.setOutput(bufferPrint);
-    opusDecoder.begin(cfg);
+static DmaSettings unpackDmaSettings(uint32_t packed) {
+    DmaSettings settings;
+    settings.buffers = packed >> 16;
+    settings.frames = packed & 0xffff;
+    return settings;
+}
+
+// audioStreamTask / micTask -> loadDmaSettings()
+// Own Preferences handle, the shared one is used by other tasks without locking.
+static DmaSettings loadDmaSettings(const char *key, uint8_t buffers, uint16_t frames) {
+    Preferences prefs;
+    uint32_t packed = packDmaSettings(buffers, frames);
+    if (prefs.begin(DMA_NVS_NAMESPACE, true)) {
+        packed = prefs.getUInt(key, packed);
+        prefs.end();
+    }
+    return unpackDmaSettings(packed);
+}
+
+// audioStreamTask / micTask -> saveDmaSettings() (only after a change, to spare the flash)
+static void saveDmaSettings(const char *key, const DmaSettings &settings) {
+    Preferences prefs;
+    if (prefs.begin(DMA_NVS_NAMESPACE, false)) {
+        prefs.putUInt(key, packDmaSettings(settings.buffers, settings.frames));
+        prefs.end();
+    }
+}
+
+// audioStreamTask / micTask -> takeDmaChange()
+// Folds in a server request and the tuner's own decision. Returns true when the
+// stream has to be restarted with tuner.settings().
+static bool takeDmaChange(DmaTuner &tuner, volatile uint32_t &request, const DmaSettings &applied) {
+    tuner.setAutoTune(dmaAutoTune);
+    uint32_t packed = request;
+    if (packed != 0) {
+        request = 0;
+        tuner.set(unpackDmaSettings(packed));
+    }
+    return tuner.settings() != applied;
+}
+
+// audioStreamTask -> configureOutput()
+// DMA frames are counted at SAMPLE_RATE, so the ring keeps its duration at any rate.
+static void configureOutput(I2SConfig &config, uint32_t rate, const DmaSettings &dma) {
+    SpeakerProtectionConfig protection;
+    protection.sample_rate = rate;
+    for (size_t i = 0; i < SPEAKER_EQ_STAGES; i++) {
+        protection.eq[i] = SPEAKER_EQ[i];
+    }
+    protection.ceiling = SPEAKER_LIMIT_CEILING;
+    protection.lookahead_us = SPEAKER_LOOKAHEAD_US;
+    protection.release_ms = SPEAKER_RELEASE_MS;
+    speakerProtection.begin(protection);
+
+    outputSampleRate = rate;
+    info.sample_rate = rate;
+    config.sample_rate = rate;
+    config.buffer_count = dma.buffers;
+    config.buffer_size = samplesAtRate(dma.frames, rate);
+}
+
+// networkTask -> webSocketEvent(auth) -> applySessionFormat()
+// The decoder switches before the next answer, the I2S clock once it is idle.
+static void applySessionFormat(uint32_t rate, uint16_t frameMs) {
+    if (!isSupportedSampleRate(rate)) {
+        Serial.printf("Unsupported sample_rate %u, using %u\n", (unsigned)rate, (unsigned)SAMPLE_RATE);
+        rate = SAMPLE_RATE;
+    }
+    if (frameMs != 0 && !isSupportedFrameMs(frameMs, rate)) {
+        Serial.printf("Unsupported frame_ms %u at %u Hz, ignored\n", (unsigned)frameMs, (unsigned)rate);
+        frameMs = 0;
+    }
+    sessionSampleRate = rate;
+    sessionFrameMs = frameMs;
+    speechDriftReset = true;
+    notifySpeakerTask(SPEAKER_EVT_STATE);
+}
+
+// audioDecodeTask -> decodeNextPacket() (whenever a speech frame is free)
+void audioDecodeTask(void *parameter) {
+    JitterBufferConfig jcfg;
+    jcfg.capacity = JITTER_BUFFER_PACKETS;
+    jcfg.max_packet_bytes = OPUS_MAX_PACKET_BYTES;
+    jcfg.min_depth_ms = JITTER_MIN_DEPTH_MS;
+    jcfg.max_depth_ms = JITTER_MAX_DEPTH_MS;
+
+    xSemaphoreTake(jitterMutex, portMAX_DELAY);
+    jitterBuffer.begin(jcfg);
+    xSemaphoreGive(jitterMutex);
+
+    uint32_t decoderRate = sessionSampleRate;
+    uint16_t decoderFrameMs = sessionFrameMs;
+    opusDecoder.begin(decoderRate, CHANNELS, decoderFrameMs ? decoderFrameMs : 20);
+    // resamples in place, so a whole decoded frame must fit in one call
+    speechResampler.begin(decoderRate, outputSampleRate, RESAMPLE_MEDIUM, OPUS_MAX_FRAME_SAMPLES);
+    speechDrift.begin(driftConfig());
     // Mark decoder as ready for incoming binary frames
     opusDecoderReady = true;
-    xSemaphoreGive(wsMutex);
 
-    audioBuffer.setReadMaxWait(0);
+    while (1) {
+        // Woken by networkTask for every queued packet; polls while speaking so
+        // frames are refilled as audioStreamTask hands them back.
+        ulTaskNotifyTake(pdTRUE, deviceState == SPEAKING ? pdMS_TO_TICKS(DECODE_POLL_MS) : portMAX_DELAY);
+
+        if (speechDriftReset) {
+            // keep the drift estimate, but not the tail of the previous answer
+            speechDriftReset = false;
+            speechDrift.reset();
+            speechResampler.reset();
+
+            // a new session may have negotiated another rate or frame duration
+            if (decoderRate != sessionSampleRate || decoderFrameMs != sessionFrameMs) {
+                decoderRate = sessionSampleRate;
+                decoderFrameMs = sessionFrameMs;
+                opusDecoder.begin(decoderRate, CHANNELS, decoderFrameMs ? decoderFrameMs : 20);
+                Serial.printf("Opus decoder: %u Hz, %u ms frames\n", (unsigned)decoderRate, (unsigned)decoderFrameMs);
+            }
+        }
+        // the I2S clock changes between turns; follow it before decoding into a frame
+        if (speechResampler.inputRate() != decoderRate || speechResampler.outputRate() != outputSampleRate) {
+            speechResampler.begin(decoderRate, outputSampleRate, RESAMPLE_MEDIUM, OPUS_MAX_FRAME_SAMPLES);
+            speechResampler.setRateAdjust(speechDrift.correctionPpm());
+        }
+
+        while (deviceState == SPEAKING) {
+            PcmFrame *frame = speechFrames.acquire(0);
+            if (!frame) {
+                break; // every frame is queued for playback
+            }
+            if (!decodeNextPacket(frame)) {
+                speechFrames.release(frame);
+                break;
+            }
+            speechFrames.submit(frame);
+            notifySpeakerTask(SPEAKER_EVT_FRAME);
+            if (turnTiming.first_decoded_ms == 0) {
+                turnTiming.first_decoded_ms = millis();
+            }
+        }
+    }
+}
+
+// any task -> notifySpeakerTask() -> (wakes audioStreamTask)
+void notifySpeakerTask(uint32_t events) {
+    if (speakerTaskHandle != NULL) {
+        xTaskNotify(speakerTaskHandle, events, eSetBits);
+    }
+}
+
+// audioStreamTask -> audioMixer.mix() -> pitchSpeechFrame()
+// Pitch shift is applied in place when the mixer first takes a speech frame.
+static void pitchSpeechFrame(PcmFrame *frame) {
+    float pitch = currentPitchFactor;
+    if (pitch == 1.0f) {
+        return;
+    }
+    // auth is resizing the engine: play this frame unshifted rather than wait
+    if (xSemaphoreTake(speechPitchMutex, 0) != pdTRUE) {
+        return;
+    }
+    uint32_t rate = outputSampleRate;
+    if (rate <= speechPitchMaxRate) {
+        if (!speechPitch.active() || speechPitch.pitch() != pitch || speechPitch.quality() != speechPitchTier ||
+            speechPitch.sampleRate() != rate) {
+            speechPitch.begin(rate, pitch, speechPitchTier); // within the reservation, so no allocation
+        }
+        speechPitch.process(frame->samples, frame->count);
+        speechPitchDirty = true;
+    }
+    xSemaphoreGive(speechPitchMutex);
+}
+
+// networkTask -> webSocketEvent(auth) -> reserveSpeechPitch()
+// Allocates the pitch engine for the session's tier and the higher of the
+// current and the negotiated output rate, so that pitch, tier or rate changes
+// never allocate in audioStreamTask. Buffers only grow.
+static void reserveSpeechPitch() {
+    if (currentPitchFactor == 1.0f) {
+        return;
+    }
+    uint32_t rate = sessionSampleRate > outputSampleRate ? sessionSampleRate : outputSampleRate;
+    WsolaQuality tier = pitchQuality;
+    xSemaphoreTake(speechPitchMutex, portMAX_DELAY);
+    if (tier != speechPitchTier || rate > speechPitchMaxRate) {
+        rate = rate > speechPitchMaxRate ? rate : speechPitchMaxRate;
+        speechPitchMaxRate = speechPitch.reserve(rate, tier) ? rate : 0;
+        speechPitchTier = tier;
+        speechPitchDirty = false;
+        Serial.printf("Pitch engine reserved for %u Hz, tier %d\n", (unsigned)speechPitchMaxRate, (int)tier);
+    }
+    xSemaphoreGive(speechPitchMutex);
+}
+
+// audioStreamTask -> resetSpeechPitch()
+// The pitch engine delays speech by its latency; drop what it holds when speech
+// is cleared so the tail of one answer does not open the next.
+static void resetSpeechPitch() {
+    if (speechPitchDirty && xSemaphoreTake(speechPitchMutex, 0) == pdTRUE) {
+        speechPitch.reset();
+        speechPitchDirty = false;
+        xSemaphoreGive(speechPitchMutex);
+    }
+}
+
+// setup() -> initAudioOutput()
+void initAudioOutput() {
+    speechPitchMutex = xSemaphoreCreateMutex();
+    speechFrames.begin(PCM_FRAME_POOL_SIZE, OPUS_MAX_FRAME_SAMPLES + DRIFT_HEADROOM_SAMPLES);
+    bhajanFrames.begin(BHAJAN_FRAME_POOL_SIZE, BHAJAN_FRAME_SAMPLES);
+    earconFrames.begin(EARCON_FRAME_POOL_SIZE, MIXER_BLOCK_SAMPLES);
+
+    uint32_t blockMs = MIXER_BLOCK_SAMPLES * 1000 / SAMPLE_RATE;
+    audioMixer.begin(DSP_UNITY_Q15 * blockMs / MIXER_GAIN_RAMP_MS, MIXER_DUCK_HOLD_MS / blockMs);
+
+    AudioMixer::SourceConfig speech;
+    speech.pool = &speechFrames;
+    speech.priority = 2;
+    speech.producer = &decodeTaskHandle;
+    speech.prepare = pitchSpeechFrame;
+    audioMixer.addSource(MIXER_SPEECH, speech);
+
+    AudioMixer::SourceConfig earcon;
+    earcon.pool = &earconFrames;
+    earcon.priority = 1;
+    audioMixer.addSource(MIXER_EARCON, earcon);
+
+    AudioMixer::SourceConfig bhajan;
+    bhajan.pool = &bhajanFrames;
+    bhajan.priority = 0;
+    bhajan.duck_gain_q15 = dspGainFromPercent(MIXER_BHAJAN_DUCK_PERCENT);
+    audioMixer.addSource(MIXER_BHAJAN, bhajan);
+}
+
+// any task -> queueEarcon()
+// Copies a short prompt into earcon frames; returns false if they are all queued.
+bool queueEarcon(const int16_t *pcm, size_t samples) {
+    while (samples > 0) {
+        PcmFrame *frame = earconFrames.acquire(0);
+        if (!frame) {
+            return false;
+        }
+        size_t n = samples < frame->capacity ? samples : frame->capacity;
+        memcpy(frame->samples, pcm, n * sizeof(int16_t));
+        frame->count = n;
+        earconFrames.submit(frame);
+        pcm += n;
+        samples -= n;
+    }
+    notifySpeakerTask(SPEAKER_EVT_FRAME);
+    return true;
+}
+
+// audioStreamTask -> serviceThinkingCue() (before every mix)
+// Starts the cue once an utterance is committed and keeps the earcon frames
+// topped up from flash. The first answer frame crossfades it out; a turn that
+// ends without an answer fades it out like a cancel.
+static void serviceThinkingCue(uint32_t rate) {
+    uint32_t now = millis();
+    if (thinkingCueRequested) {
+        thinkingCueRequested = false;
+        if (thinkingCueEnabled && deviceState == PROCESSING && !thinkingCue.active()) {
+            thinkingCue.start(&EARCON_THINKING, rate);
+            audioMixer.setGain(MIXER_EARCON, DSP_UNITY_Q15);
+            thinkingStartMs = now;
+            thinkingFadeStartMs = 0;
+            thinkingCueStats.played++;
+        }
+    }
+    if (!thinkingCue.active()) {
+        return;
+    }
+
+    if (thinkingFadeStartMs == 0) {
+        if (audioMixer.isPlaying(MIXER_SPEECH)) {
+            // speech ramps in from silence while the cue ramps out
+            audioMixer.setGain(MIXER_EARCON, 0);
+            thinkingFadeStartMs = now ? now : 1;
+            thinkingCueStats.crossfaded++;
+            thinkingCueStats.last_ms = now - thinkingStartMs;
+        } else if ((deviceState != PROCESSING && deviceState != SPEAKING) ||
+                   now - thinkingStartMs > THINKING_CUE_MAX_MS) {
+            thinkingCue.stop();
+            audioMixer.fadeOut(MIXER_EARCON, samplesAtRate(CANCEL_FADE_SAMPLES, rate));
+            return;
+        }
+    } else if (now - thinkingFadeStartMs >= THINKING_CUE_CROSSFADE_MS) {
+        thinkingCue.stop();
+        audioMixer.clear(MIXER_EARCON);
+        audioMixer.setGain(MIXER_EARCON, DSP_UNITY_Q15);
+        return;
+    }
+
+    while (PcmFrame *frame = earconFrames.acquire(0)) {
+        frame->count = thinkingCue.read(frame->samples, frame->capacity);
+        earconFrames.submit(frame);
+    }
+}
+
+// audioStreamTask -> audioMixer.mix() -> i2s.write()
+// Sole owner of the output port. Sleeps until notifySpeakerTask() while nothing
+// plays; while a source plays, the blocking i2s.write() paces the loop.
+void audioStreamTask(void *parameter) {
+    Serial.println("Starting I2S stream pipeline...");
     
-    queue.begin();
+    pinMode(I2S_SD_OUT, OUTPUT);
+    digitalWrite(I2S_SD_OUT, LOW);
+    AmpGateConfig ampConfig;
+    ampConfig.idle_hold_ms = ampIdleHoldMs;
+    ampGate.begin(ampConfig, millis());
 
     auto config = i2s.defaultConfig(TX_MODE);
     config.bits_per_sample = BITS_PER_SAMPLE;
-    config.sample_rate = SAMPLE_RATE;
     config.channels = CHANNELS;
     config.pin_bck = I2S_BCK_OUT;
     config.pin_ws = I2S_WS_OUT;
     config.pin_data = I2S_DATA_OUT;
     config.port_no = I2S_PORT_OUT;
-
-    config.copyFrom(info);  
+    // a short DMA ring bounds how much audio is still queued after a cancel
+    DmaTunerConfig tuning;
+    tuning.min_buffers = OUTPUT_DMA_MIN_BUFFERS;
+    tuning.max_buffers = OUTPUT_DMA_MAX_BUFFERS;
+    tuning.min_frames = OUTPUT_DMA_MIN_FRAMES;
+    tuning.max_frames = OUTPUT_DMA_MAX_FRAMES;
+    tuning.frame_step = OUTPUT_DMA_MIN_FRAMES / 2;
+    tuning.max_total_frames = OUTPUT_DMA_MAX_TOTAL_FRAMES;
+    tuning.shrink_after_ms = DMA_SHRINK_AFTER_MS;
+    outputDma.begin(tuning, loadDmaSettings("out_dma", OUTPUT_DMA_BUFFERS, OUTPUT_DMA_FRAMES));
+    DmaSettings dma = outputDma.settings();
+    uint32_t rate = sessionSampleRate;
+    configureOutput(config, rate, dma);
     i2s.begin(config);  
 
-    // Initialize both volume streams once
-    auto vcfg = volume.defaultConfig();
-    vcfg.copyFrom(info);
-    vcfg.allow_boost = true;
-    volume.begin(vcfg);
-    
-    auto vcfgPitch = volumePitch.defaultConfig();
-    vcfgPitch.copyFrom(info);
-    vcfgPitch.allow_boost = true;
-    volumePitch.begin(vcfgPitch);
+    alignas(DSP_ALIGN_BYTES) static int16_t mixBlock[MIXER_MAX_BLOCK_SAMPLES];
+    static const int16_t silence[MIXER_MAX_BLOCK_SAMPLES] = {};
+    static_assert(AMP_PREROLL_SAMPLES * 2 <= MIXER_MAX_BLOCK_SAMPLES, "pre-roll is written from one silent block");
+    size_t blockSamples = samplesAtRate(MIXER_BLOCK_SAMPLES, rate); // 10 ms
+    bool playing = false;
+    bool cancelling = false;
+    size_t cancelWritten = 0; // samples written since the cancel, fade block included
+    bool streaming = false;   // the previous iteration wrote a block
+    uint32_t lastWriteUs = 0;
+    uint32_t dmaUnderruns = 0;
 
     while (1) {
-        if ( i2sOutputFlushScheduled) {
+        uint32_t events = 0;
+        if (!playing && !cancelling) {
+            // sleep until an event, or until the amplifier's idle hold runs out
+            uint32_t untilOff = ampGate.msUntilOff(millis());
+            xTaskNotifyWait(0, UINT32_MAX, &events, untilOff == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(untilOff) + 1);
+            speakerLoad.wakeups++;
+            // nothing is queued, so the ring can be resized and the clock
+            // changed without a gap in the audio; the rate waits for the turn to end
+            bool dmaChanged = takeDmaChange(outputDma, outputDmaRequest, dma);
+            bool rateChanged = sessionSampleRate != rate && deviceState != SPEAKING;
+            if (dmaChanged || rateChanged) {
+                dma = outputDma.settings();
+                rate = rateChanged ? sessionSampleRate : rate;
+                configureOutput(config, rate, dma);
+                blockSamples = samplesAtRate(MIXER_BLOCK_SAMPLES, rate);
+                i2s.end();
+                i2s.begin(config);
+                if (dmaChanged) {
+                    saveDmaSettings("out_dma", dma);
+                }
+                Serial.printf("Output: %u Hz, DMA ring %u x %u frames\n", (unsigned)rate, dma.buffers,
+                              (unsigned)config.buffer_size);
+            }
+        } else {
+            // just consume pending events, frames are picked up by mix() anyway
+            xTaskNotifyWait(0, UINT32_MAX, &events, 0);
+        }
+
+        if (events & SPEAKER_EVT_CANCEL) {
+            // the next block fades speech out and drops everything queued behind it
+            audioMixer.fadeOut(MIXER_SPEECH, samplesAtRate(CANCEL_FADE_SAMPLES, rate));
+            cancelling = true;
+            cancelWritten = 0;
+        }
+        // a pending fade clears speech itself once it has been mixed
+        bool fading = audioMixer.isFading(MIXER_SPEECH);
+        if ( i2sOutputFlushScheduled && !fading) {
             i2sOutputFlushScheduled = false;
             i2s.flush();
-            volume.flush();
-            volumePitch.flush();
-            queue.flush();
+            audioMixer.clear(MIXER_SPEECH);
+            resetSpeechPitch();
+        }
+        if (!fading && (!webSocket.isConnected() || deviceState != SPEAKING)) {
+            //always hand speech frames back, otherwise the decode task can stuck
+            audioMixer.clear(MIXER_SPEECH);
+            resetSpeechPitch();
         }
 
-        if (webSocket.isConnected() && deviceState == SPEAKING) {
-            if (currentPitchFactor != 1.0f) {
-                pitchCopier.copy();
-            } else {
-                copier.copy();
+        serviceThinkingCue(rate);
+
+        uint32_t start = micros();
+        // boost happens in the int32 domain of the protection stage, never in the mixer
+        int32_t volume = dspGainFromPercent(currentVolume);
+        audioMixer.setMasterGain(volume < DSP_UNITY_Q15 ? volume : DSP_UNITY_Q15);
+        speakerProtection.setGain(volume > DSP_UNITY_Q15 ? volume : DSP_UNITY_Q15);
+        playing = audioMixer.mix(mixBlock, blockSamples);
+
+        // an answer on its way warms the amp up before its first frame is decoded
+        ampGate.setIdleHoldMs(ampIdleHoldMs);
+        AmpGate::Action amp = ampGate.update(millis(), deviceState == SPEAKING || cancelling, playing);
+        if (amp == AmpGate::AMP_ENABLE) {
+            digitalWrite(I2S_SD_OUT, HIGH);
+            i2s.write((const uint8_t *)silence, samplesAtRate(AMP_PREROLL_SAMPLES, rate) * sizeof(int16_t));
+        } else if (amp == AmpGate::AMP_DISABLE) {
+            digitalWrite(I2S_SD_OUT, LOW);
+        }
+
+        if (!playing && !cancelling) {
+            streaming = false;
+            continue;
+        }
+        uint32_t protectionStart = micros();
+        speakerLevels.publish(speakerProtection.process(mixBlock, blockSamples));
+        speakerProtectionTiming.add(micros() - protectionStart);
+        // while cancelling with nothing else playing, silent blocks push the fade out of the DMA ring
+        uint32_t us = micros() - start;
+        mixerTiming.add(us);
+        speakerLoad.busy_us += us;
+        if (us > MIXER_CPU_BUDGET_US) {
+            speakerLoad.over_budget++;
+        }
+
+        // write() returns as soon as a DMA buffer is free, leaving the ring
+        // full; a longer gap than the ring holds means it ran dry
+        uint32_t writeStart = micros();
+        if (streaming && writeStart - lastWriteUs > dma.totalFrames() * 1000000ULL / SAMPLE_RATE) {
+            dmaUnderruns++;
+        }
+        i2s.write((const uint8_t *)mixBlock, blockSamples * sizeof(int16_t));
+        lastWriteUs = micros();
+        streaming = true;
+        outputDma.update(millis(), dmaUnderruns, true);
+
+        if (audioMixer.lastBlockSamples(MIXER_SPEECH) > 0) {
+            uint32_t now = millis();
+            if (turnTiming.first_write_ms == 0) {
+                turnTiming.first_write_ms = now;
             }
+            turnTiming.drained_ms = now;
+            turnTiming.played_samples += audioMixer.lastBlockSamples(MIXER_SPEECH) * SAMPLE_RATE / rate;
         }
-        else {
-            //we should always read from audioBuffer, otherwise writing thread can stuck
-            queue.read();
+
+        if (cancelling) {
+            cancelWritten += MIXER_BLOCK_SAMPLES;
+            // the write only returns once the ring has room, so the fade has
+            // played out when a full ring (and the limiter's delay) was written behind it
+            if (cancelWritten >= MIXER_BLOCK_SAMPLES + SPEAKER_LOOKAHEAD_SAMPLES + dma.totalFrames()) {
+                cancelling = false;
+                bargeInTiming.add(micros() - cancelStartUs);
+                if (!playing) {
+                    i2s_zero_dma_buffer(I2S_PORT_OUT);
+                }
+                speechCancelActive = false;
+            }
         }
-        vTaskDelay(1); 
     }
 }
 
 
-class WebsocketStream : public Print {
-public:
-    // micTask -> micToWsCopier.copyBytes() -> wsStream.write()
-    virtual size_t write(uint8_t b) override {
-        if (!webSocket.isConnected() || deviceState != LISTENING) {
-            return 1;
+SpscRing micRing;         // producer: micTask (PCM) or micEncodeTask (Opus), consumer: networkTask
+MicFrameReader micReader; // networkTask, PCM frames out of micRing
+MicUplinkStats micUplink; // written by micTask and micEncodeTask (drops, encode) and networkTask (the rest)
+volatile uint8_t micFrameMs = MIC_FRAME_MS;
+I2SStream i2sInput; //access from micTask only
+volatile bool i2sInputFlushScheduled = false;
+static uint8_t micScratch[MIC_READ_BYTES]; // discarded reads while micRing is full
+volatile bool micOpusEnabled = false;
+volatile uint32_t micOpusBitrate = MIC_OPUS_BITRATE;
+volatile uint8_t micOpusComplexity = MIC_OPUS_COMPLEXITY;
+static PcmFramePool micOpusFrames;             // producer: micTask, consumer: micEncodeTask
+static volatile bool micEncoderResetPending = false; // set by micTask at the start of each turn
+static OpusFrameEncoder micEncoder;            //access from micEncodeTask only
+static uint8_t micRecord[sizeof(MicPacketHeader) + MIC_OPUS_MAX_PACKET]; // micEncodeTask
+static uint8_t micPacket[MIC_OPUS_MAX_PACKET]; // networkTask
+static MicPacketHeader micPending;             // networkTask, header read ahead of its packet
+static bool micHavePending = false;
+
+#ifdef DEV_MODE
+constexpr bool MIC_UPLINK_TLS = false;
+#else
+constexpr bool MIC_UPLINK_TLS = true;
+#endif
+
+static void countMicMessage(size_t len, uint8_t frameMs) {
+    micUplink.messages++;
+    micUplink.bytes += len;
+    micUplink.wire_bytes += wsUplinkWireBytes(len, MIC_UPLINK_TLS);
+    micUplink.audio_ms += frameMs;
+}
+
+// networkTask -> sendMicAudio() -> sendMicPackets() (wsMutex held)
+// One message per Opus packet. A packet is small, so it is copied out of the
+// ring rather than sent from it, which also takes care of the wrap point.
+static void sendMicPackets() {
+    while (true) {
+        if (!micHavePending) {
+            if (micRing.available() < sizeof(micPending)) {
+                return;
+            }
+            micRing.read((uint8_t *)&micPending, sizeof(micPending));
+            micHavePending = true;
         }
-        
-        xSemaphoreTake(wsMutex, portMAX_DELAY);
-        webSocket.sendBIN(&b, 1);
-        xSemaphoreGive(wsMutex);
-        return 1;
+        if (micPending.sync != MIC_PACKET_SYNC || micPending.len > MIC_OPUS_MAX_PACKET) {
+            // micRing.write() commits header and packet together, so a clear() only
+            // lands between records; anything else here is corrupt: drop it and resync
+            micRing.clear();
+            micHavePending = false;
+            return;
+        }
+        if (micRing.available() < micPending.len) {
+            return;
+        }
+        micRing.read(micPacket, micPending.len);
+        micHavePending = false;
+        webSocket.sendBIN(micPacket, micPending.len);
+        countMicMessage(micPending.len, micPending.frame_ms);
+        micUplink.latency.add(micros() - micPending.captured_us);
     }
-    
-    // micTask -> micToWsCopier.copyBytes() -> wsStream.write()
-    virtual size_t write(const uint8_t *buffer, size_t size) override {
-        if (size == 0 || !webSocket.isConnected() || deviceState != LISTENING) {
-            return size;
+}
+
+// networkTask -> sendMicAudio() -> sendMicFrames() (wsMutex held)
+// One message per whole PCM frame, sent straight out of micRing unless it
+// straddles the wrap point; a partial frame waits for the next call.
+static void sendMicFrames() {
+    uint8_t frameMs = micFrameMs;
+    micReader.setFrameBytes(MIC_SAMPLE_RATE * frameMs / 1000 * sizeof(int16_t));
+    const uint8_t *frame;
+    while ((frame = micReader.peekFrame()) != nullptr) {
+        webSocket.sendBIN((uint8_t *)frame, micReader.frameBytes());
+        micReader.consumeFrame();
+        countMicMessage(micReader.frameBytes(), frameMs);
+    }
+}
+
+// networkTask -> sendMicAudio() (wsMutex held)
+static void sendMicAudio() {
+    if (deviceState != LISTENING || !webSocket.isConnected()) {
+        micRing.clear();
+        micReader.reset();
+        micHavePending = false;
+        return;
+    }
+    size_t fill = micRing.available();
+    if (fill > micUplink.max_fill_bytes) {
+        micUplink.max_fill_bytes = fill;
+    }
+    uint32_t start = micros();
+    uint32_t sent = micUplink.messages;
+    if (micOpusEnabled) {
+        sendMicPackets();
+    } else {
+        sendMicFrames();
+    }
+    if (micUplink.messages != sent) {
+        micUplink.send.add(micros() - start);
+    }
+}
+
+// micTask -> captureMicFrame()
+// Reads one frame of micFrameMs into micOpusFrames for micEncodeTask. The
+// blocking read paces the loop as it does for PCM.
+static void captureMicFrame() {
+    uint8_t frameMs = micFrameMs;
+    size_t bytes = MIC_SAMPLE_RATE * frameMs / 1000 * sizeof(int16_t);
+    PcmFrame *frame = micOpusFrames.acquire(0);
+    if (!frame) {
+        // the encoder is MIC_OPUS_FRAME_POOL_SIZE frames behind, drop this one
+        for (size_t done = 0; done < bytes; done += sizeof(micScratch)) {
+            i2sInput.readBytes(micScratch, sizeof(micScratch));
         }
-        
-        xSemaphoreTake(wsMutex, portMAX_DELAY);
-        webSocket.sendBIN(buffer, size);
-        xSemaphoreGive(wsMutex);
-        return size;
+        micUplink.ring_drops++;
+        return;
+    }
+    size_t got = i2sInput.readBytes((uint8_t *)frame->samples, bytes) & ~(size_t)1;
+    uint32_t readUs = micros();
+    if (got < bytes) {
+        micOpusFrames.release(frame); // flushed or stopped mid-frame
+        return;
     }
-};
+    frame->count = bytes / sizeof(int16_t);
+    frame->timestamp_us = readUs - frameMs * 1000;
+    micLevels.publish(dspLevels(frame->samples, frame->count));
+    micOpusFrames.submit(frame);
+}
 
-WebsocketStream wsStream; //guard with wsMutex
-I2SStream i2sInput; //access from micTask only
-StreamCopy micToWsCopier(wsStream, i2sInput);
-volatile bool i2sInputFlushScheduled = false;
-const int MIC_COPY_SIZE = 64;
+// micEncodeTask -> encodeMicFrame()
+// Encodes one captured frame and queues the packet for networkTask.
+static void encodeMicFrame(const PcmFrame *frame) {
+    if (micEncoderResetPending) {
+        micEncoderResetPending = false;
+        micEncoder.reset(); // each turn starts a new Opus stream
+    }
+    if (deviceState != LISTENING || !micOpusEnabled) {
+        return; // the turn ended while the frame was queued
+    }
+    uint8_t frameMs = frame->count * 1000 / MIC_SAMPLE_RATE;
+    if (micEncoder.frameSamples() != frame->count &&
+        !micEncoder.begin(MIC_SAMPLE_RATE, frameMs, micOpusBitrate, micOpusComplexity)) {
+        return;
+    }
+    if (micEncoder.bitrate() != micOpusBitrate) {
+        micEncoder.setBitrate(micOpusBitrate);
+    }
+    if (micEncoder.complexity() != micOpusComplexity) {
+        micEncoder.setComplexity(micOpusComplexity);
+    }
+
+    MicPacketHeader header;
+    uint32_t startUs = micros();
+    size_t len = micEncoder.encode(frame->samples, micRecord + sizeof(header), MIC_OPUS_MAX_PACKET);
+    micUplink.encode.add(micros() - startUs);
+    if (len == 0) {
+        return;
+    }
+    header.sync = MIC_PACKET_SYNC;
+    header.len = (uint16_t)len;
+    header.frame_ms = frameMs;
+    header.captured_us = frame->timestamp_us;
+    memcpy(micRecord, &header, sizeof(header));
+    if (micRing.space() < sizeof(header) + len) {
+        micUplink.ring_drops++; // the network is MIC_RING_BYTES behind
+        return;
+    }
+    micRing.write(micRecord, sizeof(header) + len); // one commit: header and packet appear together
+}
+
+// Created by startMicEncoder(); runs below micTask so encoding never delays a read.
+void micEncodeTask(void *parameter) {
+    while (1) {
+        PcmFrame *frame = micOpusFrames.receive(portMAX_DELAY);
+        if (frame) {
+            encodeMicFrame(frame);
+            micOpusFrames.release(frame);
+        }
+    }
+}
+
+// networkTask -> webSocketEvent(auth) -> startMicEncoder()
+// The encoder task and its frames are only allocated once a server asks for
+// Opus, and then kept for later sessions.
+static bool startMicEncoder() {
+    if (micEncodeTaskHandle) {
+        return true;
+    }
+    if (!micOpusFrames.begin(MIC_OPUS_FRAME_POOL_SIZE, MIC_MAX_FRAME_SAMPLES)) {
+        return false;
+    }
+    if (xTaskCreatePinnedToCore(micEncodeTask, "Mic Encode Task", MIC_ENCODER_STACK_BYTES, NULL, 3,
+                                &micEncodeTaskHandle, 1) != pdPASS) {
+        micEncodeTaskHandle = NULL;
+        micOpusFrames.end();
+        return false;
+    }
+    return true;
+}
 
 void micTask(void *parameter) {
     // Configure and start I2S input stream.
     auto i2sConfig = i2sInput.defaultConfig(RX_MODE);
     i2sConfig.bits_per_sample = BITS_PER_SAMPLE;
-    i2sConfig.sample_rate = 16000;
+    i2sConfig.sample_rate = MIC_SAMPLE_RATE;
     i2sConfig.channels = CHANNELS;
     i2sConfig.i2s_format = I2S_LEFT_JUSTIFIED_FORMAT;
     i2sConfig.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;
@@ -232,9 +1168,23 @@ void micTask(void *parameter) {
     i2sConfig.pin_ws  = I2S_WS;
     i2sConfig.pin_data = I2S_SD;
     i2sConfig.port_no = I2S_PORT_IN;
+
+    DmaTunerConfig tuning;
+    tuning.min_buffers = MIC_DMA_MIN_BUFFERS;
+    tuning.max_buffers = MIC_DMA_MAX_BUFFERS;
+    tuning.min_frames = MIC_DMA_MIN_FRAMES;
+    tuning.max_frames = MIC_DMA_MAX_FRAMES;
+    tuning.frame_step = MIC_DMA_MIN_FRAMES / 2;
+    tuning.shrink_after_ms = DMA_SHRINK_AFTER_MS;
+    micDma.begin(tuning, loadDmaSettings("mic_dma", MIC_DMA_BUFFERS, MIC_DMA_FRAMES));
+    DmaSettings dma = micDma.settings();
+    i2sConfig.buffer_count = dma.buffers;
+    i2sConfig.buffer_size = dma.frames;
     i2sInput.begin(i2sConfig);
 
-    micToWsCopier.setDelayOnNoData(0);
+    bool capturing = false;  // the previous iteration read from the ring
+    uint32_t lastReadUs = 0;
+    uint32_t dmaOverruns = 0;
 
     while (1) {
         if (i2sInputFlushScheduled) {
@@ -243,12 +1193,49 @@ void micTask(void *parameter) {
         }
 
         if (deviceState == LISTENING && webSocket.isConnected()) {
-            // Use smaller chunk size to avoid blocking too long
-            micToWsCopier.copyBytes(MIC_COPY_SIZE);
-            
-            // Yield more frequently
-            vTaskDelay(1);
+            // the DMA ring overflows when it is not read for longer than it holds
+            uint32_t readStart = micros();
+            if (capturing && readStart - lastReadUs > dma.totalFrames() * 1000000ULL / i2sConfig.sample_rate) {
+                dmaOverruns++;
+            }
+            lastReadUs = readStart;
+            if (!capturing && micOpusEnabled) {
+                micOpusFrames.flush(); // frames left from the last turn
+                micEncoderResetPending = true;
+            }
+            capturing = true;
+
+            if (micOpusEnabled) {
+                captureMicFrame();
+            } else {
+                // Read straight into free space in micRing; the blocking read paces
+                // the loop, and networkTask sends each frame once it is complete
+                size_t len;
+                uint8_t *dst = micRing.reserve(len);
+                len = (len < MIC_READ_BYTES ? len : MIC_READ_BYTES) & ~(size_t)1;
+                if (len == 0) {
+                    // the network is MIC_RING_BYTES behind, drop this block
+                    i2sInput.readBytes(micScratch, sizeof(micScratch));
+                    micUplink.ring_drops++;
+                } else {
+                    size_t got = i2sInput.readBytes(dst, len) & ~(size_t)1;
+                    micLevels.publish(dspLevels((const int16_t *)dst, got / 2));
+                    micRing.commit(got);
+                }
+            }
+            micDma.update(millis(), dmaOverruns, true);
         } else {
+            capturing = false;
+            // not streaming, so the ring can be resized now
+            if (takeDmaChange(micDma, micDmaRequest, dma)) {
+                dma = micDma.settings();
+                i2sConfig.buffer_count = dma.buffers;
+                i2sConfig.buffer_size = dma.frames;
+                i2sInput.end();
+                i2sInput.begin(i2sConfig);
+                saveDmaSettings("mic_dma", dma);
+                Serial.printf("Mic DMA ring: %u x %u frames\n", dma.buffers, dma.frames);
+            }
             vTaskDelay(10);
         }
     }
@@ -265,6 +1252,7 @@ void webSocketEvent(WStype_t type, const uint8_t *payload, size_t length)
     case WStype_DISCONNECTED:
         Serial.printf("[WSc] Disconnected!\n");
         deviceState = IDLE;
+        notifySpeakerTask(SPEAKER_EVT_STATE);
         break;
     case WStype_CONNECTED:
         // payload contains the server url (if provided by the library)
@@ -295,23 +1283,48 @@ void webSocketEvent(WStype_t type, const uint8_t *payload, size_t length)
         if (strcmp((char*)type.c_str(), "auth") == 0) {
             currentVolume = doc["volume_control"].as<int>();
             currentPitchFactor = doc["pitch_factor"].as<float>();
+            const char *pitchTier = doc["pitch_quality"] | "medium";
+            pitchQuality = strcmp(pitchTier, "low") == 0    ? WSOLA_LOW
+                           : strcmp(pitchTier, "high") == 0 ? WSOLA_HIGH
+                                                            : PITCH_QUALITY_DEFAULT;
+            audioSeqEnabled = doc["audio_seq"] | false;
+            opusFecEnabled = doc["opus_fec"] | false;
+            prebufferMs = doc["prebuffer_ms"] | JITTER_PREBUFFER_MS;
+            dmaAutoTune = doc["dma_autotune"] | true;
+            ampIdleHoldMs = doc["amp_hold_ms"] | AMP_IDLE_HOLD_MS;
+            thinkingCueEnabled = doc["thinking_cue"] | true;
+            {
+                bool opus = strcmp(doc["mic_codec"] | "pcm16", "opus") == 0;
+                if (opus && !startMicEncoder()) {
+                    Serial.println("Mic encoder not started, sending PCM");
+                    opus = false;
+                }
+                micOpusEnabled = opus;
+            }
+            {
+                // read signed so a negative or oversized value clamps instead of wrapping
+                int32_t bitrate = doc["mic_bitrate"] | (int32_t)MIC_OPUS_BITRATE;
+                int complexity = doc["mic_complexity"] | (int)MIC_OPUS_COMPLEXITY;
+                micOpusBitrate = constrain(bitrate, (int32_t)MIC_OPUS_MIN_BITRATE, (int32_t)MIC_OPUS_MAX_BITRATE);
+                micOpusComplexity = constrain(complexity, 0, (int)MIC_OPUS_MAX_COMPLEXITY);
+                uint8_t frameMs = doc["mic_frame_ms"] | MIC_FRAME_MS;
+                micFrameMs = (frameMs == 10 || frameMs == 20 || frameMs == 40) ? frameMs : MIC_FRAME_MS;
+            }
+            applySessionFormat(doc["sample_rate"] | SAMPLE_RATE, (uint16_t)(doc["frame_ms"] | 0));
+            reserveSpeechPitch();
+            if (doc["output_dma"].is<JsonObject>()) {
+                outputDmaRequest = packDmaSettings(doc["output_dma"]["buffers"] | OUTPUT_DMA_BUFFERS,
+                                                   doc["output_dma"]["frames"] | OUTPUT_DMA_FRAMES);
+                notifySpeakerTask(SPEAKER_EVT_STATE);
+            }
+            if (doc["mic_dma"].is<JsonObject>()) {
+                micDmaRequest = packDmaSettings(doc["mic_dma"]["buffers"] | MIC_DMA_BUFFERS,
+                                                doc["mic_dma"]["frames"] | MIC_DMA_FRAMES);
+            }
 
             bool is_ota = doc["is_ota"].as<bool>();
             bool is_reset = doc["is_reset"].as<bool>();
 
-            // Update volumes on both streams
-            volume.setVolume(currentVolume / 100.0f);
-            volumePitch.setVolume(currentVolume / 100.0f);
-            
-            // Only initialize pitch shift if needed
-            if (currentPitchFactor != 1.0f) {
-                auto pcfg = pitchShift.defaultConfig();
-                pcfg.copyFrom(info);
-                pcfg.pitch_shift = currentPitchFactor;
-                pcfg.buffer_size = 512;
-                pitchShift.begin(pcfg);
-            }
-
             if (is_ota) {
                 Serial.println("OTA update received");
                 setOTAStatusInNVS(OTA_IN_PROGRESS);
@@ -335,20 +1348,29 @@ void webSocketEvent(WStype_t type, const uint8_t *payload, size_t length)
 
                 // Check if volume_control is included in the message
                 if (doc.containsKey("volume_control")) {
-                    int newVolume = doc["volume_control"].as<int>();
-                    volume.setVolume(newVolume / 100.0f);
+                    currentVolume = doc["volume_control"].as<int>();
                 }
 
                 scheduleListeningRestart = true;
                 scheduledTime = millis() + 1000; // 1 second delay
             } else if (strcmp((char*)msg.c_str(), "AUDIO.COMMITTED") == 0) {
                 deviceState = PROCESSING; 
+                // fill the wait for the answer locally
+                thinkingCueRequested = true;
+                notifySpeakerTask(SPEAKER_EVT_STATE);
             } else if (strcmp((char*)msg.c_str(), "RESPONSE.CREATED") == 0) {
                 Serial.println("Received RESPONSE.CREATED, transitioning to speaking");
                 // reset diagnostics for this speaking turn
                 framesReceivedThisTurn = 0;
                 lastDecodedBytes = 0;
-                lastResponseCreatedTime = millis();
+                turnTiming.first_rx_ms = 0;
+                turnTiming.first_decoded_ms = 0;
+                turnTiming.first_write_ms = 0;
+                turnTiming.drained_ms = 0;
+                turnTiming.played_samples = 0;
+                turnTiming.created_ms = millis();
+                resetJitterBuffer();
+                rxSequence = 0;
                 transitionToSpeaking();
             } else if (strcmp((char*)msg.c_str(), "SESSION.END") == 0) {
                 Serial.println("Received SESSION.END, going to sleep");
@@ -361,18 +1383,28 @@ void webSocketEvent(WStype_t type, const uint8_t *payload, size_t length)
             const char* command = doc["command"];
             int bhajanId = doc["bhajan_id"] | -1; // Default to -1 if not present
             const char* url = doc["url"]; // Can be null
+            uint32_t sampleRate = doc["sample_rate"] | 0; // 0 = SAMPLE_RATE
+            bool hasSpeed = applyBhajanSpeed(doc);        // playback tempo, may come with any command
 
             if (command) {
                 Serial.printf("Received bhajan command: %s, for bhajan_id: %d\n", command, bhajanId);
-                handleBhajanCommand(command, bhajanId, url);
+                handleBhajanCommand(command, bhajanId, url, sampleRate);
+            } else if (hasSpeed) {
+                sendBhajanStatusUpdate();
             } else {
                 Serial.println("Bhajan command message received without a 'command' field.");
             }
+        } else if (strcmp((char*)type.c_str(), "bhajan_control") == 0) {
+            // only its "speed" is taken here; actions still come as bhajan_command
+            if (applyBhajanSpeed(doc)) {
+                sendBhajanStatusUpdate();
+            }
         }
     }
         break;
     case WStype_BIN:
     {
+        uint32_t dispatchStart = micros();
         if (scheduleListeningRestart || deviceState != SPEAKING) {
             Serial.println("Skipping audio data due to touch interrupt.");
             break;
@@ -384,21 +1416,53 @@ void webSocketEvent(WStype_t type, const uint8_t *payload, size_t length)
             break;
         }
 
-        // Otherwise process the audio data normally
+        // Queue the packet; audioDecodeTask decodes it at playout pace
         {
-            xSemaphoreTake(wsMutex, portMAX_DELAY); // ensure decoder internal state access is serialized
-            size_t processed = opusDecoder.write(payload, length);
-            xSemaphoreGive(wsMutex);
+            // With audio_seq negotiated every packet starts with a big-endian sequence number,
+            // which lets the decoder spot lost frames. Otherwise number packets on arrival.
+            uint16_t seq;
+            if (audioSeqEnabled) {
+                if (length <= 2) {
+                    Serial.println("Skipping audio: packet too short for sequence header");
+                    break;
+                }
+                seq = ((uint16_t)payload[0] << 8) | payload[1];
+                payload += 2;
+                length -= 2;
+            } else {
+                seq = rxSequence++;
+            }
 
-            // Diagnostics logging: increment per-turn counters and report
-            framesReceivedThisTurn++;
-            lastDecodedBytes = processed;
+            // one message may carry several Opus frames; they are decoded in one call,
+            // so the whole packet has to fit a speech frame and a jitter buffer slot
+            int frames = opus_packet_get_nb_frames(payload, length);
+            int samples = opus_packet_get_nb_samples(payload, length, sessionSampleRate);
+            if (frames <= 0 || samples <= 0) {
+                Serial.println("Skipping audio: invalid Opus packet");
+                downlinkStats.rejected++;
+                break;
+            }
+            if ((size_t)samples > OPUS_MAX_FRAME_SAMPLES || length > OPUS_MAX_PACKET_BYTES) {
+                Serial.printf("Skipping audio: packet of %d samples, %u bytes is too large\n", samples, (unsigned)length);
+                downlinkStats.rejected++;
+                break;
+            }
+            uint16_t durationMs = (uint16_t)(samples * 1000 / sessionSampleRate);
 
-            Serial.printf("[WSc] binary frame received len=%u decoded=%u framesThisTurn=%d\n", (unsigned)length, (unsigned)processed, framesReceivedThisTurn);
+            queueOpusPacket(seq, payload, length, durationMs);
+            downlinkStats.messages++;
+            downlinkStats.frames += frames;
+            downlinkStats.bytes += length;
+            downlinkStats.audio_ms += durationMs;
+            downlinkStats.dispatch.add(micros() - dispatchStart);
 
-            if (processed == 0) {
-                Serial.println("Warning: decoder returned 0 processed bytes for this frame");
+            // Diagnostics logging: increment per-turn counters and report
+            framesReceivedThisTurn++;
+            if (turnTiming.first_rx_ms == 0) {
+                turnTiming.first_rx_ms = millis();
             }
+
+            Serial.printf("[WSc] binary frame received len=%u seq=%u t=%lu depth=%ums framesThisTurn=%d\n", (unsigned)length, (unsigned)seq, millis(), (unsigned)jitterBuffer.depthMs(), framesReceivedThisTurn);
         }
         break;
       }
@@ -427,7 +1491,27 @@ void webSocketEvent(WStype_t type, const uint8_t *payload, size_t length)
 // wifiTask -> WIFIMANAGER::loop() -> WIFIMANAGER::tryConnect() -> connectCb() -> websocketSetup()
 void websocketSetup(const String& server_domain, int port, const String& path)
 {
-    const String headers = "Authorization: Bearer " + String(authTokenGlobal);
+    // the server picks the downlink format from these and confirms it in the auth message
+    // (frame durations in order of preference)
+    String rates;
+    for (uint32_t rate : SUPPORTED_SAMPLE_RATES) {
+        if (rates.length()) {
+            rates += ",";
+        }
+        rates += String(rate);
+    }
+    String frameMs;
+    for (uint16_t ms : PREFERRED_FRAME_MS) {
+        if (frameMs.length()) {
+            frameMs += ",";
+        }
+        frameMs += String(ms);
+    }
+    const String headers = "Authorization: Bearer " + String(authTokenGlobal) +
+                           "\r\nX-Audio-Sample-Rates: " + rates +
+                           "\r\nX-Audio-Frame-Ms: " + frameMs +
+                           "\r\nX-Mic-Codecs: pcm16,opus" +
+                           "\r\nX-Mic-Frame-Ms: 10,20,40";
 
     xSemaphoreTake(wsMutex, portMAX_DELAY);
 
@@ -473,13 +1557,24 @@ void websocketSetup(const String& server_domain, int port, const String& path)
 void networkTask(void *parameter) {
     while (1) {
         xSemaphoreTake(wsMutex, portMAX_DELAY);
+        uint32_t holdStart = micros();
+
+        if (interruptPending) {
+            interruptPending = false;
+            sendInterrupt();
+        }
+        sendMicAudio();
 
         // Check to see if a transition to listening mode is scheduled.
         if (scheduleListeningRestart && millis() >= scheduledTime) {
             transitionToListening();
         }
 
+        uint32_t loopStart = micros();
         webSocket.loop();
+        uint32_t holdEnd = micros();
+        networkLoopTiming.add(holdEnd - loopStart);
+        wsHoldTiming.add(holdEnd - holdStart);
         xSemaphoreGive(wsMutex);
 
         vTaskDelay(1);
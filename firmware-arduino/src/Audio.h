@@ -4,13 +4,33 @@
 #include "AudioTools.h"
 #include "AudioTools/AudioCodecs/CodecOpus.h"
 #include "Config.h"
+#include "OpusFrameDecoder.h"
+#include "SpeechPlayout.h"
+#include "OpusFrameEncoder.h"
+#include "MicFrameReader.h"
+#include "PcmFramePool.h"
+#include "AudioDsp.h"
+#include "AudioMixer.h"
+#include "DmaTuner.h"
+#include "SpscRing.h"
+#include "DriftEstimator.h"
+#include "Resampler.h"
+#include "SpeakerProtection.h"
+#include "AmpGate.h"
+#include "Earcon.h"
+#include "LevelMeter.h"
+#include "Wsola.h"
 
 extern SemaphoreHandle_t wsMutex;
+extern SemaphoreHandle_t jitterMutex;
+extern SemaphoreHandle_t jitterSpace;
 extern WebSocketsClient webSocket;
 
 extern TaskHandle_t speakerTaskHandle;
 extern TaskHandle_t micTaskHandle;
+extern TaskHandle_t micEncodeTaskHandle;
 extern TaskHandle_t networkTaskHandle;
+extern TaskHandle_t decodeTaskHandle;
 
 extern volatile bool scheduleListeningRestart;
 extern unsigned long scheduledTime;
@@ -18,29 +38,277 @@ extern unsigned long speakingStartTime;
 
 extern int currentVolume;
 extern float currentPitchFactor;
+// WSOLA tier for the pitch effect on speech; see Wsola.h for the cost of each
+constexpr WsolaQuality PITCH_QUALITY_DEFAULT = WSOLA_MEDIUM;
+extern volatile WsolaQuality pitchQuality;  // from the auth message
 extern const int CHANNELS;         // Mono
 extern const int BITS_PER_SAMPLE; // 16-bit audio
 
 // AUDIO OUTPUT
-constexpr size_t AUDIO_BUFFER_SIZE = 1024 * 10;     // total bytes in the buffer
-constexpr size_t AUDIO_CHUNK_SIZE  = 1024;         // ideal read/write chunk size
-extern OpusAudioDecoder opusDecoder;
-extern BufferRTOS<uint8_t> audioBuffer;
-extern I2SStream i2s; 
-extern VolumeStream volume;
-extern QueueStream<uint8_t> queue;
-extern StreamCopy copier;
+constexpr size_t PCM_FRAME_POOL_SIZE = 4;          // decoded frames between decoder and mixer
+
+// Output rate, negotiated per session: the WebSocket handshake advertises the
+// rates the device decodes, and the auth message picks one ("sample_rate", plus
+// the Opus "frame_ms" the server will send). The decoder switches at the next
+// turn and the I2S clock once nothing is playing; while a bhajan keeps the old
+// clock, speech is resampled to it. Sample counts in this header are given at
+// SAMPLE_RATE (24 kHz) and scaled with samplesAtRate() where the rate matters.
+constexpr uint32_t SUPPORTED_SAMPLE_RATES[] = {8000, 12000, 16000, 24000, 48000}; // what Opus decodes natively
+extern volatile uint32_t sessionSampleRate;  // negotiated downlink rate, SAMPLE_RATE until then
+extern volatile uint16_t sessionFrameMs;     // negotiated Opus frame duration, 0 = not negotiated
+extern volatile uint32_t outputSampleRate;   // current I2S clock, written by audioStreamTask
+bool isSupportedSampleRate(uint32_t rate);
+bool isSupportedFrameMs(uint16_t ms, uint32_t rate);
+// Packet durations the device asks for, most preferred first. A packet may
+// carry several Opus frames (multi-frame packets are decoded in one call), so
+// 60 ms packets mean 17 WebSocket messages per second instead of 50.
+constexpr uint16_t PREFERRED_FRAME_MS[] = {60, 40, 20};
+inline size_t samplesAtRate(size_t samples, uint32_t rate) { return (uint64_t)samples * rate / SAMPLE_RATE; }
+
+// JITTER BUFFER (Opus packets, before decoding)
+constexpr uint16_t JITTER_BUFFER_PACKETS = 16;
+constexpr uint16_t OPUS_MAX_PACKET_BYTES = 512; // a 120 ms packet at 32 kbps
+constexpr uint16_t JITTER_MIN_DEPTH_MS = 40;
+constexpr uint16_t JITTER_MAX_DEPTH_MS = 600;
+constexpr uint32_t JITTER_PUSH_WAIT_MS = 60;    // cap on networkTask's wait for a free slot (one packet, see queueOpusPacket)
+constexpr uint16_t JITTER_PREBUFFER_MS = 0;       // default prebuffer, 0 = adaptive target only
+constexpr uint32_t DECODE_POLL_MS = 5;        // decode task refill interval while speaking
+constexpr size_t OPUS_MAX_FRAME_SAMPLES = 2880; // 120 ms at 24 kHz (the longest Opus packet), 60 ms at 48 kHz
+
+// Clock drift compensation: speech and bhajan streams are resampled by up to
+// DRIFT_MAX_PPM so that their buffers stay centred (see DriftEstimator)
+constexpr int32_t DRIFT_MAX_PPM = 300;             // 0.5 cents of pitch, inaudible
+constexpr uint32_t DRIFT_WINDOW_MS = 10000;        // fill averaging window
+constexpr uint32_t DRIFT_CENTER_MS = 60000;        // time constant for recentring the fill
+constexpr size_t DRIFT_HEADROOM_SAMPLES = 8;       // extra frame capacity for resampled output
+extern DriftEstimator speechDrift;                 // audioDecodeTask only
+DriftEstimatorConfig driftConfig();
+
+// Rolling timing figures for telemetry (microseconds)
+struct TimingStats {
+    uint32_t count = 0;
+    uint32_t last_us = 0;
+    uint32_t avg_us = 0; // exponential moving average over ~16 samples
+    uint32_t max_us = 0;
+
+    void add(uint32_t us) {
+        last_us = us;
+        avg_us = count == 0 ? us : avg_us - avg_us / 16 + us / 16;
+        if (us > max_us) {
+            max_us = us;
+        }
+        count++;
+    }
+};
+extern TimingStats decodeTiming;
+extern TimingStats networkLoopTiming;
+extern TimingStats wsHoldTiming;
+
+// Per-message cost of the speech downlink, networkTask only
+struct DownlinkStats {
+    uint32_t messages = 0;  // binary WebSocket messages carrying audio
+    uint32_t frames = 0;    // Opus frames in them
+    uint32_t bytes = 0;     // Opus payload
+    uint32_t audio_ms = 0;  // speech they carried
+    uint32_t rejected = 0;  // invalid, or too long or large for the buffers
+    TimingStats dispatch;   // webSocketEvent(WStype_BIN) from entry to queued
+};
+extern DownlinkStats downlinkStats;
+
+// Milestones of the current speaking turn, millis() or 0 until reached
+struct TurnTiming {
+    volatile uint32_t created_ms = 0;       // RESPONSE.CREATED (networkTask)
+    volatile uint32_t first_rx_ms = 0;      // first audio packet queued (networkTask)
+    volatile uint32_t first_decoded_ms = 0; // first frame handed to the mixer (audioDecodeTask)
+    volatile uint32_t first_write_ms = 0;   // first speech block written to I2S (audioStreamTask)
+    volatile uint32_t drained_ms = 0;       // last speech block written to I2S (audioStreamTask)
+    volatile uint32_t played_samples = 0;   // speech written to I2S, samples at SAMPLE_RATE (audioStreamTask)
+};
+extern TurnTiming turnTiming;
+extern volatile uint16_t prebufferMs;  // applied to the jitter buffer at the start of each turn
+
+// Output mixer, owned by audioStreamTask. One block is 10 ms at 24 kHz; mixing
+// it must stay within MIXER_CPU_BUDGET_US (5% of the block period).
+constexpr size_t MIXER_BLOCK_SAMPLES = 240;
+constexpr size_t MIXER_MAX_BLOCK_SAMPLES = 480;  // one block at 48 kHz
+constexpr uint32_t MIXER_CPU_BUDGET_US = 500;
+constexpr int MIXER_BHAJAN_DUCK_PERCENT = 25;  // bhajan level while the AI speaks
+constexpr uint32_t MIXER_DUCK_HOLD_MS = 600;   // keep ducking across pauses between sentences
+constexpr uint32_t MIXER_GAIN_RAMP_MS = 200;   // full-scale gain change takes this long
+constexpr size_t BHAJAN_FRAME_POOL_SIZE = 4;
+constexpr size_t BHAJAN_FRAME_SAMPLES = 1024;  // internal-RAM side of the bhajan ring, 43 ms each
+constexpr size_t EARCON_FRAME_POOL_SIZE = 4;   // 40 ms of prompt in mixer blocks
+extern PcmFramePool bhajanFrames;
+extern PcmFramePool earconFrames;
+extern AudioMixer audioMixer;
+extern TimingStats mixerTiming;
+
+// Speaker protection after the mixer: volume above 100 % is applied here rather
+// than in the mixer, then the EQ for the enclosure and the look-ahead limiter.
+// The worst case (every sample above the ceiling, 10 ms at 48 kHz) has to fit
+// SPEAKER_PROTECTION_BUDGET_US; it is timed on every block.
+constexpr BiquadSpec SPEAKER_EQ[SPEAKER_EQ_STAGES] = {
+    {BIQUAD_HIGHPASS, 180, 0.707f, 0},   // below the enclosure's resonance, only costs excursion
+    {BIQUAD_PEAK, 2800, 1.2f, 3},        // presence, the small driver is soft up here
+    {BIQUAD_HIGHSHELF, 7000, 0.707f, -3} // tame the tweeter-less top end
+};
+constexpr int16_t SPEAKER_LIMIT_CEILING = 29204;          // -1 dBFS
+constexpr uint16_t SPEAKER_LOOKAHEAD_US = 2000;
+constexpr size_t SPEAKER_LOOKAHEAD_SAMPLES = 48;          // the same 2 ms at 24 kHz
+constexpr uint16_t SPEAKER_RELEASE_MS = 80;
+constexpr uint32_t SPEAKER_PROTECTION_BUDGET_US = 250;    // per mixer block
+extern TimingStats speakerProtectionTiming;
+void initAudioOutput();
+bool queueEarcon(const int16_t *pcm, size_t samples);
 
-// NEW for pitch shift
-extern VolumeStream volumePitch;
-extern StreamCopy pitchCopier;
+// Thinking cue: audioStreamTask loops EARCON_THINKING from flash through the
+// earcon frames while the answer is being prepared (PROCESSING), and crossfades
+// it out with the mixer's gain ramp once the first answer frame plays.
+constexpr uint32_t THINKING_CUE_CROSSFADE_MS = MIXER_GAIN_RAMP_MS;
+constexpr uint32_t THINKING_CUE_MAX_MS = 20000;  // give up on an answer that never comes
+extern volatile bool thinkingCueEnabled;         // from the auth message
+extern volatile bool thinkingCueRequested;       // set by networkTask at AUDIO.COMMITTED
+struct ThinkingCueStats {
+    uint32_t played = 0;
+    uint32_t crossfaded = 0;     // ended by the answer, the normal case
+    uint32_t last_ms = 0;        // cue start to the first answer frame
+};
+extern ThinkingCueStats thinkingCueStats;
+
+// Levels of each block sent to the speaker (measured by the output stage while
+// it writes the block) and read from the mic (one pass over the block where it
+// landed in micRing). Read by ledTask for the VU effect and by telemetry.
+extern LevelMeter speakerLevels;  // writer: audioStreamTask
+extern LevelMeter micLevels;      // writer: micTask
+
+// Events that wake audioStreamTask (task notification bits)
+constexpr uint32_t SPEAKER_EVT_FRAME = 1 << 0; // a frame is ready on any mixer source
+constexpr uint32_t SPEAKER_EVT_FLUSH = 1 << 1; // i2sOutputFlushScheduled was set
+constexpr uint32_t SPEAKER_EVT_STATE = 1 << 2; // deviceState entered or left SPEAKING
+constexpr uint32_t SPEAKER_EVT_CANCEL = 1 << 3; // requestSpeechCancel() was called
+void notifySpeakerTask(uint32_t events);
+
+// Barge-in: speech stops within BARGE_IN_BUDGET_SAMPLES of requestSpeechCancel().
+// Worst case is one block to notice the request, the queued output DMA ring
+// playing out behind it, the limiter's look-ahead and the fade itself.
+constexpr size_t CANCEL_FADE_SAMPLES = 120;               // 5 ms, long enough to avoid a click
+constexpr size_t BARGE_IN_BUDGET_SAMPLES = 1200;          // 50 ms at 24 kHz
+
+// I2S DMA rings. Both start from NVS (or these defaults), can be set by the
+// server and are auto-tuned by DmaTuner from their xrun counters; the result
+// is saved back to NVS. The output ring never grows past the barge-in budget.
+// Output frames are counted at SAMPLE_RATE throughout and only scaled to the
+// negotiated rate when the I2S driver is configured, so the ring keeps its duration.
+constexpr uint8_t OUTPUT_DMA_BUFFERS = 3;                 // default ring, 30 ms
+constexpr uint16_t OUTPUT_DMA_FRAMES = MIXER_BLOCK_SAMPLES;
+constexpr uint8_t OUTPUT_DMA_MIN_BUFFERS = 2;
+constexpr uint8_t OUTPUT_DMA_MAX_BUFFERS = 6;
+constexpr uint16_t OUTPUT_DMA_MIN_FRAMES = 120;
+constexpr uint16_t OUTPUT_DMA_MAX_FRAMES = 240;
+constexpr uint32_t OUTPUT_DMA_MAX_TOTAL_FRAMES = 800;     // 33 ms at 24 kHz
+static_assert(MIXER_BLOCK_SAMPLES + OUTPUT_DMA_MAX_TOTAL_FRAMES + SPEAKER_LOOKAHEAD_SAMPLES + CANCEL_FADE_SAMPLES <
+                  BARGE_IN_BUDGET_SAMPLES,
+              "output buffering exceeds the barge-in budget");
+constexpr uint8_t MIC_DMA_BUFFERS = 4;                    // default ring, 64 ms at 16 kHz
+constexpr uint16_t MIC_DMA_FRAMES = 256;
+constexpr uint8_t MIC_DMA_MIN_BUFFERS = 2;
+constexpr uint8_t MIC_DMA_MAX_BUFFERS = 8;
+constexpr uint16_t MIC_DMA_MIN_FRAMES = 128;
+constexpr uint16_t MIC_DMA_MAX_FRAMES = 512;
+constexpr uint32_t DMA_SHRINK_AFTER_MS = 60000;           // streaming time without xruns before trying a smaller ring
+extern DmaTuner outputDma;              // audioStreamTask only
+extern DmaTuner micDma;                 // micTask only
+extern volatile bool dmaAutoTune;       // from the auth message
+extern volatile uint32_t outputDmaRequest; // packDmaSettings() from the server, 0 = none
+extern volatile uint32_t micDmaRequest;
+inline uint32_t packDmaSettings(uint8_t buffers, uint16_t frames) { return (uint32_t)buffers << 16 | frames; }
+extern TimingStats bargeInTiming;  // requestSpeechCancel() until the faded audio has played out
+void requestSpeechCancel();
+
+// Amplifier enable (I2S_SD_OUT), driven by audioStreamTask through AmpGate: on
+// at RESPONSE.CREATED or when any source starts, off after the idle hold.
+constexpr uint32_t AMP_IDLE_HOLD_MS = 2000;     // default, the server may set "amp_hold_ms"
+constexpr size_t AMP_PREROLL_SAMPLES = 120;     // 5 ms of silence after switch-on, at 24 kHz
+constexpr uint32_t AMP_QUIESCENT_UA = 2400;     // MAX98357A supply current with no signal, for telemetry
+extern AmpGate ampGate;                         // audioStreamTask only
+extern volatile uint32_t ampIdleHoldMs;
+
+// Speaker task activity for telemetry; it sleeps between events
+struct TaskLoad {
+    uint32_t wakeups = 0;
+    uint32_t busy_us = 0; // processing time, excluding time blocked in i2s.write()
+    uint32_t over_budget = 0; // mixer blocks that took longer than MIXER_CPU_BUDGET_US
+};
+extern TaskLoad speakerLoad;
+
+// audioStreamTask runs the mixer, WSOLA and the resampler, SpeakerProtection and
+// the earcons, and on a rate or DMA change also i2s end/begin, an NVS write and
+// Serial.printf; the last two are the deepest calls, at 2-3 KB each. The
+// high-water mark is reported as speaker_task.stack_free_bytes.
+constexpr uint32_t SPEAKER_TASK_STACK_BYTES = 8192;
+
+extern OpusFrameDecoder opusDecoder;
+extern volatile bool audioSeqEnabled;  // server prefixes packets with a 16-bit sequence number
+extern volatile bool opusFecEnabled;   // server encodes with in-band FEC
+extern PcmFramePool speechFrames;
+extern I2SStream i2s; 
 
 extern AudioInfo info;
 extern volatile bool i2sOutputFlushScheduled;
 
 // AUDIO INPUT
 extern I2SStream i2sInput;
-extern StreamCopy micToWsCopier;
+// Mic uplink: micTask reads the I2S DMA ring into micRing, networkTask sends from
+// it, one frame of micFrameMs per binary message whatever the codec
+constexpr uint32_t MIC_SAMPLE_RATE = 16000;
+constexpr size_t MIC_RING_BYTES = 16384;     // 0.5 s at 16 kHz
+constexpr size_t MIC_READ_BYTES = 320;       // 10 ms at 16 kHz per I2S read
+constexpr uint8_t MIC_FRAME_MS = 20;         // default; the server may ask for 10, 20 or 40 ("mic_frame_ms")
+constexpr uint8_t MIC_MAX_FRAME_MS = 40;
+constexpr size_t MIC_MAX_FRAME_SAMPLES = MIC_SAMPLE_RATE * MIC_MAX_FRAME_MS / 1000;
+struct MicUplinkStats {
+    uint32_t messages = 0;
+    uint32_t bytes = 0;          // payload
+    uint32_t wire_bytes = 0;     // payload plus WebSocket, TLS and TCP/IP headers (wsUplinkWireBytes)
+    uint32_t audio_ms = 0;       // audio the messages carried
+    uint32_t ring_drops = 0;     // blocks discarded because micRing (or, for Opus, micEncodeTask) was behind
+    uint32_t max_fill_bytes = 0;
+    TimingStats send;            // send time of sendMicAudio() calls that sent something (part of wsHoldTiming)
+    TimingStats encode;          // opus_encode() per frame, micEncodeTask
+    TimingStats latency;         // first sample of a frame captured until its packet is sent
+};
+extern SpscRing micRing;
+extern MicFrameReader micReader;
+extern MicUplinkStats micUplink;
+extern volatile uint8_t micFrameMs;
+
+// Opus mic uplink, when the server asks for it in the auth message ("mic_codec":
+// "opus"); raw 16-bit PCM otherwise. micTask captures frames of micFrameMs into
+// micOpusFrames, micEncodeTask encodes them as VOIP packets and puts each in
+// micRing behind a MicPacketHeader; networkTask sends one packet per binary
+// message. micEncodeTask is only created the first time a server asks for Opus,
+// so PCM-only devices never allocate its stack.
+constexpr uint32_t MIC_OPUS_BITRATE = 24000;     // default, against 256 kbps of PCM
+constexpr uint8_t MIC_OPUS_COMPLEXITY = 5;       // default; 0..10, CPU grows with it
+constexpr uint32_t MIC_OPUS_MIN_BITRATE = 6000;  // libopus range; auth values are clamped to it
+constexpr uint32_t MIC_OPUS_MAX_BITRATE = 510000; // packets stay capped at MIC_OPUS_MAX_PACKET
+constexpr uint8_t MIC_OPUS_MAX_COMPLEXITY = 10;
+constexpr size_t MIC_OPUS_MAX_PACKET = 800;      // a 40 ms frame up to 160 kbps
+constexpr size_t MIC_OPUS_FRAME_POOL_SIZE = 3;   // captured frames waiting for micEncodeTask
+// opus_encode() is said to need about 30 KB of stack; not measured on this board
+// yet, so this is an estimate. "mic_uplink" telemetry reports what is left
+// (stack_free_bytes) and test/mic_opus_encode_benchmark.cpp measures it.
+constexpr uint32_t MIC_ENCODER_STACK_BYTES = 32768;
+constexpr uint8_t MIC_PACKET_SYNC = 0xA5;        // first byte of every MicPacketHeader
+struct MicPacketHeader {
+    uint8_t sync;         // MIC_PACKET_SYNC, checked before len is trusted
+    uint16_t len;
+    uint8_t frame_ms;
+    uint32_t captured_us; // micros() when the frame's first sample was captured
+} __attribute__((packed));
+extern volatile bool micOpusEnabled;
+extern volatile uint32_t micOpusBitrate;
+extern volatile uint8_t micOpusComplexity;
 extern volatile bool i2sInputFlushScheduled;
 
 // WEBSOCKET
@@ -50,12 +318,15 @@ void websocketSetup(const String& server_domain, int port, const String& path);
 void networkTask(void *parameter);
 void sendBhajanStatusUpdate();
 void sendEnhancedStatusUpdate();
+void appendAudioTelemetry(JsonDocument &doc);
 
 // AUDIO OUTPUT
 unsigned long getSpeakingDuration();
+void audioDecodeTask(void *parameter);
 void audioStreamTask(void *parameter);
 
 // AUDIO INPUT
 void micTask(void *parameter);
+void micEncodeTask(void *parameter);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,212 @@
+#include "AudioDsp.h"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+#if defined(CONFIG_IDF_TARGET_ESP32S3) && !defined(AUDIO_DSP_PORTABLE)
+#define AUDIO_DSP_PIE
+#include "esp_dsp.h"
+#endif
+
+static void mixPortable(int16_t *dst, const int16_t *src, size_t count, int32_t gain_q15) {
+  size_t i = 0;
+#ifndef AUDIO_DSP_PORTABLE
+  for (; i + 4 <= count; i += 4) {
+    int32_t a = dst[i] + ((src[i] * gain_q15) >> 15);
+    int32_t b = dst[i + 1] + ((src[i + 1] * gain_q15) >> 15);
+    int32_t c = dst[i + 2] + ((src[i + 2] * gain_q15) >> 15);
+    int32_t d = dst[i + 3] + ((src[i + 3] * gain_q15) >> 15);
+    dst[i] = dspSaturate(a);
+    dst[i + 1] = dspSaturate(b);
+    dst[i + 2] = dspSaturate(c);
+    dst[i + 3] = dspSaturate(d);
+  }
+#endif
+  for (; i < count; i++) {
+    dst[i] = dspSaturate(dst[i] + ((src[i] * gain_q15) >> 15));
+  }
+}
+
+#ifdef AUDIO_DSP_PIE
+// The aes3 kernels work on 8 samples per instruction and fall back to their own
+// scalar code, which wraps instead of saturating, for anything else; so only
+// aligned runs of 8 go to them. The scaled source goes through an aligned
+// scratch chunk on the stack.
+constexpr size_t PIE_LANES = 8;
+constexpr size_t PIE_CHUNK = 64;
+
+static size_t mixPie(int16_t *dst, const int16_t *src, size_t count, int32_t gain_q15) {
+  if ((((uintptr_t)dst | (uintptr_t)src) & (DSP_ALIGN_BYTES - 1)) != 0 || gain_q15 > DSP_UNITY_Q15 ||
+      gain_q15 < 0) {
+    return 0;
+  }
+  size_t simd = count & ~(PIE_LANES - 1);
+  if (gain_q15 == DSP_UNITY_Q15) {
+    dsps_add_s16_aes3(dst, src, dst, (int)simd, 1, 1, 1, 0);
+    return simd;
+  }
+  alignas(DSP_ALIGN_BYTES) int16_t scaled[PIE_CHUNK];
+  for (size_t i = 0; i < simd; i += PIE_CHUNK) {
+    int n = (int)(simd - i < PIE_CHUNK ? simd - i : PIE_CHUNK);
+    dsps_mulc_s16_aes3(src + i, scaled, n, (int16_t)gain_q15, 1, 1);
+    dsps_add_s16_aes3(dst + i, scaled, dst + i, n, 1, 1, 1, 0);
+  }
+  return simd;
+}
+
+static size_t gainPie(int16_t *samples, size_t count, int32_t gain_q15) {
+  if (((uintptr_t)samples & (DSP_ALIGN_BYTES - 1)) != 0 || gain_q15 > DSP_UNITY_Q15 || gain_q15 < 0) {
+    return 0;
+  }
+  size_t simd = count & ~(PIE_LANES - 1);
+  dsps_mulc_s16_aes3(samples, samples, (int)simd, (int16_t)gain_q15, 1, 1);
+  return simd;
+}
+#endif
+
+static inline int16_t gainSample(int16_t s, int32_t gain_q15) {
+  return dspSaturate((s * gain_q15) >> 15);
+}
+
+static void gainPortable(int16_t *samples, size_t count, int32_t gain_q15) {
+  size_t i = 0;
+#ifndef AUDIO_DSP_PORTABLE
+  for (; i + 4 <= count; i += 4) {
+    int16_t a = gainSample(samples[i], gain_q15);
+    int16_t b = gainSample(samples[i + 1], gain_q15);
+    int16_t c = gainSample(samples[i + 2], gain_q15);
+    int16_t d = gainSample(samples[i + 3], gain_q15);
+    samples[i] = a;
+    samples[i + 1] = b;
+    samples[i + 2] = c;
+    samples[i + 3] = d;
+  }
+#endif
+  for (; i < count; i++) {
+    samples[i] = gainSample(samples[i], gain_q15);
+  }
+}
+
+void dspGain(int16_t *samples, size_t count, int32_t gain_q15) {
+  if (gain_q15 == DSP_UNITY_Q15) {
+    return;
+  }
+  size_t done = 0;
+#ifdef AUDIO_DSP_PIE
+  done = gainPie(samples, count, gain_q15);
+#endif
+  gainPortable(samples + done, count - done, gain_q15);
+}
+
+void dspMix(int16_t *dst, const int16_t *src, size_t count, int32_t gain_q15) {
+  size_t done = 0;
+#ifdef AUDIO_DSP_PIE
+  done = mixPie(dst, src, count, gain_q15);
+#endif
+  mixPortable(dst + done, src + done, count - done, gain_q15);
+}
+
+void dspMixRamp(int16_t *dst, const int16_t *src, size_t count, int32_t gain_from_q15, int32_t gain_to_q15) {
+  if (gain_from_q15 == gain_to_q15 || count == 0) {
+    dspMix(dst, src, count, gain_to_q15);
+    return;
+  }
+  // gain in Q15.16 so the per-sample step keeps its precision on short ramps
+  int32_t step = (int32_t)(((int64_t)(gain_to_q15 - gain_from_q15) << 16) / (int32_t)count);
+  int64_t gain = (int64_t)gain_from_q15 << 16;
+  for (size_t i = 0; i < count; i++) {
+    int32_t g = (int32_t)(gain >> 16);
+    dst[i] = dspSaturate(dst[i] + ((src[i] * g) >> 15));
+    gain += step;
+  }
+}
+
+// esp-dsp has no per-sample weighted blend or int32 -> int16 narrowing kernel,
+// so dspCrossfade() and dspNarrow() stay on the C++ loops on every target.
+void dspCrossfade(int16_t *out, const int16_t *from, const int16_t *to, size_t count,
+                  uint32_t position, uint32_t length) {
+  size_t i = 0;
+  if (length > 0 && position < length) {
+    // fade-in weight in Q31, stepped per sample to avoid a division per sample
+    uint32_t step = 0x80000000u / length;
+    uint32_t weight = position * step;
+    size_t fade = length - position;
+    if (fade > count) {
+      fade = count;
+    }
+    for (; i < fade; i++) {
+      int32_t w = weight >> 16; // Q15
+      out[i] = (int16_t)((from[i] * (DSP_UNITY_Q15 - w) + to[i] * w) >> 15);
+      weight += step;
+    }
+  }
+  for (; i < count; i++) {
+    out[i] = to[i];
+  }
+}
+
+void dspNarrow(int16_t *out, const int32_t *in, size_t count, int shift) {
+  size_t i = 0;
+#ifndef AUDIO_DSP_PORTABLE
+  for (; i + 4 <= count; i += 4) {
+    out[i] = dspSaturate(in[i] >> shift);
+    out[i + 1] = dspSaturate(in[i + 1] >> shift);
+    out[i + 2] = dspSaturate(in[i + 2] >> shift);
+    out[i + 3] = dspSaturate(in[i + 3] >> shift);
+  }
+#endif
+  for (; i < count; i++) {
+    out[i] = dspSaturate(in[i] >> shift);
+  }
+}
+
+static uint32_t isqrt64(uint64_t v) {
+  uint64_t result = 0;
+  uint64_t bit = (uint64_t)1 << 62;
+  while (bit > v) {
+    bit >>= 2;
+  }
+  while (bit != 0) {
+    if (v >= result + bit) {
+      v -= result + bit;
+      result = (result >> 1) + bit;
+    } else {
+      result >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint32_t)result;
+}
+
+DspLevels dspLevels(const int16_t *samples, size_t count) {
+  DspLevels levels;
+  if (count == 0) {
+    return levels;
+  }
+  uint32_t peak = 0;
+  uint32_t clipped = 0;
+  uint64_t sum = 0;
+  for (size_t i = 0; i < count; i++) {
+    int32_t s = samples[i];
+    uint32_t mag = s < 0 ? -s : s;
+    if (mag > peak) {
+      peak = mag;
+    }
+    if (mag >= 32767) {
+      clipped++;
+    }
+    sum += (uint32_t)(s * s);
+  }
+  levels.peak = peak > 32767 ? 32767 : peak;
+  levels.rms = dspRms(sum, count);
+  levels.clipped = clipped;
+  return levels;
+}
+
+uint16_t dspRms(uint64_t sum_squares, size_t count) {
+  if (count == 0) {
+    return 0;
+  }
+  uint32_t rms = isqrt64(sum_squares / count);
+  return rms > 32767 ? 32767 : (uint16_t)rms;
+}
@@ -0,0 +1,65 @@
+#ifndef AUDIODSP_H
+#define AUDIODSP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Fixed-point kernels for mono int16 audio blocks. Plain C++ so they can be
+// tested on the host. On the ESP32-S3 dspGain() and dspMix() run on the PIE
+// SIMD unit through esp-dsp (dsps_mulc_s16_aes3, dsps_add_s16_aes3) when their
+// buffers are DSP_ALIGN_BYTES aligned and the gain is at most unity; otherwise,
+// on other targets and with AUDIO_DSP_PORTABLE they use the C++ loops, unrolled
+// by four so the Xtensa compiler can schedule loads ahead of the multiplies.
+// The SIMD path is meant to give the same samples as the C++ one;
+// test/audio_dsp_benchmark.cpp checks that on the board.
+//
+// Gains are Q15 held in an int32: 32768 is unity, boost up to 2x (65535).
+
+constexpr int32_t DSP_UNITY_Q15 = 32768;
+constexpr size_t DSP_ALIGN_BYTES = 16;  // what the PIE kernels load and store in one go
+
+// 0..100 % volume as used by currentVolume -> Q15 gain
+inline int32_t dspGainFromPercent(int percent) {
+  if (percent < 0) {
+    percent = 0;
+  }
+  return (int32_t)percent * DSP_UNITY_Q15 / 100;
+}
+
+inline int16_t dspSaturate(int32_t v) {
+  return v > 32767 ? 32767 : (v < -32768 ? -32768 : (int16_t)v);
+}
+
+// samples *= gain, in place
+void dspGain(int16_t *samples, size_t count, int32_t gain_q15);
+
+// dst += src * gain
+void dspMix(int16_t *dst, const int16_t *src, size_t count, int32_t gain_q15);
+
+// dst += src * gain, with the gain moving linearly from gain_from to gain_to
+// across the block (click-free gain changes and ducking)
+void dspMixRamp(int16_t *dst, const int16_t *src, size_t count, int32_t gain_from_q15, int32_t gain_to_q15);
+
+// out = from faded out and to faded in, linearly over `length` samples.
+// `position` is where this block starts within the fade so a crossfade can span
+// several blocks; samples past the end of the fade are taken from `to`.
+// `out` may alias `from` or `to`.
+void dspCrossfade(int16_t *out, const int16_t *from, const int16_t *to, size_t count,
+                  uint32_t position, uint32_t length);
+
+// out = saturate(in >> shift), e.g. for accumulators or 24/32-bit sources
+void dspNarrow(int16_t *out, const int32_t *in, size_t count, int shift);
+
+struct DspLevels {
+  uint16_t peak = 0;    // largest magnitude
+  uint16_t rms = 0;
+  uint32_t clipped = 0; // samples at full scale
+};
+
+DspLevels dspLevels(const int16_t *samples, size_t count);
+
+// sqrt(sum_squares / count), for stages that accumulate the squares in a pass
+// they already make over the block
+uint16_t dspRms(uint64_t sum_squares, size_t count);
+
+#endif
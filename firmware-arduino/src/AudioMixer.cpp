@@ -0,0 +1,145 @@
+#include "AudioMixer.h"
+
+void AudioMixer::begin(uint32_t gain_ramp_step_q15, uint32_t duck_hold_blocks) {
+  ramp_step_q15 = gain_ramp_step_q15;
+  hold_blocks = duck_hold_blocks;
+}
+
+void AudioMixer::addSource(MixerSourceId id, const SourceConfig &config) {
+  Source &src = sources[id];
+  src.cfg = config;
+  src.gain_q15 = config.gain_q15;
+  src.applied_q15 = 0;
+}
+
+void AudioMixer::clear(MixerSourceId id) {
+  Source &src = sources[id];
+  if (!src.cfg.pool) {
+    return;
+  }
+  bool dropped = src.frame != nullptr;
+  if (src.frame) {
+    src.cfg.pool->release(src.frame);
+    src.frame = nullptr;
+    src.offset = 0;
+  }
+  dropped |= src.cfg.pool->flush() > 0;
+  src.hold = 0;
+  src.applied_q15 = 0;
+  src.last_filled = 0;
+  src.fade_samples = 0;
+  if (dropped) {
+    notifyProducer(src);
+  }
+}
+
+bool AudioMixer::ducked(MixerSourceId id) const {
+  for (int i = 0; i < MIXER_SOURCE_COUNT; i++) {
+    if (i != id && sources[i].hold > 0 && sources[i].cfg.priority > sources[id].cfg.priority) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int32_t AudioMixer::rampTowards(int32_t from, int32_t to) const {
+  if (to > from) {
+    return to - from > (int32_t)ramp_step_q15 ? from + ramp_step_q15 : to;
+  }
+  return from - to > (int32_t)ramp_step_q15 ? from - ramp_step_q15 : to;
+}
+
+void AudioMixer::releaseFrame(Source &src) {
+  src.cfg.pool->release(src.frame);
+  src.frame = nullptr;
+  src.offset = 0;
+  notifyProducer(src);
+}
+
+void AudioMixer::notifyProducer(const Source &src) {
+  if (src.cfg.producer && *src.cfg.producer) {
+    xTaskNotifyGive(*src.cfg.producer);
+  }
+}
+
+bool AudioMixer::mix(int16_t *out, size_t samples) {
+  memset(out, 0, samples * sizeof(int16_t));
+
+  // decide ducking from the previous block so every source sees the same picture
+  bool duck[MIXER_SOURCE_COUNT];
+  for (int i = 0; i < MIXER_SOURCE_COUNT; i++) {
+    duck[i] = ducked((MixerSourceId)i);
+  }
+
+  bool playing = false;
+  for (int i = 0; i < MIXER_SOURCE_COUNT; i++) {
+    Source &src = sources[i];
+    if (!src.cfg.pool) {
+      continue;
+    }
+
+    int64_t target = (int64_t)src.gain_q15 * master_gain_q15 >> 15;
+    if (duck[i]) {
+      target = target * src.cfg.duck_gain_q15 >> 15;
+    }
+    int32_t start_gain = src.applied_q15;
+    int32_t end_gain = rampTowards(start_gain, (int32_t)target);
+
+    // a cancelled source ramps to silence over the fade and is dropped afterwards
+    size_t span = samples;
+    if (src.fade_samples > 0) {
+      span = src.fade_samples < samples ? src.fade_samples : samples;
+      end_gain = 0;
+    }
+
+    size_t filled = 0;
+    while (filled < span) {
+      if (!src.frame) {
+        src.frame = src.cfg.pool->receive(0);
+        if (!src.frame) {
+          break;
+        }
+        src.offset = 0;
+        if (src.cfg.prepare) {
+          src.cfg.prepare(src.frame);
+        }
+      }
+      size_t n = src.frame->count - src.offset;
+      if (n > span - filled) {
+        n = span - filled;
+      }
+      int64_t delta = end_gain - start_gain;
+      int32_t g0 = start_gain + (int32_t)(delta * (int64_t)filled / (int64_t)span);
+      int32_t g1 = start_gain + (int32_t)(delta * (int64_t)(filled + n) / (int64_t)span);
+      dspMixRamp(out + filled, src.frame->samples + src.offset, n, g0, g1);
+      filled += n;
+      src.offset += n;
+      if (src.offset >= src.frame->count) {
+        releaseFrame(src);
+      }
+    }
+
+    src.last_filled = filled;
+    if (src.fade_samples > 0) {
+      src.fade_samples = 0;
+      clear((MixerSourceId)i);
+      src.last_filled = filled;
+      playing |= filled > 0; // the fade itself still has to be written out
+      continue;
+    }
+    if (filled > 0) {
+      if (filled < samples && src.hold > 0) {
+        src.underruns++;
+      }
+      src.hold = hold_blocks + 1;
+      src.applied_q15 = end_gain;
+    } else if (src.hold > 0) {
+      src.hold--;
+      src.applied_q15 = end_gain;
+    } else {
+      src.applied_q15 = 0; // fade in again when the source restarts
+    }
+    playing |= src.hold > 0;
+  }
+  return playing;
+}
@@ -0,0 +1,83 @@
+#ifndef AUDIOMIXER_H
+#define AUDIOMIXER_H
+
+#include <Arduino.h>
+#include "PcmFramePool.h"
+#include "AudioDsp.h"
+
+enum MixerSourceId {
+  MIXER_SPEECH,  // decoded AI speech
+  MIXER_BHAJAN,  // streamed bhajan music
+  MIXER_EARCON,  // short local prompts
+  MIXER_SOURCE_COUNT
+};
+
+// Mixes several PcmFramePool sources into fixed-size output blocks. Only the
+// owning task (audioStreamTask) calls mix() and clear(); producers just fill
+// frames from their pool, so a slow source never blocks another one.
+//
+// A source is ducked to its duck gain while any source with a higher priority
+// is playing, and for `duck_hold_blocks` after it stops so pauses between
+// sentences do not pump the music up and down. Gain changes ramp over a block.
+class AudioMixer {
+public:
+  typedef void (*FrameHook)(PcmFrame *frame);
+
+  struct SourceConfig {
+    PcmFramePool *pool = nullptr;
+    uint8_t priority = 0;               // higher wins
+    int32_t gain_q15 = DSP_UNITY_Q15;
+    int32_t duck_gain_q15 = DSP_UNITY_Q15;
+    TaskHandle_t *producer = nullptr;   // notified whenever a frame is handed back
+    FrameHook prepare = nullptr;        // in-place processing when a frame is first taken
+  };
+
+  void begin(uint32_t gain_ramp_step_q15, uint32_t duck_hold_blocks);
+  void addSource(MixerSourceId id, const SourceConfig &config);
+
+  // Any task; takes effect with a ramp on the next block.
+  void setGain(MixerSourceId id, int32_t gain_q15) { sources[id].gain_q15 = gain_q15; }
+  void setMasterGain(int32_t gain_q15) { master_gain_q15 = gain_q15; }
+
+  // Owner task only: drop the current and all queued frames of a source.
+  void clear(MixerSourceId id);
+
+  // Owner task only: ramp a source to silence over the first `samples` of the
+  // next block, then clear() it. Used to cut speech off without a click.
+  void fadeOut(MixerSourceId id, size_t samples) { sources[id].fade_samples = samples ? samples : 1; }
+  bool isFading(MixerSourceId id) const { return sources[id].fade_samples > 0; }
+
+  // Owner task only: fill `out` with the next block. Returns false, with `out`
+  // silent, once no source has played within its hold time (and no fade is
+  // being finished); the caller may then sleep until a producer signals new frames.
+  bool mix(int16_t *out, size_t samples);
+
+  bool isPlaying(MixerSourceId id) const { return sources[id].hold > 0; }
+  uint32_t underruns(MixerSourceId id) const { return sources[id].underruns; }
+  size_t lastBlockSamples(MixerSourceId id) const { return sources[id].last_filled; } // from the last mix()
+
+protected:
+  struct Source {
+    SourceConfig cfg;
+    volatile int32_t gain_q15 = DSP_UNITY_Q15;
+    int32_t applied_q15 = 0;     // gain used at the end of the last block
+    PcmFrame *frame = nullptr;   // frame being consumed
+    size_t offset = 0;
+    uint32_t hold = 0;           // blocks left before the source counts as stopped
+    uint32_t underruns = 0;      // blocks cut short while the source was playing
+    size_t last_filled = 0;      // samples the source contributed to the last block
+    size_t fade_samples = 0;     // pending fadeOut() length, 0 when not cancelling
+  };
+
+  Source sources[MIXER_SOURCE_COUNT];
+  volatile int32_t master_gain_q15 = DSP_UNITY_Q15;
+  uint32_t ramp_step_q15 = DSP_UNITY_Q15;
+  uint32_t hold_blocks = 0;
+
+  bool ducked(MixerSourceId id) const;
+  int32_t rampTowards(int32_t from, int32_t to) const;
+  void releaseFrame(Source &src);
+  void notifyProducer(const Source &src);
+};
+
+#endif
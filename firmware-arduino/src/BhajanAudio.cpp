@@ -13,9 +13,24 @@ SemaphoreHandle_t bhajanMutex = NULL;
 // Static variables for internal use
 static WiFiClient bhajanClient;
 static HTTPClient http;
-// Use a dedicated temporary buffer for streaming to avoid conflicting with shared audioBuffer
-static uint8_t bhajanTempBuffer[BHAJAN_BUFFER_SIZE];
 static uint32_t playbackStartTime = 0;
+// Seconds of the stream in PSRAM, at the stream rate, downloaded ahead so Wi-Fi
+// stalls do not reach the speaker; bhajanFrames are the small internal-RAM side of it
+static TieredRingBuffer bhajanRing;
+// Converts the ring to the output rate on its way into the frames, and trims
+// live streams to the server's clock by the ring fill
+static Resampler bhajanResampler;
+DriftEstimator bhajanDrift;
+static uint32_t bhajanStreamRate = 0;
+static int16_t bhajanChunk[BHAJAN_READ_SAMPLES];
+// Changes the tempo after the resampler, so its cost does not depend on the
+// stream rate; engaged for the rest of a stream once the speed leaves 1
+volatile float bhajanSpeed = 1.0f;
+static WsolaStretch bhajanStretch;
+static bool bhajanStretching = false;
+static int16_t bhajanStretchIn[BHAJAN_STRETCH_BLOCK];
+static size_t bhajanStretchInPos = 0;
+static size_t bhajanStretchInLen = 0;
 static uint32_t pausedPosition = 0;
 
 // Initialize bhajan audio system
@@ -24,8 +39,17 @@ void initBhajanAudio() {
     currentBhajan.status = BHAJAN_STOPPED;
     currentBhajan.position = 0;
     currentBhajan.duration = 0;
+    currentBhajan.sample_rate = SAMPLE_RATE;
     
     bhajanMutex = xSemaphoreCreateMutex();
+    bhajanDrift.begin(driftConfig());
+
+    if (!bhajanRing.begin(BHAJAN_RING_SAMPLES, BHAJAN_RING_HOT_SAMPLES, BHAJAN_RING_FALLBACK_SAMPLES)) {
+        Serial.println("Failed to allocate bhajan ring buffer");
+    } else {
+        Serial.printf("Bhajan ring: %u samples in %s\n", (unsigned)bhajanRing.capacitySamples(),
+                      bhajanRing.inPsram() ? "PSRAM" : "internal RAM");
+    }
     
     if (!bhajanMutex) {
         Serial.println("Failed to create bhajan mutex");
@@ -58,6 +82,105 @@ void bhajanAudioTask(void *parameter) {
     }
 }
 
+// bhajanAudioTask -> streamBhajanAudio() -> readBhajanSamples()
+// Reads what the stream has buffered, without waiting for more, into `out`.
+// Returns the samples read and sets `bytesRead` to the stream bytes consumed.
+static size_t readBhajanSamples(WiFiClient *stream, int16_t *out, size_t capacity, size_t &bytesRead) {
+    bytesRead = 0;
+    size_t want = capacity * sizeof(int16_t);
+    size_t avail = stream->available();
+    if (avail < want) {
+        want = avail & ~(size_t)1;
+    }
+    if (want == 0) {
+        return 0;
+    }
+    bytesRead = stream->readBytes((uint8_t *)out, want);
+    if (bytesRead % 2 != 0) {
+        // keep the stream sample aligned
+        bytesRead += stream->readBytes((uint8_t *)out + bytesRead, 1);
+    }
+    return bytesRead / sizeof(int16_t);
+}
+
+// bhajanAudioTask -> streamBhajanAudio() -> fillBhajanFrame() -> resampleBhajan()
+// Resamples from the ring's hot window straight into `out`.
+static size_t resampleBhajan(int16_t *out, size_t capacity) {
+    size_t produced = 0;
+    while (produced < capacity) {
+        size_t count = 0;
+        const int16_t *in = bhajanRing.peek(count);
+        if (count == 0) {
+            break;
+        }
+        size_t consumed = 0;
+        size_t n = bhajanResampler.process(in, count, consumed, out + produced, capacity - produced);
+        bhajanRing.consume(consumed);
+        produced += n;
+        if (n == 0 && consumed == 0) {
+            break;
+        }
+    }
+    return produced;
+}
+
+// bhajanAudioTask -> streamBhajanAudio() -> beginBhajanResampler()
+// (Re)starts the resampler from the stream rate to the rate the I2S clock runs at.
+static bool beginBhajanResampler() {
+    if (!bhajanResampler.begin(bhajanStreamRate, outputSampleRate, BHAJAN_RESAMPLE_QUALITY, BHAJAN_RING_HOT_SAMPLES)) {
+        Serial.printf("Bhajan resampler failed for %u Hz -> %u Hz\n", (unsigned)bhajanStreamRate,
+                      (unsigned)outputSampleRate);
+        return false;
+    }
+    Serial.printf("Bhajan stream %u Hz -> %u Hz (%s)\n", (unsigned)bhajanStreamRate, (unsigned)outputSampleRate,
+                  bhajanStreamRate == outputSampleRate ? "passthrough" : "resampled");
+    bhajanResampler.setRateAdjust(bhajanDrift.correctionPpm());
+    bhajanStretching = false;
+    return true;
+}
+
+// bhajanAudioTask -> streamBhajanAudio() -> fillBhajanFrame()
+// Fills `out` at the rate the I2S clock runs at right now (it only changes while
+// nothing plays), through the time stretch when the speed is not 1.
+static size_t fillBhajanFrame(int16_t *out, size_t capacity) {
+    if (bhajanResampler.outputRate() != outputSampleRate && !beginBhajanResampler()) {
+        currentBhajan.status = BHAJAN_STOPPED; // ends the stream loop
+        sendBhajanStatusUpdate();
+        return 0;
+    }
+    float speed = bhajanSpeed;
+    if (!bhajanStretching) {
+        if (speed == 1.0f) {
+            return resampleBhajan(out, capacity);
+        }
+        // the first stretched output waits for WsolaStretch::requiredInput(), ~55 ms
+        bhajanStretching = bhajanStretch.begin(outputSampleRate, BHAJAN_STRETCH_QUALITY, BHAJAN_STRETCH_BLOCK);
+        bhajanStretchInPos = bhajanStretchInLen = 0;
+        if (!bhajanStretching) {
+            return resampleBhajan(out, capacity);
+        }
+    }
+    bhajanStretch.setTempo(speed);
+
+    size_t produced = 0;
+    while (produced < capacity) {
+        produced += bhajanStretch.read(out + produced, capacity - produced);
+        if (produced == capacity) {
+            break;
+        }
+        if (bhajanStretchInPos == bhajanStretchInLen) {
+            bhajanStretchInPos = 0;
+            bhajanStretchInLen = resampleBhajan(bhajanStretchIn, BHAJAN_STRETCH_BLOCK);
+            if (bhajanStretchInLen == 0) {
+                break;
+            }
+        }
+        bhajanStretchInPos += bhajanStretch.write(bhajanStretchIn + bhajanStretchInPos,
+                                                  bhajanStretchInLen - bhajanStretchInPos);
+    }
+    return produced;
+}
+
 // Stream bhajan audio from URL
 void streamBhajanAudio(const char* url) {
     xSemaphoreTake(bhajanMutex, portMAX_DELAY);
@@ -69,6 +192,17 @@ void streamBhajanAudio(const char* url) {
     
     // Send status update to server
     sendBhajanStatusUpdate();
+
+    bhajanStreamRate = currentBhajan.sample_rate ? currentBhajan.sample_rate : SAMPLE_RATE;
+    bhajanRing.reset();
+    // the fill a live stream settles at is its target, whatever it happens to be
+    bhajanDrift.reset();
+    bhajanDrift.setTarget(0);
+    if (!beginBhajanResampler()) {
+        currentBhajan.status = BHAJAN_STOPPED;
+        sendBhajanStatusUpdate();
+        return;
+    }
     
     bool playbackError = false;
     int retryCount = 0;
@@ -87,7 +221,6 @@ void streamBhajanAudio(const char* url) {
             Serial.println("Connected to audio stream");
             
             WiFiClient *stream = http.getStreamPtr();
-            size_t bytesWritten = 0;
             
             while (currentBhajan.status == BHAJAN_PLAYING) {
                 // Check if we should pause
@@ -102,31 +235,57 @@ void streamBhajanAudio(const char* url) {
                     break;
                 }
                 
-                // Read audio data
-                if (stream->available()) {
-                    size_t bytesRead = stream->readBytes(bhajanTempBuffer, BHAJAN_BUFFER_SIZE);
-                    
-                    if (bytesRead > 0) {
-                        // Apply volume scaling
-                        if (currentVolume < 100) {
-                            for (size_t i = 0; i + 1 < bytesRead; i += 2) {
-                                int16_t sample = (bhajanTempBuffer[i + 1] << 8) | bhajanTempBuffer[i];
-                                sample = (sample * currentVolume) / 100;
-                                bhajanTempBuffer[i] = sample & 0xFF;
-                                bhajanTempBuffer[i + 1] = (sample >> 8) & 0xFF;
-                            }
-                        }
+                // Download ahead into the ring as long as the server delivers,
+                // a chunk at a time so the mixer is never kept waiting for long
+                size_t downloaded = 0;
+                while (bhajanRing.space() >= BHAJAN_READ_SAMPLES && downloaded < BHAJAN_READ_SAMPLES * 8) {
+                    size_t bytesRead = 0;
+                    size_t n = readBhajanSamples(stream, bhajanChunk, BHAJAN_READ_SAMPLES, bytesRead);
+                    if (bytesRead == 0) {
+                        break;
+                    }
+                    bhajanRing.write(bhajanChunk, n);
+                    downloaded += n;
+
+                    // Update position
+                    xSemaphoreTake(bhajanMutex, portMAX_DELAY);
+                    currentBhajan.position += bytesRead;
+                    xSemaphoreGive(bhajanMutex);
+                }
 
-                        // Write to I2S
-                        i2s_write(I2S_PORT_OUT, bhajanTempBuffer, bytesRead, &bytesWritten, portMAX_DELAY);
-                        
-                        // Update position
-                        xSemaphoreTake(bhajanMutex, portMAX_DELAY);
-                        currentBhajan.position += bytesRead;
-                        xSemaphoreGive(bhajanMutex);
+                // A live stream runs at the server's clock and keeps the ring
+                // partly full; a file is downloaded ahead until the ring is full
+                bool throttled = bhajanRing.space() < BHAJAN_READ_SAMPLES;
+                int32_t fill = (int32_t)((uint64_t)bhajanRing.available() * SAMPLE_RATE / bhajanStreamRate);
+                // off speed the ring drains at the playback speed, not the server's clock
+                int32_t ppm = bhajanDrift.update(millis(), fill, !throttled && fill > 0 && !bhajanStretching);
+                if (ppm != bhajanResampler.rateAdjust()) {
+                    bhajanResampler.setRateAdjust(ppm);
+                }
+
+                // Feed the mixer from the ring; free frames pace this to the playback rate
+                bool fed = false;
+                while (bhajanRing.available() > 0) {
+                    PcmFrame *frame = bhajanFrames.acquire(0);
+                    if (!frame) {
+                        break; // mixer is busy with earlier frames
+                    }
+                    // Volume and ducking are applied by the mixer
+                    frame->count = fillBhajanFrame(frame->samples, frame->capacity);
+                    if (frame->count == 0) {
+                        bhajanFrames.release(frame); // the filter is still filling up
+                        break;
                     }
-                } else {
-                    // No data available, small delay
+                    bhajanFrames.submit(frame);
+                    notifySpeakerTask(SPEAKER_EVT_FRAME);
+                    fed = true;
+                }
+
+                if (!stream->connected() && !stream->available() && bhajanRing.available() == 0) {
+                    break; // stream finished and fully played
+                }
+                if (!fed && downloaded == 0) {
+                    // nothing to download and the mixer still has frames queued
                     vTaskDelay(10 / portTICK_PERIOD_MS);
                 }
                 
@@ -163,6 +322,9 @@ void streamBhajanAudio(const char* url) {
         }
     }
     
+    bhajanStretch.end();
+    bhajanStretching = false;
+
     if (playbackError) {
         Serial.println("Failed to stream bhajan audio after retries");
         currentBhajan.status = BHAJAN_STOPPED;
@@ -171,7 +333,12 @@ void streamBhajanAudio(const char* url) {
 }
 
 // Start bhajan playback
-void startBhajanPlayback(const char* url, const char* name, int id) {
+void startBhajanPlayback(const char* url, const char* name, int id, uint32_t sampleRate) {
+    // 0 means SAMPLE_RATE; anything else comes from the server and is checked
+    if (sampleRate && (sampleRate < BHAJAN_MIN_SAMPLE_RATE || sampleRate > BHAJAN_MAX_SAMPLE_RATE)) {
+        Serial.printf("Bhajan sample_rate %u Hz not supported, not playing\n", (unsigned)sampleRate);
+        return;
+    }
     xSemaphoreTake(bhajanMutex, portMAX_DELAY);
     
     // Stop any current playback
@@ -187,6 +354,7 @@ void startBhajanPlayback(const char* url, const char* name, int id) {
     currentBhajan.status = BHAJAN_STOPPED;
     currentBhajan.position = 0;
     currentBhajan.duration = 0;
+    currentBhajan.sample_rate = sampleRate ? sampleRate : SAMPLE_RATE;
     
     // Request playback start
     bhajanPlaybackRequested = true;
@@ -248,13 +416,13 @@ void stopBhajan() {
 }
 
 // Handle bhajan command from WebSocket
-void handleBhajanCommand(const char* command, int bhajanId, const char* url) {
+void handleBhajanCommand(const char* command, int bhajanId, const char* url, uint32_t sampleRate) {
     Serial.printf("Received bhajan command: %s, id: %d\n", command, bhajanId);
     
     if (strcmp(command, "play") == 0) {
         if (url) {
             // The name is not sent from the server, we can use a placeholder
-            startBhajanPlayback(url, "Playing Bhajan", bhajanId);
+            startBhajanPlayback(url, "Playing Bhajan", bhajanId, sampleRate);
         } else {
             // If no URL, maybe resume if paused? Or play default.
             // For now, we require a URL to play.
@@ -286,12 +454,25 @@ void setBhajanVolume(int volume) {
     }
 }
 
+// Set bhajan playback speed (0.5-2), keeping the pitch
+void setBhajanSpeed(float speed) {
+    if (speed < BHAJAN_MIN_SPEED) {
+        speed = BHAJAN_MIN_SPEED;
+    } else if (speed > BHAJAN_MAX_SPEED) {
+        speed = BHAJAN_MAX_SPEED;
+    }
+    bhajanSpeed = speed;
+    Serial.print("Bhajan speed set to: ");
+    Serial.println(speed);
+}
+
 // Play default bhajan
 void playDefaultBhajan() {
     // This would typically fetch the default bhajan from device settings
     // For now, we'll play the first available bhajan if URL is known
     if (currentBhajan.url.length() > 0) {
-        startBhajanPlayback(currentBhajan.url.c_str(), currentBhajan.name.c_str(), currentBhajan.id);
+        startBhajanPlayback(currentBhajan.url.c_str(), currentBhajan.name.c_str(), currentBhajan.id,
+                            currentBhajan.sample_rate);
     } else {
         Serial.println("No default bhajan URL available");
     }
@@ -334,6 +515,9 @@ void sendBhajanStatusUpdate() {
         doc["position"] = currentBhajan.position;
         doc["duration"] = currentBhajan.duration;
         doc["volume"] = currentVolume;
+        doc["speed"] = bhajanSpeed;
+        doc["sample_rate"] = currentBhajan.sample_rate;
+        doc["output_rate"] = outputSampleRate;
         
         String jsonString;
         serializeJson(doc, jsonString);
@@ -347,9 +531,10 @@ void handleBhajanPlayMessage(JsonDocument& doc) {
     const char* url = doc["url"];
     const char* name = doc["name"];
     int id = doc["bhajan_id"] | -1;
+    uint32_t sampleRate = doc["sample_rate"] | 0;
     
     if (url && name) {
-        startBhajanPlayback(url, name, id);
+        startBhajanPlayback(url, name, id, sampleRate);
     }
 }
 
@@ -357,7 +542,20 @@ void handleBhajanPlayMessage(JsonDocument& doc) {
 void handleBhajanControlMessage(JsonDocument& doc) {
     const char* action = doc["action"];
     
+    // "speed" may come alone or with an action, e.g. {"action":"resume","speed":0.75}
+    if (applyBhajanSpeed(doc) && !action) {
+        sendBhajanStatusUpdate();
+    }
     if (action) {
         handleBhajanCommand(action);
     }
+}
+
+// "speed" of a bhajan_command or bhajan_control message, if it has one
+bool applyBhajanSpeed(JsonDocument& doc) {
+    if (!doc["speed"].is<float>()) {
+        return false;
+    }
+    setBhajanSpeed(doc["speed"].as<float>());
+    return true;
 }
\ No newline at end of file
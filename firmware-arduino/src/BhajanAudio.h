@@ -7,6 +7,10 @@
 #include <driver/i2s.h>
 #include "Audio.h"
 #include "Config.h"
+#include "Resampler.h"
+#include "TieredRingBuffer.h"
+#include "DriftEstimator.h"
+#include "Wsola.h"
 
 // Bhajan playback states
 enum BhajanStatus {
@@ -23,6 +27,7 @@ struct BhajanInfo {
     BhajanStatus status;
     uint32_t position;
     uint32_t duration;
+    uint32_t sample_rate;  // of the stream, resampled to outputSampleRate when different
 };
 
 // Global bhajan state
@@ -30,28 +35,44 @@ extern BhajanInfo currentBhajan;
 extern bool bhajanPlaybackRequested;
 extern bool bhajanPlaybackActive;
 extern SemaphoreHandle_t bhajanMutex;
+extern DriftEstimator bhajanDrift;  // bhajanAudioTask only
+extern volatile float bhajanSpeed;  // playback tempo, 1 = as recorded; set by bhajan_command/bhajan_control "speed"
 
 // Function declarations
 void bhajanAudioTask(void *parameter);
 void initBhajanAudio();
-void startBhajanPlayback(const char* url, const char* name, int id = -1);
+void startBhajanPlayback(const char* url, const char* name, int id = -1, uint32_t sampleRate = 0);
 void pauseBhajan();
 void resumeBhajan();
 void stopBhajan();
-void handleBhajanCommand(const char* command, int bhajanId = -1, const char* url = nullptr);
+void handleBhajanCommand(const char* command, int bhajanId = -1, const char* url = nullptr, uint32_t sampleRate = 0);
 void streamBhajanAudio(const char* url);
 bool isBhajanPlaying();
 void setBhajanVolume(int volume);
+void setBhajanSpeed(float speed);
 void playDefaultBhajan();
 void handleBhajanButtonPress();
 
 // WebSocket message handlers
 void handleBhajanPlayMessage(JsonDocument& doc);
 void handleBhajanControlMessage(JsonDocument& doc);
+bool applyBhajanSpeed(JsonDocument& doc);
 
 // Audio streaming constants
-#define BHAJAN_BUFFER_SIZE 4096
 #define BHAJAN_STREAM_TIMEOUT 10000
+#define BHAJAN_RESAMPLE_QUALITY RESAMPLE_MEDIUM
+#define BHAJAN_MIN_SAMPLE_RATE 8000          // stream rates the server may ask for ("sample_rate")
+#define BHAJAN_MAX_SAMPLE_RATE 48000
+#define BHAJAN_READ_SAMPLES 512  // stream samples per HTTP read
+#define BHAJAN_RING_SAMPLES (24000 * 8)      // 8 s read-ahead at 24 kHz in PSRAM (384 KB)
+#define BHAJAN_RING_FALLBACK_SAMPLES 8192    // 0.34 s in internal RAM on boards without PSRAM
+#define BHAJAN_RING_HOT_SAMPLES 1024         // internal-RAM window the frames are filled from
 #define BHAJAN_RECONNECT_DELAY 3000
+// Time stretch for bhajanSpeed: WSOLA_MEDIUM at the output rate costs about
+// 1% of a core at 24 kHz (see test/wsola_test.cpp) and holds about 8 KB while engaged
+#define BHAJAN_STRETCH_QUALITY WSOLA_MEDIUM
+#define BHAJAN_STRETCH_BLOCK 256             // resampled samples per hand-over to the stretch
+#define BHAJAN_MIN_SPEED WSOLA_MIN_TEMPO
+#define BHAJAN_MAX_SPEED WSOLA_MAX_TEMPO
 
 #endif
\ No newline at end of file
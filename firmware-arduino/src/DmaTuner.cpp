@@ -0,0 +1,114 @@
+#include "DmaTuner.h"
+
+// Longest gap between two update() calls that still counts as streaming time
+static const uint32_t MAX_UPDATE_GAP_MS = 1000;
+
+void DmaTuner::begin(const DmaTunerConfig &config, DmaSettings initial) {
+    cfg = config;
+    _xruns = 0;
+    _grows = 0;
+    _shrinks = 0;
+    _grown = false;
+    _was_active = false;
+    _quiet_ms = 0;
+    _shrink_after_ms = cfg.shrink_after_ms;
+    set(initial);
+}
+
+void DmaTuner::set(DmaSettings settings) {
+    _settings = clamp(settings);
+    _quiet_ms = 0;
+}
+
+DmaSettings DmaTuner::clamp(DmaSettings s) const {
+    if (s.buffers < cfg.min_buffers) s.buffers = cfg.min_buffers;
+    if (s.buffers > cfg.max_buffers) s.buffers = cfg.max_buffers;
+    if (s.frames < cfg.min_frames) s.frames = cfg.min_frames;
+    if (s.frames > cfg.max_frames) s.frames = cfg.max_frames;
+    // over the total cap: give up buffers first, then length
+    while (!fits(s) && s.buffers > cfg.min_buffers) {
+        s.buffers--;
+    }
+    while (!fits(s) && s.frames > cfg.min_frames) {
+        s.frames = s.frames - cfg.frame_step >= cfg.min_frames ? s.frames - cfg.frame_step : cfg.min_frames;
+    }
+    return s;
+}
+
+bool DmaTuner::fits(const DmaSettings &s) const {
+    return cfg.max_total_frames == 0 || s.totalFrames() <= cfg.max_total_frames;
+}
+
+// More buffers first: same interrupt rate, more slack. Longer buffers once the count is maxed.
+bool DmaTuner::grow() {
+    DmaSettings next = _settings;
+    if (next.buffers < cfg.max_buffers) {
+        next.buffers++;
+    } else if (next.frames < cfg.max_frames) {
+        next.frames = next.frames + cfg.frame_step <= cfg.max_frames ? next.frames + cfg.frame_step : cfg.max_frames;
+    }
+    if (next == _settings || !fits(next)) {
+        return false;
+    }
+    _settings = next;
+    return true;
+}
+
+// The reverse of grow(): shorter buffers while the count is maxed, then fewer
+// buffers, and shorter ones again once the count is at its minimum.
+bool DmaTuner::shrink() {
+    DmaSettings next = _settings;
+    bool shorter = next.frames > cfg.min_frames && (next.buffers >= cfg.max_buffers || next.buffers <= cfg.min_buffers);
+    if (shorter) {
+        next.frames = next.frames - cfg.frame_step >= cfg.min_frames ? next.frames - cfg.frame_step : cfg.min_frames;
+    } else if (next.buffers > cfg.min_buffers) {
+        next.buffers--;
+    }
+    if (next == _settings) {
+        return false;
+    }
+    _settings = next;
+    return true;
+}
+
+bool DmaTuner::update(uint32_t now_ms, uint32_t xruns, bool active) {
+    uint32_t elapsed = _was_active && active ? now_ms - _last_update_ms : 0;
+    if (elapsed > MAX_UPDATE_GAP_MS) {
+        elapsed = 0;
+    }
+    _last_update_ms = now_ms;
+    _was_active = active;
+
+    bool xrun = xruns != _xruns;
+    _xruns = xruns;
+    if (!_auto) {
+        return false;
+    }
+
+    if (xrun) {
+        _quiet_ms = 0;
+        if (_grown && now_ms - _last_grow_ms < cfg.grow_hold_ms) {
+            return false; // still settling after the last grow
+        }
+        if (!grow()) {
+            return false;
+        }
+        _grows++;
+        _grown = true;
+        _last_grow_ms = now_ms;
+        // the last shrink went too far: wait longer before trying again
+        _shrink_after_ms = _shrink_after_ms * 2 <= cfg.max_shrink_after_ms ? _shrink_after_ms * 2 : cfg.max_shrink_after_ms;
+        return true;
+    }
+
+    _quiet_ms += elapsed;
+    if (_quiet_ms < _shrink_after_ms) {
+        return false;
+    }
+    _quiet_ms = 0;
+    if (!shrink()) {
+        return false;
+    }
+    _shrinks++;
+    return true;
+}
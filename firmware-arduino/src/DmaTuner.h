@@ -0,0 +1,75 @@
+#ifndef DMATUNER_H
+#define DMATUNER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Picks the I2S DMA ring size (buffer count x frames per buffer) for one stream.
+// Every xrun (output underrun or input overrun) grows the ring by one step;
+// after a long enough run without xruns it shrinks one step again, so each unit
+// settles on the smallest ring its scheduling and Wi-Fi load allow. Shrinking
+// backs off after every grow so the ring does not oscillate around the limit.
+// Plain C++ (no Arduino/FreeRTOS) so it can be exercised on the host.
+
+struct DmaSettings {
+    uint8_t buffers = 0;  // dma_buf_count
+    uint16_t frames = 0;  // dma_buf_len, frames per buffer
+    uint32_t totalFrames() const { return (uint32_t)buffers * frames; }
+    bool operator==(const DmaSettings &o) const { return buffers == o.buffers && frames == o.frames; }
+    bool operator!=(const DmaSettings &o) const { return !(*this == o); }
+};
+
+struct DmaTunerConfig {
+    uint8_t min_buffers = 2;
+    uint8_t max_buffers = 8;
+    uint16_t min_frames = 64;
+    uint16_t max_frames = 512;
+    uint16_t frame_step = 64;        // frames added or removed per step once the count is at its limit
+    uint32_t max_total_frames = 0;   // cap on buffers * frames, 0 = none
+    uint32_t grow_hold_ms = 2000;    // xruns within this time of a grow count as one
+    uint32_t shrink_after_ms = 60000; // streaming time without xruns before shrinking
+    uint32_t max_shrink_after_ms = 1800000;
+};
+
+class DmaTuner {
+public:
+    void begin(const DmaTunerConfig &config, DmaSettings initial);
+
+    // Replace the current settings, e.g. from NVS or the server; clamped to the limits.
+    void set(DmaSettings settings);
+    const DmaSettings &settings() const { return _settings; }
+
+    // With auto-tune off, update() only counts xruns.
+    void setAutoTune(bool enabled) { _auto = enabled; }
+    bool autoTune() const { return _auto; }
+
+    // Call regularly with the stream's cumulative xrun counter. `active` is true
+    // while the stream is running; only active time counts towards shrinking.
+    // Returns true when the settings changed and the stream should be reconfigured.
+    bool update(uint32_t now_ms, uint32_t xruns, bool active);
+
+    uint32_t xruns() const { return _xruns; }
+    uint32_t grows() const { return _grows; }
+    uint32_t shrinks() const { return _shrinks; }
+
+protected:
+    DmaTunerConfig cfg;
+    DmaSettings _settings;
+    bool _auto = true;
+    uint32_t _xruns = 0;
+    uint32_t _grows = 0;
+    uint32_t _shrinks = 0;
+    uint32_t _last_grow_ms = 0;
+    bool _grown = false;
+    uint32_t _last_update_ms = 0;
+    bool _was_active = false;
+    uint32_t _quiet_ms = 0;         // active time since the last xrun or change
+    uint32_t _shrink_after_ms = 0;  // current shrink delay, grows with every backoff
+
+    DmaSettings clamp(DmaSettings s) const;
+    bool fits(const DmaSettings &s) const;
+    bool grow();
+    bool shrink();
+};
+
+#endif
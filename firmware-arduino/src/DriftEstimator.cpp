@@ -0,0 +1,104 @@
+#include "DriftEstimator.h"
+
+void DriftEstimator::begin(const DriftEstimatorConfig &config) {
+    cfg = config;
+    if (cfg.sample_rate == 0) {
+        cfg.sample_rate = 24000;
+    }
+    if (cfg.window_ms == 0) {
+        cfg.window_ms = 1;
+    }
+    if (cfg.center_ms == 0) {
+        cfg.center_ms = 1;
+    }
+    _stats = DriftStats();
+    target = 0;
+    reset();
+}
+
+void DriftEstimator::reset() {
+    window_open = false;
+    have_prev = false;
+    _stats.fill_error = 0;
+    _stats.correction_ppm = clampPpm(_stats.drift_ppm);
+}
+
+int32_t DriftEstimator::update(uint32_t now_ms, int32_t fill, bool free_running) {
+    if (!window_open) {
+        window_open = true;
+        window_valid = true;
+        window_start_ms = now_ms;
+        fill_sum = 0;
+        fill_count = 0;
+    }
+    if (!free_running) {
+        window_valid = false;
+    }
+    fill_sum += fill;
+    fill_count++;
+
+    uint32_t len_ms = now_ms - window_start_ms;
+    if (len_ms < cfg.window_ms) {
+        return _stats.correction_ppm;
+    }
+    window_open = false;
+    int32_t mean = (int32_t)(fill_sum / fill_count);
+
+    if (!window_valid) {
+        // the fill says nothing about the clocks, keep correcting for the known drift only
+        _stats.skipped_windows++;
+        have_prev = false;
+        prev_correction = _stats.correction_ppm;
+        _stats.correction_ppm = clampPpm(_stats.drift_ppm);
+        return _stats.correction_ppm;
+    }
+
+    bool measured_ok = false;
+    if (have_prev) {
+        // window averages sit at the window midpoints; the correction changed at the boundary
+        int64_t span_ms = ((int64_t)prev_len_ms + len_ms) / 2;
+        int64_t slope_ppm = ((int64_t)mean - prev_mean) * 1000000000LL / ((int64_t)cfg.sample_rate * span_ms);
+        int64_t applied_ppm = ((int64_t)prev_correction + _stats.correction_ppm) / 2;
+        int64_t measured = applied_ppm + slope_ppm;
+
+        if (measured > cfg.max_drift_ppm || measured < -cfg.max_drift_ppm) {
+            // a burst or a refill faster than real time, not the clocks
+            _stats.skipped_windows++;
+        } else {
+            uint32_t weight = _stats.windows + 1;
+            if (weight > (1u << cfg.smoothing_shift)) {
+                weight = 1u << cfg.smoothing_shift;
+            }
+            _stats.drift_ppm += (int32_t)((measured - _stats.drift_ppm) / (int64_t)weight);
+            _stats.windows++;
+            measured_ok = true;
+        }
+    }
+
+    // a latched target waits for a steady window, not the initial burst
+    if (target == 0 && measured_ok) {
+        target = mean;
+    }
+    int64_t center_ppm = 0;
+    if (target != 0) {
+        _stats.fill_error = mean - target;
+        center_ppm = (int64_t)_stats.fill_error * 1000000000LL / ((int64_t)cfg.sample_rate * cfg.center_ms);
+    }
+
+    have_prev = true;
+    prev_mean = mean;
+    prev_len_ms = len_ms;
+    prev_correction = _stats.correction_ppm;
+    _stats.correction_ppm = clampPpm(_stats.drift_ppm + center_ppm);
+    return _stats.correction_ppm;
+}
+
+int32_t DriftEstimator::clampPpm(int64_t ppm) const {
+    if (ppm > cfg.max_ppm) {
+        return cfg.max_ppm;
+    }
+    if (ppm < -cfg.max_ppm) {
+        return -cfg.max_ppm;
+    }
+    return (int32_t)ppm;
+}
@@ -0,0 +1,81 @@
+#ifndef DRIFTESTIMATOR_H
+#define DRIFTESTIMATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Clock drift between a remote audio source and the local I2S clock, estimated
+// from the fill level of the buffer between them, and the playback rate
+// correction (for Resampler::setRateAdjust()) that keeps that buffer centred.
+//
+// Fill levels are averaged over fixed windows. The change between two window
+// averages, plus the correction applied meanwhile, is one drift measurement;
+// the drift estimate is a running mean of those (an exponential one once
+// 2^smoothing_shift windows are in). The correction is the drift estimate plus
+// a slow term that pulls the average fill back to the target, limited to
+// max_ppm. Windows in which the producer is not running at its own clock
+// (held back by a full buffer, or stalled so the buffer ran dry) are skipped,
+// and so are measurements beyond max_drift_ppm (bursts faster than real time).
+// Plain C++ (no Arduino/FreeRTOS) so it can be exercised on the host.
+
+struct DriftEstimatorConfig {
+    uint32_t sample_rate = 24000;  // of the fill level
+    uint32_t window_ms = 10000;    // fill averaging window
+    uint8_t smoothing_shift = 3;   // estimate follows new measurements by 1/8
+    uint32_t center_ms = 60000;    // time constant for pulling the fill back to the target
+    int32_t max_ppm = 300;         // correction limit, well below audible pitch change
+    int32_t max_drift_ppm = 1000;  // larger measurements are bursts or refills, not clocks
+};
+
+struct DriftStats {
+    int32_t drift_ppm = 0;         // source clock relative to ours, + = source is faster
+    int32_t correction_ppm = 0;    // + = playback consumes faster
+    int32_t fill_error = 0;        // last window's average fill minus the target, samples
+    uint32_t windows = 0;          // windows that contributed a measurement
+    uint32_t skipped_windows = 0;  // windows that said nothing about the clocks
+};
+
+class DriftEstimator {
+public:
+    void begin(const DriftEstimatorConfig &config);
+
+    // Start over after a discontinuity (new stream, new answer). The drift
+    // estimate is kept, the clocks do not change between streams.
+    void reset();
+
+    // Fill level to centre on, in samples. 0 latches the average of the first
+    // window that gave a plausible measurement.
+    void setTarget(int32_t fill) { target = fill; }
+    int32_t targetFill() const { return target; }
+
+    // Call whenever the fill level is known, at least a few times per second.
+    // `free_running` is false while the producer is throttled or stalled.
+    // Returns the correction in ppm; it only changes at window ends.
+    int32_t update(uint32_t now_ms, int32_t fill, bool free_running);
+
+    int32_t correctionPpm() const { return _stats.correction_ppm; }
+    int32_t driftPpm() const { return _stats.drift_ppm; }
+    const DriftStats &stats() const { return _stats; }
+
+protected:
+    DriftEstimatorConfig cfg;
+    DriftStats _stats;
+    int32_t target = 0;
+
+    // current window
+    bool window_open = false;
+    bool window_valid = true;
+    uint32_t window_start_ms = 0;
+    int64_t fill_sum = 0;
+    uint32_t fill_count = 0;
+
+    // previous window
+    bool have_prev = false;
+    int32_t prev_mean = 0;
+    uint32_t prev_len_ms = 0;
+    int32_t prev_correction = 0; // applied during the previous window
+
+    int32_t clampPpm(int64_t ppm) const;
+};
+
+#endif
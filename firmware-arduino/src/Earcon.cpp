@@ -0,0 +1,95 @@
+#include "Earcon.h"
+
+#include <array>
+
+// The clips are rendered by the compiler, so they ship as plain const PCM in
+// flash like a recorded one would; replace the array to use a recording.
+namespace {
+
+constexpr double PI_RAD = 3.14159265358979323846;
+
+constexpr double sineTurns(double turns) {
+  double x = 2 * PI_RAD * (turns - (double)(int64_t)turns);
+  if (x > PI_RAD) {
+    x -= 2 * PI_RAD;
+  }
+  // Taylor series to x^15, error below 1e-6 on [-pi, pi]
+  double term = x, sum = x;
+  for (int k = 1; k <= 7; k++) {
+    term *= -x * x / ((2 * k) * (2 * k + 1));
+    sum += term;
+  }
+  return sum;
+}
+
+// a soft chime: 8 ms attack, then a cubic decay to silence at the end of the note
+constexpr double note(size_t n, size_t start, size_t length, double freq, uint32_t rate) {
+  if (n < start || n >= start + length) {
+    return 0;
+  }
+  size_t t = n - start;
+  size_t attack = rate * 8 / 1000;
+  double env = t < attack ? (double)t / attack : 1.0;
+  double left = 1.0 - (double)t / length;
+  env *= left * left * left;
+  return env * (sineTurns(freq * t / rate) + 0.25 * sineTurns(2 * freq * t / rate));
+}
+
+constexpr uint32_t THINKING_RATE = 24000;
+constexpr size_t THINKING_SAMPLES = THINKING_RATE * 260 / 1000;
+
+constexpr std::array<int16_t, THINKING_SAMPLES> renderThinking() {
+  std::array<int16_t, THINKING_SAMPLES> pcm{};
+  const size_t first = THINKING_RATE * 160 / 1000;
+  const size_t second_start = THINKING_RATE * 100 / 1000;
+  for (size_t n = 0; n < THINKING_SAMPLES; n++) {
+    double v = note(n, 0, first, 587.33, THINKING_RATE) +                               // D5
+               note(n, second_start, THINKING_SAMPLES - second_start, 880.0, THINKING_RATE); // A5
+    pcm[n] = (int16_t)(v * 4000);  // about -20 dBFS, under the answer that follows
+  }
+  return pcm;
+}
+
+constexpr std::array<int16_t, THINKING_SAMPLES> THINKING_PCM = renderThinking();
+
+}  // namespace
+
+const EarconClip EARCON_THINKING = {THINKING_PCM.data(), THINKING_PCM.size(), THINKING_RATE, 1500};
+
+void EarconPlayer::start(const EarconClip *c, uint32_t output_rate) {
+  clip = c;
+  phase = 0;
+  step = output_rate ? (uint32_t)(((uint64_t)c->sample_rate << 16) / output_rate) : 1u << 16;
+  uint64_t length = (uint64_t)c->count << 16;
+  period = ((uint64_t)c->sample_rate * c->period_ms / 1000) << 16;
+  if (period < length) {
+    period = length;
+  }
+}
+
+size_t EarconPlayer::read(int16_t *out, size_t count) {
+  if (!clip) {
+    return 0;
+  }
+  const uint64_t length = (uint64_t)clip->count << 16;
+  for (size_t i = 0; i < count; i++) {
+    if (phase >= period) {
+      if (clip->period_ms == 0) {
+        clip = nullptr;
+        return i;
+      }
+      phase -= period;
+    }
+    int16_t s = 0;
+    if (phase < length) {
+      size_t idx = (size_t)(phase >> 16);
+      int32_t frac = (int32_t)(phase & 0xffff);
+      int32_t a = clip->samples[idx];
+      int32_t b = idx + 1 < clip->count ? clip->samples[idx + 1] : 0;
+      s = (int16_t)(a + (((b - a) * frac) >> 16));
+    }
+    out[i] = s;
+    phase += step;
+  }
+  return count;
+}
@@ -0,0 +1,40 @@
+#ifndef EARCON_H
+#define EARCON_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Short prompts played locally, without the network. A clip is raw PCM in a
+// const array, which the linker places in flash; it is read from there block by
+// block, so playing one needs neither heap nor a copy in RAM. Plain C++ so it
+// can be tested on the host.
+
+struct EarconClip {
+  const int16_t *samples;
+  size_t count;
+  uint32_t sample_rate;
+  uint32_t period_ms;  // the clip repeats every period_ms, silence in between; 0 = play once
+};
+
+// "Thinking" cue for the wait between AUDIO.COMMITTED and the first answer frame.
+extern const EarconClip EARCON_THINKING;
+
+// Reads a clip as a stream at the output rate. Other rates are converted by
+// linear interpolation with a Q16 phase, fine for the soft tones used here.
+class EarconPlayer {
+public:
+  void start(const EarconClip *clip, uint32_t output_rate);
+  void stop() { clip = nullptr; }
+  bool active() const { return clip != nullptr; }
+
+  // Fills up to `count` samples; returns fewer only when a one-shot clip ends.
+  size_t read(int16_t *out, size_t count);
+
+protected:
+  const EarconClip *clip = nullptr;
+  uint64_t phase = 0;   // position in the period, Q16 clip samples
+  uint32_t step = 0;    // Q16 clip samples per output sample
+  uint64_t period = 0;  // Q16, at least the clip length
+};
+
+#endif
@@ -0,0 +1,249 @@
+#include "JitterBuffer.h"
+#include <string.h>
+
+bool JitterBuffer::begin(const JitterBufferConfig &config) {
+    end();
+    cfg = config;
+    if (cfg.capacity == 0 || cfg.max_packet_bytes == 0) {
+        return false;
+    }
+    if (cfg.max_depth_ms < cfg.min_depth_ms) {
+        cfg.max_depth_ms = cfg.min_depth_ms;
+    }
+
+    slots = new Slot[cfg.capacity];
+    storage = new uint8_t[(size_t)cfg.capacity * cfg.max_packet_bytes];
+    _stats = JitterBufferStats();
+    reset();
+    return true;
+}
+
+void JitterBuffer::end() {
+    delete[] slots;
+    delete[] storage;
+    slots = nullptr;
+    storage = nullptr;
+    _count = 0;
+}
+
+void JitterBuffer::reset() {
+    for (size_t i = 0; slots && i < cfg.capacity; i++) {
+        slots[i].used = false;
+    }
+    state = FILLING;
+    _count = 0;
+    _depth_ms = 0;
+    next_seq_valid = false;
+    started = false;
+    have_arrival = false;
+    media_ms = 0;
+    peak_lateness_q4 = 0;
+    _target_ms = cfg.min_depth_ms;
+
+    // keep the jitter estimate across resets, the network does not change per turn
+    _stats.depth_ms = 0;
+    _stats.target_depth_ms = _target_ms;
+}
+
+bool JitterBuffer::push(uint16_t seq, const uint8_t *data, size_t len, uint16_t duration_ms, uint32_t now_ms) {
+    if (!slots) {
+        return false;
+    }
+    _stats.packets_received++;
+
+    // already played (or skipped as missing)
+    if (started && next_seq_valid && seqBefore(seq, next_seq)) {
+        _stats.late_packets++;
+        return false;
+    }
+    if (findSlot(seq) >= 0) {
+        _stats.late_packets++;
+        return false;
+    }
+    if (len > cfg.max_packet_bytes || isFull()) {
+        return false;
+    }
+
+    updateArrival(seq, duration_ms, now_ms);
+
+    int idx = -1;
+    for (size_t i = 0; i < cfg.capacity; i++) {
+        if (!slots[i].used) {
+            idx = (int)i;
+            break;
+        }
+    }
+    Slot &slot = slots[idx];
+    slot.used = true;
+    slot.seq = seq;
+    slot.len = (uint16_t)len;
+    slot.duration_ms = duration_ms;
+    memcpy(storage + (size_t)idx * cfg.max_packet_bytes, data, len);
+    _count++;
+    _depth_ms += duration_ms;
+
+    // before playout starts the stream begins at the lowest sequence number seen
+    if (!next_seq_valid || (!started && seqBefore(seq, next_seq))) {
+        next_seq = seq;
+        next_seq_valid = true;
+    }
+
+    if (state == DRAINED) {
+        _stats.underruns++;
+        state = FILLING;
+    }
+    if (state == FILLING && _count == 1) {
+        fill_start_ms = now_ms;
+    }
+
+    updateTarget(duration_ms);
+    _stats.depth_ms = _depth_ms;
+    if (_depth_ms > _stats.max_depth_seen_ms) {
+        _stats.max_depth_seen_ms = _depth_ms;
+    }
+    return true;
+}
+
+JitterBuffer::PopResult JitterBuffer::pop(uint32_t now_ms, uint8_t *out, size_t out_size, size_t &len, uint16_t &seq) {
+    len = 0;
+    if (!slots || _count == 0) {
+        if (state == PLAYING) {
+            state = DRAINED;
+        }
+        return POP_BUFFERING;
+    }
+
+    if (state != PLAYING) {
+        // Start once the target (or prebuffer) is reached, the slots are full, or the
+        // first packet has waited that long (short answers must not hang).
+        uint32_t threshold = _target_ms > cfg.prebuffer_ms ? _target_ms : cfg.prebuffer_ms;
+        bool deep_enough = _depth_ms >= threshold || isFull();
+        bool waited = (uint32_t)(now_ms - fill_start_ms) >= threshold;
+        if (!deep_enough && !waited) {
+            return POP_BUFFERING;
+        }
+        state = PLAYING;
+        started = true;
+    }
+
+    seq = next_seq;
+    next_seq++;
+
+    int idx = findSlot(seq);
+    if (idx < 0) {
+        return POP_MISSING;
+    }
+
+    Slot &slot = slots[idx];
+    if (slot.len <= out_size) {
+        memcpy(out, storage + (size_t)idx * cfg.max_packet_bytes, slot.len);
+        len = slot.len;
+    }
+    releaseSlot(idx);
+    _stats.packets_played++;
+    _stats.depth_ms = _depth_ms;
+    return len > 0 ? POP_PACKET : POP_MISSING;
+}
+
+bool JitterBuffer::peek(uint16_t seq, uint8_t *out, size_t out_size, size_t &len) const {
+    len = 0;
+    int idx = slots ? findSlot(seq) : -1;
+    if (idx < 0 || slots[idx].len > out_size) {
+        return false;
+    }
+    memcpy(out, storage + (size_t)idx * cfg.max_packet_bytes, slots[idx].len);
+    len = slots[idx].len;
+    return true;
+}
+
+bool JitterBuffer::dropOldest() {
+    int idx = oldestSlot();
+    if (idx < 0) {
+        return false;
+    }
+    uint16_t seq = slots[idx].seq;
+    releaseSlot(idx);
+    _stats.overflow_drops++;
+    _stats.depth_ms = _depth_ms;
+
+    // do not report the dropped packet as missing later on
+    if (next_seq_valid && !seqBefore(seq, next_seq)) {
+        next_seq = seq + 1;
+    }
+    return true;
+}
+
+int JitterBuffer::findSlot(uint16_t seq) const {
+    for (size_t i = 0; i < cfg.capacity; i++) {
+        if (slots[i].used && slots[i].seq == seq) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+int JitterBuffer::oldestSlot() const {
+    int oldest = -1;
+    for (size_t i = 0; i < cfg.capacity; i++) {
+        if (slots[i].used && (oldest < 0 || seqBefore(slots[i].seq, slots[oldest].seq))) {
+            oldest = (int)i;
+        }
+    }
+    return oldest;
+}
+
+void JitterBuffer::releaseSlot(int idx) {
+    slots[idx].used = false;
+    _count--;
+    _depth_ms -= slots[idx].duration_ms;
+}
+
+void JitterBuffer::updateArrival(uint16_t seq, uint16_t duration_ms, uint32_t now_ms) {
+    if (!have_arrival) {
+        have_arrival = true;
+        media_ms = 0;
+        min_delay_ms = (int32_t)now_ms;
+    } else {
+        int16_t seq_delta = (int16_t)(seq - last_seq);
+        if (seq_delta <= 0) {
+            // reordered packet, its timing says nothing about the path delay
+            return;
+        }
+        // RFC 3550: D = (arrival delta) - (media delta)
+        int32_t media_delta = (int32_t)seq_delta * last_duration_ms;
+        int32_t d = (int32_t)(now_ms - last_arrival_ms) - media_delta;
+        uint32_t abs_d_q4 = (uint32_t)(d < 0 ? -d : d) << 4;
+        jitter_q4 += ((int32_t)abs_d_q4 - (int32_t)jitter_q4) / 16;
+        media_ms += media_delta;
+    }
+
+    // Lateness relative to the earliest packet of the stream. Servers that send
+    // faster than real time only ever lower the baseline, so they do not inflate it.
+    int32_t delay = (int32_t)(now_ms - media_ms);
+    if (delay < min_delay_ms) {
+        min_delay_ms = delay;
+    }
+    uint32_t lateness_q4 = (uint32_t)(delay - min_delay_ms) << 4;
+    peak_lateness_q4 -= peak_lateness_q4 / 64;
+    if (lateness_q4 > peak_lateness_q4) {
+        peak_lateness_q4 = lateness_q4;
+    }
+
+    last_arrival_ms = now_ms;
+    last_seq = seq;
+    last_duration_ms = duration_ms;
+    _stats.jitter_ms = jitter_q4 >> 4;
+}
+
+void JitterBuffer::updateTarget(uint16_t packet_ms) {
+    // one packet of headroom on top of the worst recent lateness
+    uint32_t target = (peak_lateness_q4 >> 4) + packet_ms;
+    if (target < cfg.min_depth_ms) {
+        target = cfg.min_depth_ms;
+    }
+    if (target > cfg.max_depth_ms) {
+        target = cfg.max_depth_ms;
+    }
+    _target_ms = target;
+    _stats.target_depth_ms = target;
+}
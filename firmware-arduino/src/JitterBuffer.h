@@ -0,0 +1,119 @@
+#ifndef JITTERBUFFER_H
+#define JITTERBUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Packet-level jitter buffer for the Opus downlink.
+// Holds whole Opus packets ordered by sequence number and starts playout once the
+// buffered duration reaches an adaptive target depth. Plain C++ (no Arduino/FreeRTOS)
+// so it can be exercised on the host; callers serialize access themselves.
+
+struct JitterBufferConfig {
+    uint16_t capacity = 16;          // packet slots
+    uint16_t max_packet_bytes = 400; // bytes per slot
+    uint16_t min_depth_ms = 40;      // lower bound for the target depth
+    uint16_t max_depth_ms = 600;     // upper bound for the target depth
+    uint16_t prebuffer_ms = 0;       // audio to hold before (re)starting playout, 0 = target only
+};
+
+struct JitterBufferStats {
+    uint32_t packets_received = 0;
+    uint32_t packets_played = 0;
+    uint32_t underruns = 0;        // playout ran dry and more data arrived afterwards
+    uint32_t late_packets = 0;     // arrived after their slot was played, or duplicates
+    uint32_t overflow_drops = 0;   // dropped by the caller via dropOldest()
+    uint32_t depth_ms = 0;         // currently buffered audio
+    uint32_t max_depth_seen_ms = 0;
+    uint32_t target_depth_ms = 0;
+    uint32_t jitter_ms = 0;        // smoothed inter-arrival jitter (RFC 3550 filter)
+};
+
+class JitterBuffer {
+public:
+    enum PopResult {
+        POP_PACKET,    // a packet was copied out
+        POP_MISSING,   // the next sequence number is missing but later packets exist
+        POP_BUFFERING  // nothing to play yet (filling up or ran dry)
+    };
+
+    JitterBuffer() = default;
+    ~JitterBuffer() { end(); }
+
+    bool begin(const JitterBufferConfig &config);
+    void end();
+
+    // Drop all packets and timing history, e.g. at the start of a new response.
+    void reset();
+
+    // Playout (re)starts once max(target depth, prebuffer) is buffered.
+    void setPrebufferMs(uint16_t ms) { cfg.prebuffer_ms = ms; }
+    uint16_t prebufferMs() const { return cfg.prebuffer_ms; }
+
+    // Store a packet. Returns false for late/duplicate/oversized packets and when
+    // all slots are taken; in the latter case the caller decides whether to wait
+    // for the consumer or call dropOldest().
+    bool push(uint16_t seq, const uint8_t *data, size_t len, uint16_t duration_ms, uint32_t now_ms);
+
+    // Fetch the next packet in sequence order. On POP_MISSING `seq` holds the
+    // missing sequence number so the caller can conceal it.
+    PopResult pop(uint32_t now_ms, uint8_t *out, size_t out_size, size_t &len, uint16_t &seq);
+
+    // Copy a queued packet without removing it, e.g. to read FEC data ahead of time.
+    bool peek(uint16_t seq, uint8_t *out, size_t out_size, size_t &len) const;
+
+    bool dropOldest();
+    bool isFull() const { return _count >= cfg.capacity; }
+
+    const JitterBufferStats &stats() const { return _stats; }
+    size_t packetCount() const { return _count; }
+    uint32_t depthMs() const { return _depth_ms; }
+    uint32_t targetDepthMs() const { return _target_ms; }
+
+protected:
+    struct Slot {
+        bool used;
+        uint16_t seq;
+        uint16_t len;
+        uint16_t duration_ms;
+    };
+
+    enum State {
+        FILLING,  // waiting for the target depth before (re)starting playout
+        PLAYING,
+        DRAINED   // ran empty while playing; counts as an underrun if data follows
+    };
+
+    JitterBufferConfig cfg;
+    Slot *slots = nullptr;
+    uint8_t *storage = nullptr;
+    JitterBufferStats _stats;
+
+    State state = FILLING;
+    size_t _count = 0;
+    uint32_t _depth_ms = 0;
+    uint32_t _target_ms = 0;
+    uint32_t fill_start_ms = 0;
+    uint16_t next_seq = 0;
+    bool next_seq_valid = false;
+    bool started = false;
+
+    // arrival timing
+    bool have_arrival = false;
+    uint32_t last_arrival_ms = 0;
+    uint16_t last_seq = 0;
+    uint16_t last_duration_ms = 0;
+    uint32_t media_ms = 0;         // media clock advanced by packet durations
+    int32_t min_delay_ms = 0;      // smallest arrival-minus-media offset seen
+    uint32_t peak_lateness_q4 = 0; // decaying peak of late arrival, 1/16 ms
+    uint32_t jitter_q4 = 0;        // RFC 3550 jitter, 1/16 ms
+
+    int findSlot(uint16_t seq) const;
+    int oldestSlot() const;
+    void releaseSlot(int idx);
+    void updateArrival(uint16_t seq, uint16_t duration_ms, uint32_t now_ms);
+    void updateTarget(uint16_t packet_ms);
+    static bool seqBefore(uint16_t a, uint16_t b) { return (int16_t)(a - b) < 0; }
+};
+
+#endif
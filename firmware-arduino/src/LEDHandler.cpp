@@ -1,4 +1,5 @@
 #include "LEDHandler.h"
+#include "Audio.h"
 
 int brightness = 0;
 int fadeAmount = 5;
@@ -304,10 +305,107 @@ void loopCyanyellowYellowPulse(unsigned long currentTime)
     }
 }
 
+// --- level-driven colour for SPEAKING and LISTENING -------------------------
+//
+// ledTask reads the block levels audioStreamTask and micTask publish, so the
+// effect costs no pass over the audio of its own. Everything ledTask shows goes
+// through LEDC (analogWrite): once a pin is attached to LEDC, digitalWrite no
+// longer drives it, so the static colours are written the same way.
+
+constexpr float VU_FLOOR_DBFS = -50;    // at or below this only the breathing shows
+constexpr float VU_FULL_DBFS = -12;     // full brightness, about loud speech
+constexpr uint8_t VU_DECAY_PER_TICK = 6; // full to dark in about 0.85 s at 20 ms ticks
+constexpr uint8_t BREATH_MIN = 12;
+constexpr uint8_t BREATH_MAX = 64;
+constexpr unsigned long BREATH_PERIOD_MS = 3000;
+
+struct ChannelMask {
+    bool red;
+    bool green;
+    bool blue;
+};
+
+static ChannelMask channelsOf(StaticColor color)
+{
+    switch (color)
+    {
+    case StaticColor::RED:
+        return {true, false, false};
+    case StaticColor::GREEN:
+        return {false, true, false};
+    case StaticColor::BLUE:
+        return {false, false, true};
+    case StaticColor::YELLOW:
+        return {true, true, false};
+    case StaticColor::MAGENTA:
+        return {true, false, true};
+    case StaticColor::CYAN:
+        return {false, true, true};
+    default:
+        return {false, false, false};
+    }
+}
+
+// `level` 0..255 on the colour's channels, the others off; the LED is active-low
+static void writeColorLevel(StaticColor color, uint8_t level)
+{
+    ChannelMask on = channelsOf(color);
+    analogWrite(RED_LED_PIN, on.red ? 255 - level : 255);
+    analogWrite(GREEN_LED_PIN, on.green ? 255 - level : 255);
+    analogWrite(BLUE_LED_PIN, on.blue ? 255 - level : 255);
+}
+
+// 0..255 for the RMS of the newest block, squared so it looks even to the eye
+static uint8_t vuLevel(const LevelMeter &meter, uint32_t &lastBlock)
+{
+    uint32_t block = meter.blockCount();
+    if (block == lastBlock)
+    {
+        return 0; // nothing new since the last tick, the stream has stopped
+    }
+    lastBlock = block;
+    uint16_t rms = meter.current().rms;
+    if (rms == 0)
+    {
+        return 0;
+    }
+    float db = 20 * log10f(rms / 32768.0f);
+    float x = (db - VU_FLOOR_DBFS) / (VU_FULL_DBFS - VU_FLOOR_DBFS);
+    x = x < 0 ? 0 : (x > 1 ? 1 : x);
+    return (uint8_t)(255 * x * x);
+}
+
+// triangle between BREATH_MIN and BREATH_MAX
+static uint8_t breathLevel(unsigned long now)
+{
+    unsigned long t = now % BREATH_PERIOD_MS;
+    unsigned long half = BREATH_PERIOD_MS / 2;
+    unsigned long ramp = t < half ? t : BREATH_PERIOD_MS - t;
+    return BREATH_MIN + (uint8_t)((BREATH_MAX - BREATH_MIN) * ramp / half);
+}
+
+// fast attack, slow decay, never below the breathing
+static uint8_t followLevel(uint8_t &envelope, uint8_t target, unsigned long now)
+{
+    if (target >= envelope)
+    {
+        envelope = target;
+    }
+    else
+    {
+        envelope = envelope > VU_DECAY_PER_TICK ? envelope - VU_DECAY_PER_TICK : 0;
+    }
+    uint8_t breath = breathLevel(now);
+    return envelope > breath ? envelope : breath;
+}
+
 void ledTask(void *parameter)
 {
     setupRGBLED();
     unsigned long currentTime = 0;
+    uint8_t envelope = 0;
+    uint32_t lastSpeakerBlock = speakerLevels.blockCount();
+    uint32_t lastMicBlock = micLevels.blockCount();
     while (1)
     {
         currentTime += 20; // Track time based on vTaskDelay
@@ -319,28 +417,32 @@ void ledTask(void *parameter)
             lastToggle = currentTime;
         }
 
+        // read both meters every tick so a state change starts from fresh levels
+        uint8_t speakerVu = vuLevel(speakerLevels, lastSpeakerBlock);
+        uint8_t micVu = vuLevel(micLevels, lastMicBlock);
+
         switch (deviceState)
         {
         case IDLE:
-            setStaticColor(StaticColor::GREEN);
+            writeColorLevel(StaticColor::GREEN, 255);
             break;
         case SOFT_AP:
-            setStaticColor(StaticColor::MAGENTA);
+            writeColorLevel(StaticColor::MAGENTA, 255);
             break;
         case PROCESSING:
-            setStaticColor(StaticColor::RED);
+            writeColorLevel(StaticColor::RED, 255);
             break;
         case SPEAKING:
-            setStaticColor(StaticColor::BLUE);
+            writeColorLevel(StaticColor::BLUE, followLevel(envelope, speakerVu, currentTime));
             break;
         case LISTENING:
-            setStaticColor(StaticColor::YELLOW);
+            writeColorLevel(StaticColor::YELLOW, followLevel(envelope, micVu, currentTime));
             break;
         case OTA:
-            setStaticColor(StaticColor::CYAN);
+            writeColorLevel(StaticColor::CYAN, 255);
             break;
         default:
-            setStaticColor(StaticColor::GREEN); // LED on
+            writeColorLevel(StaticColor::GREEN, 255); // LED on
             break;
         }
 
@@ -0,0 +1,45 @@
+#ifndef LEVELMETER_H
+#define LEVELMETER_H
+
+#include <atomic>
+#include <stdint.h>
+#include "AudioDsp.h"
+
+// Block levels of one audio stream, published by the task that processes the
+// stream (once per block, from a pass it already makes) and read by any other
+// task without a lock. The latest peak and RMS share one word so a reader never
+// sees them from different blocks; the counters only ever grow.
+class LevelMeter {
+public:
+  // Writer task only.
+  void publish(const DspLevels &levels) {
+    latest.store((uint32_t)levels.rms << 16 | levels.peak, std::memory_order_relaxed);
+    blocks.store(blocks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (levels.clipped) {
+      clipped_samples.store(clipped_samples.load(std::memory_order_relaxed) + levels.clipped,
+                            std::memory_order_relaxed);
+      clipped_blocks.store(clipped_blocks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+  }
+
+  // Peak and RMS of the most recent block; `clipped` is left 0.
+  DspLevels current() const {
+    uint32_t v = latest.load(std::memory_order_relaxed);
+    DspLevels levels;
+    levels.peak = v & 0xffff;
+    levels.rms = v >> 16;
+    return levels;
+  }
+
+  uint32_t blockCount() const { return blocks.load(std::memory_order_relaxed); }
+  uint32_t clippedSamples() const { return clipped_samples.load(std::memory_order_relaxed); }
+  uint32_t clippedBlocks() const { return clipped_blocks.load(std::memory_order_relaxed); }
+
+protected:
+  std::atomic<uint32_t> latest{0};  // rms << 16 | peak
+  std::atomic<uint32_t> blocks{0};
+  std::atomic<uint32_t> clipped_samples{0};
+  std::atomic<uint32_t> clipped_blocks{0};
+};
+
+#endif
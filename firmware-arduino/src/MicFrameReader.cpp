@@ -0,0 +1,61 @@
+#include "MicFrameReader.h"
+#include <stdlib.h>
+
+bool MicFrameReader::begin(SpscRing *r, size_t max_frame_bytes) {
+  end();
+  if (!r || max_frame_bytes == 0) {
+    return false;
+  }
+  scratch = (uint8_t *)malloc(max_frame_bytes);
+  if (!scratch) {
+    return false;
+  }
+  ring = r;
+  max_bytes = max_frame_bytes;
+  frame_bytes = max_frame_bytes;
+  copied = 0;
+  return true;
+}
+
+void MicFrameReader::end() {
+  free(scratch);
+  scratch = nullptr;
+  ring = nullptr;
+  held = nullptr;
+}
+
+void MicFrameReader::setFrameBytes(size_t bytes) {
+  if (held || bytes == 0) {
+    return;
+  }
+  frame_bytes = bytes < max_bytes ? bytes : max_bytes;
+}
+
+const uint8_t *MicFrameReader::peekFrame() {
+  if (held || !ring) {
+    return held;
+  }
+  if (ring->available() < frame_bytes) {
+    return nullptr;
+  }
+  size_t len;
+  const uint8_t *data = ring->peek(len);
+  if (len >= frame_bytes) {
+    held = data;
+  } else {
+    ring->read(scratch, frame_bytes);
+    copied++;
+    held = scratch;
+  }
+  return held;
+}
+
+void MicFrameReader::consumeFrame() {
+  if (!held) {
+    return;
+  }
+  if (held != scratch) {
+    ring->consume(frame_bytes);
+  }
+  held = nullptr;
+}
@@ -0,0 +1,52 @@
+#ifndef MICFRAMEREADER_H
+#define MICFRAMEREADER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "SpscRing.h"
+
+// Consumer side of the PCM mic uplink: hands out micRing one whole frame at a
+// time, so every binary message carries exactly one frame of audio instead of
+// whatever the ring held when networkTask came round. A frame is sent straight
+// out of the ring when it is contiguous and copied into a buffer allocated by
+// begin() when it straddles the wrap point. Plain C++ so it can be tested on
+// the host.
+class MicFrameReader {
+public:
+  ~MicFrameReader() { end(); }
+
+  bool begin(SpscRing *ring, size_t max_frame_bytes);
+  void end();
+
+  // Forget a frame handed out but not consumed, e.g. after the ring was cleared.
+  void reset() { held = nullptr; }
+
+  // Bytes per frame, up to max_frame_bytes; ignored while a frame is held.
+  void setFrameBytes(size_t bytes);
+  size_t frameBytes() const { return frame_bytes; }
+
+  // The next complete frame, or nullptr until one has been committed. Returns
+  // the same frame until consumeFrame().
+  const uint8_t *peekFrame();
+  void consumeFrame();
+
+  uint32_t copiedFrames() const { return copied; }  // frames that straddled the wrap point
+
+protected:
+  SpscRing *ring = nullptr;
+  uint8_t *scratch = nullptr;
+  size_t max_bytes = 0;
+  size_t frame_bytes = 0;
+  const uint8_t *held = nullptr;  // in the ring, or `scratch` once already consumed from it
+  uint32_t copied = 0;
+};
+
+// Bytes a client binary WebSocket message of `payload` bytes takes on the wire:
+// the frame header and mask key, a TLS 1.2 AES-GCM record when `tls`, and the
+// TCP/IPv4 headers of the segment it goes out in.
+inline size_t wsUplinkWireBytes(size_t payload, bool tls) {
+  size_t ws = 2 + 4 + (payload > 65535 ? 8 : (payload > 125 ? 2 : 0));
+  return payload + ws + (tls ? 5 + 8 + 16 : 0) + 40;
+}
+
+#endif
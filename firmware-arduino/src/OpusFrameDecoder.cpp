@@ -0,0 +1,67 @@
+#include "OpusFrameDecoder.h"
+
+bool OpusFrameDecoder::begin(uint32_t sample_rate, int channels, int frame_ms) {
+  end();
+  int err = OPUS_OK;
+  this->channels = channels;
+  dec = opus_decoder_create(sample_rate, channels, &err);
+  if (err != OPUS_OK) {
+    Serial.printf("opus_decoder_create failed: %d\n", err);
+    dec = nullptr;
+    return false;
+  }
+  last_samples = sample_rate * frame_ms / 1000; // until the first packet tells us otherwise
+  return true;
+}
+
+void OpusFrameDecoder::end() {
+  if (dec) {
+    opus_decoder_destroy(dec);
+    dec = nullptr;
+  }
+}
+
+void OpusFrameDecoder::reset() {
+  if (dec) {
+    opus_decoder_ctl(dec, OPUS_RESET_STATE);
+  }
+}
+
+int OpusFrameDecoder::decode(const uint8_t *packet, size_t len, int16_t *pcm, int max_samples) {
+  if (!dec) {
+    return 0;
+  }
+  int samples = opus_decode(dec, packet, len, pcm, max_samples / channels, 0);
+  if (samples < 0) {
+    Serial.printf("opus_decode failed: %d\n", samples);
+    return 0;
+  }
+  last_samples = samples;
+  decoded++;
+  return samples;
+}
+
+int OpusFrameDecoder::conceal(int16_t *pcm, int samples) {
+  if (!dec) {
+    return 0;
+  }
+  int result = opus_decode(dec, nullptr, 0, pcm, samples, 0);
+  if (result < 0) {
+    return 0;
+  }
+  concealed++;
+  return result;
+}
+
+int OpusFrameDecoder::recover(const uint8_t *next_packet, size_t len, int16_t *pcm, int samples) {
+  if (!dec) {
+    return 0;
+  }
+  // frame_size must match the lost packet; decode_fec=1 uses the LBRR data of the next one
+  int result = opus_decode(dec, next_packet, len, pcm, samples, 1);
+  if (result <= 0) {
+    return conceal(pcm, samples);
+  }
+  recovered++;
+  return result;
+}
@@ -0,0 +1,44 @@
+#ifndef OPUSFRAMEDECODER_H
+#define OPUSFRAMEDECODER_H
+
+#include <Arduino.h>
+#include "opus.h"
+
+// Thin wrapper around the libopus decoder for the speaker path.
+// Unlike OpusAudioDecoder it exposes packet loss concealment (decode with a
+// null packet) and in-band FEC recovery from the following packet.
+class OpusFrameDecoder {
+public:
+  ~OpusFrameDecoder() { end(); }
+
+  // `frame_ms` sizes concealed frames until the first packet arrives.
+  bool begin(uint32_t sample_rate, int channels, int frame_ms = 20);
+  void end();
+  void reset();
+
+  // Decode one packet into `pcm`. Returns the number of samples per channel, 0 on error.
+  int decode(const uint8_t *packet, size_t len, int16_t *pcm, int max_samples);
+
+  // Synthesize `samples` of audio for a lost packet (Opus PLC).
+  int conceal(int16_t *pcm, int samples);
+
+  // Rebuild a lost packet from the FEC data carried in the packet that follows it.
+  int recover(const uint8_t *next_packet, size_t len, int16_t *pcm, int samples);
+
+  // Duration of the last packet handled, used as the size of concealed frames.
+  int lastFrameSamples() const { return last_samples; }
+
+  uint32_t decodedFrames() const { return decoded; }
+  uint32_t concealedFrames() const { return concealed; }
+  uint32_t recoveredFrames() const { return recovered; }
+
+protected:
+  OpusDecoder *dec = nullptr;
+  int channels = 1;
+  int last_samples = 0;
+  uint32_t decoded = 0;
+  uint32_t concealed = 0;
+  uint32_t recovered = 0;
+};
+
+#endif
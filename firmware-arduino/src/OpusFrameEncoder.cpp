@@ -0,0 +1,69 @@
+#include "OpusFrameEncoder.h"
+
+bool OpusFrameEncoder::begin(uint32_t sample_rate, int frame_ms, uint32_t bitrate, int complexity) {
+  end();
+  if (frame_ms != 10 && frame_ms != 20 && frame_ms != 40 && frame_ms != 60) {
+    return false;
+  }
+  int err = OPUS_OK;
+  enc = opus_encoder_create(sample_rate, 1, OPUS_APPLICATION_VOIP, &err);
+  if (err != OPUS_OK) {
+    enc = nullptr;
+    return false;
+  }
+  opus_encoder_ctl(enc, OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+  opus_encoder_ctl(enc, OPUS_SET_VBR(1));
+  frame_samples = sample_rate * frame_ms / 1000;
+  encoded = failed = 0;
+  return setBitrate(bitrate) && setComplexity(complexity);
+}
+
+void OpusFrameEncoder::end() {
+  if (enc) {
+    opus_encoder_destroy(enc);
+    enc = nullptr;
+  }
+}
+
+void OpusFrameEncoder::reset() {
+  if (enc) {
+    opus_encoder_ctl(enc, OPUS_RESET_STATE);
+  }
+}
+
+bool OpusFrameEncoder::setBitrate(uint32_t bitrate) {
+  if (!enc || opus_encoder_ctl(enc, OPUS_SET_BITRATE((opus_int32)bitrate)) != OPUS_OK) {
+    return false;
+  }
+  bitrate_bps = bitrate;
+  return true;
+}
+
+bool OpusFrameEncoder::setComplexity(int complexity) {
+  if (!enc || opus_encoder_ctl(enc, OPUS_SET_COMPLEXITY(complexity)) != OPUS_OK) {
+    return false;
+  }
+  complexity_level = complexity;
+  return true;
+}
+
+int OpusFrameEncoder::lookaheadSamples() const {
+  opus_int32 lookahead = 0;
+  if (enc) {
+    opus_encoder_ctl(enc, OPUS_GET_LOOKAHEAD(&lookahead));
+  }
+  return lookahead;
+}
+
+size_t OpusFrameEncoder::encode(const int16_t *pcm, uint8_t *packet, size_t capacity) {
+  if (!enc) {
+    return 0;
+  }
+  opus_int32 len = opus_encode(enc, pcm, (int)frame_samples, packet, (opus_int32)capacity);
+  if (len < 0) {
+    failed++;
+    return 0;
+  }
+  encoded++;
+  return (size_t)len;
+}
@@ -0,0 +1,47 @@
+#ifndef OPUSFRAMEENCODER_H
+#define OPUSFRAMEENCODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "opus.h"
+
+// Thin wrapper around the libopus encoder for the mic uplink: VOIP application,
+// voice signal, one fixed-length frame per packet. Needs only libopus, so it
+// can be benchmarked on the host.
+//
+// opus_encode() runs on the caller's stack, which needs to be large: on the
+// device that is micEncodeTask's (see MIC_ENCODER_STACK_BYTES).
+class OpusFrameEncoder {
+public:
+  ~OpusFrameEncoder() { end(); }
+
+  // `frame_ms` is one of 10, 20, 40 or 60; `complexity` 0..10.
+  bool begin(uint32_t sample_rate, int frame_ms, uint32_t bitrate, int complexity);
+  void end();
+  void reset();
+
+  // Take effect from the next frame.
+  bool setBitrate(uint32_t bitrate);
+  bool setComplexity(int complexity);
+
+  // Encode exactly frameSamples() of mono PCM. Returns the packet length, 0 on error.
+  size_t encode(const int16_t *pcm, uint8_t *packet, size_t capacity);
+
+  size_t frameSamples() const { return frame_samples; }
+  // Samples the encoder holds back on top of the frame itself.
+  int lookaheadSamples() const;
+  uint32_t bitrate() const { return bitrate_bps; }
+  int complexity() const { return complexity_level; }
+  uint32_t encodedFrames() const { return encoded; }
+  uint32_t errors() const { return failed; }
+
+protected:
+  OpusEncoder *enc = nullptr;
+  size_t frame_samples = 0;
+  uint32_t bitrate_bps = 0;
+  int complexity_level = 0;
+  uint32_t encoded = 0;
+  uint32_t failed = 0;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#include "PcmFramePool.h"
+#include "AudioDsp.h"
+
+bool PcmFramePool::begin(size_t frames, size_t samples_per_frame) {
+  end();
+  this->frames = new PcmFrame[frames];
+  // Every frame starts on a DSP_ALIGN_BYTES boundary so the mixer can use the
+  // SIMD path: round the stride up and over-allocate to align the first frame.
+  constexpr size_t align_samples = DSP_ALIGN_BYTES / sizeof(int16_t);
+  size_t stride = (samples_per_frame + align_samples - 1) / align_samples * align_samples;
+  storage = new int16_t[frames * stride + align_samples];
+  int16_t *base = (int16_t *)(((uintptr_t)storage + DSP_ALIGN_BYTES - 1) & ~(uintptr_t)(DSP_ALIGN_BYTES - 1));
+  free_list = xQueueCreate(frames, sizeof(PcmFrame *));
+  ready = xQueueCreate(frames, sizeof(PcmFrame *));
+  if (!free_list || !ready) {
+    end();
+    return false;
+  }
+
+  count = frames;
+  for (size_t i = 0; i < frames; i++) {
+    PcmFrame *frame = &this->frames[i];
+    frame->samples = base + i * stride;
+    frame->capacity = samples_per_frame;
+    frame->count = 0;
+    frame->timestamp_us = 0;
+    xQueueSend(free_list, &frame, 0);
+  }
+  return true;
+}
+
+void PcmFramePool::end() {
+  if (free_list) {
+    vQueueDelete(free_list);
+    free_list = nullptr;
+  }
+  if (ready) {
+    vQueueDelete(ready);
+    ready = nullptr;
+  }
+  delete[] frames;
+  delete[] storage;
+  frames = nullptr;
+  storage = nullptr;
+  count = 0;
+}
+
+PcmFrame *PcmFramePool::acquire(TickType_t wait) {
+  PcmFrame *frame = nullptr;
+  if (free_list && xQueueReceive(free_list, &frame, wait) == pdTRUE) {
+    frame->count = 0;
+    return frame;
+  }
+  return nullptr;
+}
+
+void PcmFramePool::submit(PcmFrame *frame) {
+  xQueueSend(ready, &frame, portMAX_DELAY); // cannot block: there are only `count` frames
+}
+
+PcmFrame *PcmFramePool::receive(TickType_t wait) {
+  PcmFrame *frame = nullptr;
+  if (ready && xQueueReceive(ready, &frame, wait) == pdTRUE) {
+    return frame;
+  }
+  return nullptr;
+}
+
+void PcmFramePool::release(PcmFrame *frame) {
+  xQueueSend(free_list, &frame, portMAX_DELAY);
+}
+
+size_t PcmFramePool::flush() {
+  PcmFrame *frame = nullptr;
+  size_t flushed = 0;
+  while (ready && xQueueReceive(ready, &frame, 0) == pdTRUE) {
+    release(frame);
+    flushed++;
+  }
+  return flushed;
+}
@@ -0,0 +1,43 @@
+#ifndef PCMFRAMEPOOL_H
+#define PCMFRAMEPOOL_H
+
+#include <Arduino.h>
+
+// One block of 16-bit PCM. Frames never move; only pointers are passed around.
+struct PcmFrame {
+  int16_t *samples;
+  size_t capacity; // samples the frame can hold
+  size_t count;    // samples currently valid
+  uint32_t timestamp_us; // micros() of the first sample, for producers that track it
+};
+
+// Fixed set of preallocated PCM frames shared by one producer and one consumer.
+// The producer acquire()s a free frame, fills it in place and submit()s it; the
+// consumer receive()s it, processes it in place and release()s it back.
+class PcmFramePool {
+public:
+  ~PcmFramePool() { end(); }
+
+  bool begin(size_t frames, size_t samples_per_frame);
+  void end();
+
+  PcmFrame *acquire(TickType_t wait);
+  void submit(PcmFrame *frame);
+  PcmFrame *receive(TickType_t wait);
+  void release(PcmFrame *frame);
+
+  // Return every submitted but unplayed frame to the free list; returns how many.
+  size_t flush();
+
+  size_t readyCount() const { return ready ? uxQueueMessagesWaiting(ready) : 0; }
+  size_t frameCount() const { return count; }
+
+protected:
+  PcmFrame *frames = nullptr;
+  int16_t *storage = nullptr;
+  size_t count = 0;
+  QueueHandle_t free_list = nullptr;
+  QueueHandle_t ready = nullptr;
+};
+
+#endif
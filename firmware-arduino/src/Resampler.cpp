@@ -0,0 +1,231 @@
+#include "Resampler.h"
+#include <math.h>
+#include <string.h>
+
+struct ResamplePreset {
+  int taps;
+  int phases;
+  bool interpolate;
+  double bandwidth; // passband edge as a fraction of the lower Nyquist frequency
+  double beta;      // Kaiser window shape
+};
+
+static const ResamplePreset presets[] = {
+  {8, 32, false, 0.80, 5.0},   // RESAMPLE_FAST
+  {16, 64, true, 0.88, 7.0},   // RESAMPLE_MEDIUM
+  {32, 128, true, 0.92, 9.0},  // RESAMPLE_HIGH
+};
+
+// zeroth-order modified Bessel function, for the Kaiser window
+static double besselI0(double x) {
+  double sum = 1.0;
+  double term = 1.0;
+  for (int k = 1; k < 32; k++) {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+    if (term < sum * 1e-12) {
+      break;
+    }
+  }
+  return sum;
+}
+
+// grows `buf` to at least `size` samples; the contents are not kept
+static void growBuffer(int16_t *&buf, size_t &alloc, size_t size) {
+  if (alloc < size) {
+    delete[] buf;
+    buf = new int16_t[size];
+    alloc = size;
+  }
+}
+
+bool Resampler::begin(uint32_t input, uint32_t output, ResampleQuality quality, size_t max_input_block) {
+  if (input == 0 || output == 0 || max_input_block == 0) {
+    end();
+    return false;
+  }
+  input_rate = input;
+  output_rate = output;
+  const ResamplePreset &preset = presets[quality];
+  taps = preset.taps;
+  phases = preset.phases;
+  interpolate = preset.interpolate;
+
+  growBuffer(coeffs, coeffs_alloc, (size_t)(phases + 1) * taps);
+  history_size = taps + max_input_block;
+  growBuffer(history, history_alloc, history_size);
+
+  double cutoff = preset.bandwidth;
+  if (output_rate < input_rate) {
+    cutoff *= (double)output_rate / input_rate; // anti-aliasing when downsampling
+  }
+  buildFilter(cutoff, preset.beta);
+  base_step = ((uint64_t)input_rate << 32) / output_rate;
+  step = base_step;
+  adjust_ppm = 0;
+  adjusting = false;
+  reset();
+  return true;
+}
+
+void Resampler::end() {
+  delete[] coeffs;
+  delete[] history;
+  coeffs = nullptr;
+  history = nullptr;
+  coeffs_alloc = history_alloc = 0;
+  history_size = 0;
+  buffered = 0;
+}
+
+void Resampler::reset() {
+  // half a filter of silence so the first output is centred on the first input sample
+  buffered = taps / 2 - 1;
+  if (history) {
+    memset(history, 0, buffered * sizeof(int16_t));
+  }
+  position = 0;
+  adjusting = adjust_ppm != 0;
+}
+
+void Resampler::setRateAdjust(int32_t ppm) {
+  adjust_ppm = ppm;
+  step = base_step + (uint64_t)((int64_t)base_step * ppm / 1000000);
+  if (ppm != 0) {
+    adjusting = true;
+  }
+}
+
+void Resampler::buildFilter(double cutoff, double beta) {
+  const double half = taps / 2.0;
+  const double norm = besselI0(beta);
+  double row[64];
+
+  for (int p = 0; p <= phases; p++) {
+    double frac = (double)p / phases;
+    double sum = 0;
+    for (int j = 0; j < taps; j++) {
+      // distance from the interpolated point, in input samples
+      double d = j - (taps / 2 - 1) - frac;
+      double x = M_PI * cutoff * d;
+      double sinc = fabs(x) < 1e-9 ? 1.0 : sin(x) / x;
+      double r = d / half;
+      double window = fabs(r) >= 1.0 ? 0.0 : besselI0(beta * sqrt(1.0 - r * r)) / norm;
+      row[j] = cutoff * sinc * window;
+      sum += row[j];
+    }
+
+    // unity DC gain per phase; rounding residue goes to the largest tap
+    int16_t *c = coeffs + (size_t)p * taps;
+    int32_t total = 0;
+    int largest = 0;
+    for (int j = 0; j < taps; j++) {
+      double v = row[j] / sum * 32768.0;
+      c[j] = (int16_t)lrint(v > 32767.0 ? 32767.0 : v);
+      total += c[j];
+      if (fabs(row[j]) > fabs(row[largest])) {
+        largest = j;
+      }
+    }
+    int32_t fixed = c[largest] + (32768 - total);
+    c[largest] = (int16_t)(fixed > 32767 ? 32767 : fixed);
+  }
+}
+
+int32_t Resampler::dot(const int16_t *x, const int16_t *c) const {
+  int32_t acc = 0;
+  for (int j = 0; j < taps; j += 4) {
+    acc += x[j] * c[j];
+    acc += x[j + 1] * c[j + 1];
+    acc += x[j + 2] * c[j + 2];
+    acc += x[j + 3] * c[j + 3];
+  }
+  return acc;
+}
+
+size_t Resampler::process(const int16_t *in, size_t in_count, size_t &consumed, int16_t *out, size_t out_capacity) {
+  consumed = 0;
+  if (!history) {
+    return 0;
+  }
+  if (passthrough()) {
+    size_t n = in_count < out_capacity ? in_count : out_capacity;
+    // keep the last half filter of input, where filtering starts after setRateAdjust()
+    size_t keep = buffered;
+    if (n >= keep) {
+      memcpy(history, in + n - keep, keep * sizeof(int16_t));
+    } else if (n > 0) {
+      memmove(history, history + n, (keep - n) * sizeof(int16_t));
+      memcpy(history + keep - n, in, n * sizeof(int16_t));
+    }
+    memmove(out, in, n * sizeof(int16_t));
+    consumed = n;
+    return n;
+  }
+
+  size_t produced = 0;
+  while (true) {
+    size_t take = history_size - buffered;
+    if (take > in_count - consumed) {
+      take = in_count - consumed;
+    }
+    if (take > 0) {
+      memcpy(history + buffered, in + consumed, take * sizeof(int16_t));
+    }
+    buffered += take;
+    consumed += take;
+
+    while (produced < out_capacity) {
+      size_t i = (size_t)(position >> 32);
+      if (i + taps > buffered) {
+        break;
+      }
+      uint32_t frac = (uint32_t)position;
+      const int16_t *x = history + i;
+      int32_t y;
+      if (interpolate) {
+        uint64_t scaled = (uint64_t)frac * phases;
+        int p = (int)(scaled >> 32);
+        int32_t w = (int32_t)((uint32_t)scaled >> 17); // Q15 weight of the next phase
+        int32_t y0 = dot(x, coeffs + (size_t)p * taps);
+        int32_t y1 = dot(x, coeffs + (size_t)(p + 1) * taps);
+        y = y0 + (int32_t)(((int64_t)(y1 - y0) * w) >> 15);
+      } else {
+        int p = (int)(((uint64_t)frac * phases + 0x80000000u) >> 32);
+        y = dot(x, coeffs + (size_t)p * taps);
+      }
+      y = (y + (1 << 14)) >> 15;
+      out[produced++] = (int16_t)(y > 32767 ? 32767 : (y < -32768 ? -32768 : y));
+      position += step;
+    }
+
+    // drop input that no future output needs
+    size_t used = (size_t)(position >> 32);
+    if (used > buffered) {
+      used = buffered;
+    }
+    memmove(history, history + used, (buffered - used) * sizeof(int16_t));
+    buffered -= used;
+    position -= (uint64_t)used << 32;
+
+    if (take == 0 || consumed == in_count || produced == out_capacity) {
+      break;
+    }
+  }
+  return produced;
+}
+
+size_t Resampler::maxOutput(size_t in_count) const {
+  if (passthrough()) {
+    return in_count;
+  }
+  size_t avail = buffered + in_count;
+  if (avail < (size_t)taps) {
+    return 0;
+  }
+  uint64_t last = (uint64_t)(avail - taps) << 32; // last read position that still fits
+  if (last < position) {
+    return 0;
+  }
+  return (size_t)((last - position) / step) + 1;
+}
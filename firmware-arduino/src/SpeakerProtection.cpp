@@ -0,0 +1,188 @@
+#include "SpeakerProtection.h"
+
+#include <math.h>
+#include <string.h>
+
+constexpr int32_t UNITY_Q15 = 32768;
+constexpr int COEF_SHIFT = 28;
+
+// RBJ audio EQ cookbook, normalised by a0
+bool SpeakerProtection::design(const BiquadSpec &spec, uint32_t rate, Biquad &out) {
+  if (spec.type == BIQUAD_OFF || spec.freq_hz == 0 || spec.freq_hz * 2 >= rate) {
+    return false;
+  }
+  float gain_db = spec.gain_db > 12 ? 12 : (spec.gain_db < -12 ? -12 : spec.gain_db);
+  float q = spec.q > 0.1f ? spec.q : 0.1f;
+  float w0 = 2 * (float)M_PI * spec.freq_hz / rate;
+  float cs = cosf(w0);
+  float alpha = sinf(w0) / (2 * q);
+  float A = powf(10, gain_db / 40);
+  float sa = 2 * sqrtf(A) * alpha;
+  float b0, b1, b2, a0, a1, a2;
+
+  switch (spec.type) {
+  case BIQUAD_HIGHPASS:
+    b0 = (1 + cs) / 2, b1 = -(1 + cs), b2 = (1 + cs) / 2;
+    a0 = 1 + alpha, a1 = -2 * cs, a2 = 1 - alpha;
+    break;
+  case BIQUAD_LOWPASS:
+    b0 = (1 - cs) / 2, b1 = 1 - cs, b2 = (1 - cs) / 2;
+    a0 = 1 + alpha, a1 = -2 * cs, a2 = 1 - alpha;
+    break;
+  case BIQUAD_PEAK:
+    b0 = 1 + alpha * A, b1 = -2 * cs, b2 = 1 - alpha * A;
+    a0 = 1 + alpha / A, a1 = -2 * cs, a2 = 1 - alpha / A;
+    break;
+  case BIQUAD_LOWSHELF:
+    b0 = A * ((A + 1) - (A - 1) * cs + sa), b1 = 2 * A * ((A - 1) - (A + 1) * cs), b2 = A * ((A + 1) - (A - 1) * cs - sa);
+    a0 = (A + 1) + (A - 1) * cs + sa, a1 = -2 * ((A - 1) + (A + 1) * cs), a2 = (A + 1) + (A - 1) * cs - sa;
+    break;
+  case BIQUAD_HIGHSHELF:
+    b0 = A * ((A + 1) + (A - 1) * cs + sa), b1 = -2 * A * ((A - 1) + (A + 1) * cs), b2 = A * ((A + 1) + (A - 1) * cs - sa);
+    a0 = (A + 1) - (A - 1) * cs + sa, a1 = 2 * ((A - 1) - (A + 1) * cs), a2 = (A + 1) - (A - 1) * cs - sa;
+    break;
+  default:
+    return false;
+  }
+
+  const float scale = (float)(1 << COEF_SHIFT) / a0;
+  out.b0 = (int32_t)lrintf(b0 * scale);
+  out.b1 = (int32_t)lrintf(b1 * scale);
+  out.b2 = (int32_t)lrintf(b2 * scale);
+  out.a1 = (int32_t)lrintf(a1 * scale);
+  out.a2 = (int32_t)lrintf(a2 * scale);
+  return true;
+}
+
+void SpeakerProtection::begin(const SpeakerProtectionConfig &config) {
+  stage_count = 0;
+  for (size_t i = 0; i < SPEAKER_EQ_STAGES; i++) {
+    if (design(config.eq[i], config.sample_rate, stages[stage_count])) {
+      stage_count++;
+    }
+  }
+  ceiling = config.ceiling > 0 ? config.ceiling : 1;
+  lookahead = (size_t)((uint64_t)config.lookahead_us * config.sample_rate / 1000000);
+  if (lookahead < 1) {
+    lookahead = 1;
+  }
+  if (lookahead > LIMITER_MAX_LOOKAHEAD) {
+    lookahead = LIMITER_MAX_LOOKAHEAD;
+  }
+  uint32_t release_samples = (uint32_t)config.release_ms * config.sample_rate / 1000;
+  release_step = release_samples ? (int32_t)(UNITY_Q15 / release_samples) : UNITY_Q15;
+  if (release_step < 1) {
+    release_step = 1;
+  }
+  gain_q15 = target_gain_q15;
+  _stats = SpeakerProtectionStats();
+  reset();
+}
+
+void SpeakerProtection::reset() {
+  for (size_t i = 0; i < stage_count; i++) {
+    Biquad &s = stages[i];
+    s.x1 = s.x2 = s.y1 = s.y2 = s.err = 0;
+  }
+  memset(delay, 0, sizeof(delay));
+  pos = 0;
+  lim_gain = UNITY_Q15;
+  lim_target = UNITY_Q15;
+  lim_slope = 0;
+  hold = 0;
+}
+
+DspLevels SpeakerProtection::process(int16_t *samples, size_t count) {
+  DspLevels levels;
+  if (count == 0) {
+    return levels;
+  }
+  uint32_t peak = 0;
+  uint64_t sum = 0;
+  // boost in Q15.16 so a ramp across a short block keeps its precision
+  int32_t target = target_gain_q15;
+  int64_t gain = (int64_t)gain_q15 << 16;
+  int64_t gain_step = ((int64_t)(target - gain_q15) << 16) / (int64_t)count;
+
+  for (size_t n = 0; n < count; n++) {
+    int32_t v = (int32_t)(((int64_t)samples[n] * (int32_t)(gain >> 16)) >> 15);
+    gain += gain_step;
+
+    // EQ, direct form I; y keeps the full int32 range until the limiter
+    for (size_t i = 0; i < stage_count; i++) {
+      Biquad &s = stages[i];
+      int64_t acc = (int64_t)s.b0 * v + (int64_t)s.b1 * s.x1 + (int64_t)s.b2 * s.x2 -
+                    (int64_t)s.a1 * s.y1 - (int64_t)s.a2 * s.y2 + s.err;
+      int32_t y = (int32_t)(acc >> COEF_SHIFT);
+      s.err = (int32_t)(acc - ((int64_t)y << COEF_SHIFT));
+      s.x2 = s.x1;
+      s.x1 = v;
+      s.y2 = s.y1;
+      s.y1 = y;
+      v = y;
+    }
+
+    // a peak entering the delay line plans the gain it needs by the time it leaves
+    int32_t mag = v < 0 ? -v : v;
+    if (mag > 32767) {
+      levels.clipped++;
+    }
+    if (mag > ceiling) {
+      int32_t need = (int32_t)(((int64_t)ceiling << 15) / mag);
+      if (need < lim_target) {
+        lim_target = need;
+        // never flatter than a ramp already in progress, so earlier peaks stay covered
+        int32_t slope = (lim_gain - need + (int32_t)lookahead - 1) / (int32_t)lookahead;
+        if (slope > lim_slope) {
+          lim_slope = slope;
+        }
+      }
+      hold = lookahead + 1;
+      _stats.limited_samples++;
+    }
+
+    int32_t delayed = delay[pos];
+    delay[pos] = v;
+    if (++pos == lookahead) {
+      pos = 0;
+    }
+
+    if (hold > 0) {
+      hold--;
+      if (lim_gain > lim_target) {
+        lim_gain -= lim_slope;
+        if (lim_gain < lim_target) {
+          lim_gain = lim_target;
+        }
+      } else if (lim_gain < lim_target) {
+        lim_gain += release_step;  // towards a milder peak still in the line
+        if (lim_gain > lim_target) {
+          lim_gain = lim_target;
+        }
+      }
+    } else {
+      lim_target = UNITY_Q15;
+      lim_slope = 0;
+      if (lim_gain < UNITY_Q15) {
+        lim_gain += release_step;
+        if (lim_gain > UNITY_Q15) {
+          lim_gain = UNITY_Q15;
+        }
+      }
+    }
+    if (lim_gain < _stats.min_gain_q15) {
+      _stats.min_gain_q15 = lim_gain;
+    }
+
+    int32_t out = (int32_t)(((int64_t)delayed * lim_gain) >> 15);
+    out = out > 32767 ? 32767 : (out < -32768 ? -32768 : out);
+    samples[n] = (int16_t)out;
+    uint32_t out_mag = out < 0 ? -out : out;
+    peak = out_mag > peak ? out_mag : peak;
+    sum += (uint32_t)(out * out);
+  }
+  gain_q15 = target;
+  levels.peak = peak > 32767 ? 32767 : peak;
+  levels.rms = dspRms(sum, count);
+  return levels;
+}
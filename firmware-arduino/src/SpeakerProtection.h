@@ -0,0 +1,101 @@
+#ifndef SPEAKERPROTECTION_H
+#define SPEAKERPROTECTION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "AudioDsp.h"
+
+// Output stage between the mixer and the I2S port: volume boost, a short
+// biquad EQ for the enclosure and a look-ahead peak limiter, in one pass over
+// the block. Plain C++ so it can be tested on the host.
+//
+// Everything past the boost runs on int32 samples, so neither a boost above
+// unity nor an EQ peak clips before the limiter sees it. The limiter delays the
+// signal by its look-ahead and ramps the gain down ahead of every peak above
+// the ceiling, so nothing reaches the speaker above it; the gain is held until
+// the peak has left the delay line and then released linearly.
+//
+// Coefficients are computed in float by begin(); process() is integer only
+// (Q28 biquads with error feedback, Q15 gains) and its cost per sample does not
+// depend on the signal beyond one division per sample above the ceiling.
+
+enum BiquadType : uint8_t {
+  BIQUAD_OFF,
+  BIQUAD_HIGHPASS,
+  BIQUAD_LOWPASS,
+  BIQUAD_PEAK,
+  BIQUAD_LOWSHELF,
+  BIQUAD_HIGHSHELF
+};
+
+struct BiquadSpec {
+  BiquadType type = BIQUAD_OFF;
+  uint16_t freq_hz = 1000;
+  float q = 0.707f;
+  float gain_db = 0;  // peak and shelves, limited to +-12 dB
+};
+
+constexpr size_t SPEAKER_EQ_STAGES = 3;
+constexpr size_t LIMITER_MAX_LOOKAHEAD = 128;  // samples, 2.6 ms at 48 kHz
+
+struct SpeakerProtectionConfig {
+  uint32_t sample_rate = 24000;
+  BiquadSpec eq[SPEAKER_EQ_STAGES];
+  int16_t ceiling = 29204;         // limiter threshold, -1 dBFS
+  uint16_t lookahead_us = 2000;    // also the latency the stage adds
+  uint16_t release_ms = 80;        // from full reduction back to unity
+};
+
+struct SpeakerProtectionStats {
+  uint32_t limited_samples = 0;  // samples that arrived above the ceiling
+  int32_t min_gain_q15 = 32768;  // deepest gain reduction since the last resetStats()
+};
+
+class SpeakerProtection {
+public:
+  void begin(const SpeakerProtectionConfig &config);
+
+  // Clear the EQ state and the delay line, e.g. after the output was restarted.
+  void reset();
+
+  // Q15 gain before the EQ, up to 2x; ramps across the next block.
+  void setGain(int32_t gain_q15) { target_gain_q15 = gain_q15; }
+
+  // In place on one output block. Returns the levels of what goes to the
+  // speaker, measured in the same pass; `clipped` counts the samples that
+  // arrived above full scale, i.e. would have clipped without the limiter.
+  DspLevels process(int16_t *samples, size_t count);
+
+  size_t latencySamples() const { return lookahead; }
+  const SpeakerProtectionStats &stats() const { return _stats; }
+  void resetStats() { _stats = SpeakerProtectionStats(); }
+
+protected:
+  struct Biquad {
+    int32_t b0, b1, b2, a1, a2;  // Q28, a0 normalised to 1
+    int32_t x1, x2, y1, y2;
+    int32_t err;                 // rounding error fed back into the next output
+  };
+
+  Biquad stages[SPEAKER_EQ_STAGES];
+  size_t stage_count = 0;
+
+  int32_t target_gain_q15 = 32768;
+  int32_t gain_q15 = 32768;  // boost applied at the end of the last block
+
+  int32_t ceiling = 29204;
+  int32_t delay[LIMITER_MAX_LOOKAHEAD];
+  size_t lookahead = 0;
+  size_t pos = 0;
+  int32_t lim_gain = 32768;  // Q15
+  int32_t lim_target = 32768; // lowest gain a sample still in the delay line needs
+  int32_t lim_slope = 0;     // attack step per sample
+  int32_t release_step = 1;
+  uint32_t hold = 0;         // samples until the last peak leaves the delay line
+
+  SpeakerProtectionStats _stats;
+
+  static bool design(const BiquadSpec &spec, uint32_t rate, Biquad &out);
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef SPEECHPLAYOUT_H
+#define SPEECHPLAYOUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "JitterBuffer.h"
+
+// One playout step of the speech downlink, split the way audioDecodeTask runs
+// it: takePlayoutSlot() under jitterMutex, decodePlayoutSlot() outside it.
+// A gap in the sequence numbers is rebuilt from the in-band FEC data of the
+// packet after it when the server sends FEC and that packet is already queued,
+// and concealed with PLC otherwise. Gaps only exist when the server numbers its
+// packets ("audio_seq"); packets numbered on arrival never leave one.
+//
+// The decoder is a template parameter (decode/recover/conceal/lastFrameSamples
+// as in OpusFrameDecoder) so the gap handling can be driven on the host.
+
+struct PlayoutSlot {
+    JitterBuffer::PopResult result = JitterBuffer::POP_BUFFERING;
+    uint16_t seq = 0;
+    size_t len = 0;      // the packet, on POP_PACKET
+    size_t fec_len = 0;  // the packet after the gap, on POP_MISSING with FEC
+};
+
+inline PlayoutSlot takePlayoutSlot(JitterBuffer &jb, uint32_t now_ms, bool fec, uint8_t *packet, size_t packet_size,
+                                   uint8_t *fec_packet, size_t fec_size) {
+    PlayoutSlot slot;
+    slot.result = jb.pop(now_ms, packet, packet_size, slot.len, slot.seq);
+    if (slot.result == JitterBuffer::POP_MISSING && fec) {
+        jb.peek((uint16_t)(slot.seq + 1), fec_packet, fec_size, slot.fec_len);
+    }
+    return slot;
+}
+
+// Returns samples per channel written to `pcm`, 0 while buffering.
+template <class Decoder>
+int decodePlayoutSlot(Decoder &decoder, const PlayoutSlot &slot, const uint8_t *packet, const uint8_t *fec_packet,
+                      int16_t *pcm, int max_samples) {
+    if (slot.result == JitterBuffer::POP_PACKET) {
+        return decoder.decode(packet, slot.len, pcm, max_samples);
+    }
+    if (slot.result != JitterBuffer::POP_MISSING) {
+        return 0;
+    }
+    // a lost packet is assumed to be as long as the last one
+    int samples = decoder.lastFrameSamples() < max_samples ? decoder.lastFrameSamples() : max_samples;
+    if (slot.fec_len > 0) {
+        return decoder.recover(fec_packet, slot.fec_len, pcm, samples);
+    }
+    return decoder.conceal(pcm, samples);
+}
+
+#endif
@@ -0,0 +1,94 @@
+#include "SpscRing.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool SpscRing::begin(size_t capacity) {
+  end();
+  size_t size = 1;
+  while (size < capacity) {
+    size <<= 1;
+  }
+  data = (uint8_t *)malloc(size);
+  if (!data) {
+    return false;
+  }
+  mask = size - 1;
+  head.store(0, std::memory_order_relaxed);
+  tail.store(0, std::memory_order_relaxed);
+  return true;
+}
+
+void SpscRing::end() {
+  free(data);
+  data = nullptr;
+  mask = 0;
+}
+
+uint8_t *SpscRing::reserve(size_t &len) {
+  size_t h = head.load(std::memory_order_relaxed);
+  size_t t = tail.load(std::memory_order_acquire); // the consumer is done with bytes before t
+  size_t free_bytes = capacity() - (h - t);
+  size_t to_wrap = capacity() - (h & mask);
+  len = free_bytes < to_wrap ? free_bytes : to_wrap;
+  return data + (h & mask);
+}
+
+void SpscRing::commit(size_t len) {
+  head.store(head.load(std::memory_order_relaxed) + len, std::memory_order_release);
+}
+
+size_t SpscRing::write(const uint8_t *src, size_t len) {
+  size_t h = head.load(std::memory_order_relaxed);
+  size_t n = space();
+  if (n > len) {
+    n = len;
+  }
+  size_t to_wrap = capacity() - (h & mask);
+  size_t first = n < to_wrap ? n : to_wrap;
+  memcpy(data + (h & mask), src, first);
+  memcpy(data, src + first, n - first);
+  commit(n);  // once, so the consumer never sees half of a write across the wrap point
+  return n;
+}
+
+size_t SpscRing::space() const {
+  return capacity() - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+}
+
+const uint8_t *SpscRing::peek(size_t &len) {
+  size_t t = tail.load(std::memory_order_relaxed);
+  size_t h = head.load(std::memory_order_acquire); // bytes before h are fully written
+  size_t to_wrap = capacity() - (t & mask);
+  len = h - t < to_wrap ? h - t : to_wrap;
+  return data + (t & mask);
+}
+
+void SpscRing::consume(size_t len) {
+  tail.store(tail.load(std::memory_order_relaxed) + len, std::memory_order_release);
+}
+
+size_t SpscRing::read(uint8_t *out, size_t len) {
+  size_t done = 0;
+  while (done < len) {
+    size_t n;
+    const uint8_t *src = peek(n);
+    if (n == 0) {
+      break;
+    }
+    if (n > len - done) {
+      n = len - done;
+    }
+    memcpy(out + done, src, n);
+    consume(n);
+    done += n;
+  }
+  return done;
+}
+
+size_t SpscRing::available() const {
+  return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+}
+
+void SpscRing::clear() {
+  tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+}
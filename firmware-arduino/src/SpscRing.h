@@ -0,0 +1,47 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// Wait-free single-producer/single-consumer byte ring. The producer and the
+// consumer may run on different cores; neither ever blocks or takes a lock.
+// Both sides can work in place: the producer reserve()s a contiguous region,
+// fills it (e.g. straight from an I2S read) and commit()s it; the consumer
+// peek()s a contiguous region, sends or processes it and consume()s it.
+//
+// Capacity is rounded up to a power of two. Positions run freely and are
+// masked on access, so a full ring needs no spare slot. Plain C++ so it can be
+// tested on the host (including under ThreadSanitizer).
+class SpscRing {
+public:
+  ~SpscRing() { end(); }
+
+  bool begin(size_t capacity);
+  void end();
+
+  // Producer side.
+  uint8_t *reserve(size_t &len);        // writable bytes up to the wrap point, len = 0 when full
+  void commit(size_t len);
+  size_t write(const uint8_t *data, size_t len);  // all that fits, made visible in one commit
+  size_t space() const;
+
+  // Consumer side.
+  const uint8_t *peek(size_t &len);     // readable bytes up to the wrap point, len = 0 when empty
+  void consume(size_t len);
+  size_t read(uint8_t *out, size_t len);
+  size_t available() const;
+  void clear();                         // drop everything committed so far
+
+  size_t capacity() const { return mask + 1; }
+
+protected:
+  uint8_t *data = nullptr;
+  size_t mask = 0;
+  // written by one side each, on separate cache lines
+  alignas(32) std::atomic<size_t> head{0}; // producer
+  alignas(32) std::atomic<size_t> tail{0}; // consumer
+};
+
+#endif
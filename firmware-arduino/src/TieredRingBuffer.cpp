@@ -0,0 +1,116 @@
+#include "TieredRingBuffer.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef ESP_PLATFORM
+#include <esp_heap_caps.h>
+#endif
+
+static int16_t *allocSamples(size_t count, bool external) {
+#ifdef ESP_PLATFORM
+  uint32_t caps = (external ? MALLOC_CAP_SPIRAM : MALLOC_CAP_INTERNAL) | MALLOC_CAP_8BIT;
+  return (int16_t *)heap_caps_malloc(count * sizeof(int16_t), caps);
+#else
+  return external ? nullptr : (int16_t *)malloc(count * sizeof(int16_t));
+#endif
+}
+
+static void freeSamples(int16_t *p) {
+#ifdef ESP_PLATFORM
+  heap_caps_free(p);
+#else
+  free(p);
+#endif
+}
+
+bool TieredRingBuffer::begin(size_t cap, size_t hot_cap, size_t fallback_cap) {
+  end();
+  store = allocSamples(cap, true);
+  psram = store != nullptr;
+  capacity = cap;
+  if (!store) {
+    store = allocSamples(fallback_cap, false);
+    capacity = fallback_cap;
+  }
+  hot = allocSamples(hot_cap, false);
+  if (!store || !hot || capacity == 0 || hot_cap == 0) {
+    end();
+    return false;
+  }
+  hot_capacity = hot_cap;
+  reset();
+  return true;
+}
+
+void TieredRingBuffer::end() {
+  freeSamples(store);
+  freeSamples(hot);
+  store = nullptr;
+  hot = nullptr;
+  capacity = 0;
+  hot_capacity = 0;
+  psram = false;
+  reset();
+}
+
+void TieredRingBuffer::reset() {
+  head = 0;
+  tail = 0;
+  stored = 0;
+  hot_pos = 0;
+  hot_end = 0;
+}
+
+size_t TieredRingBuffer::write(const int16_t *samples, size_t count) {
+  if (count > space()) {
+    count = space();
+  }
+  // at most two bulk copies, split where the ring wraps
+  size_t first = capacity - head < count ? capacity - head : count;
+  memcpy(store + head, samples, first * sizeof(int16_t));
+  memcpy(store, samples + first, (count - first) * sizeof(int16_t));
+  head = (head + count) % capacity;
+  stored += count;
+  return count;
+}
+
+void TieredRingBuffer::refill() {
+  size_t n = stored < hot_capacity ? stored : hot_capacity;
+  size_t first = capacity - tail < n ? capacity - tail : n;
+  memcpy(hot, store + tail, first * sizeof(int16_t));
+  memcpy(hot + first, store, (n - first) * sizeof(int16_t));
+  tail = (tail + n) % capacity;
+  stored -= n;
+  hot_pos = 0;
+  hot_end = n;
+}
+
+const int16_t *TieredRingBuffer::peek(size_t &count) {
+  if (hot_pos >= hot_end && stored > 0) {
+    refill();
+  }
+  count = hot_end - hot_pos;
+  return hot + hot_pos;
+}
+
+void TieredRingBuffer::consume(size_t count) {
+  size_t left = hot_end - hot_pos;
+  hot_pos += count < left ? count : left;
+}
+
+size_t TieredRingBuffer::read(int16_t *out, size_t count) {
+  size_t done = 0;
+  while (done < count) {
+    size_t n;
+    const int16_t *p = peek(n);
+    if (n == 0) {
+      break;
+    }
+    if (n > count - done) {
+      n = count - done;
+    }
+    memcpy(out + done, p, n * sizeof(int16_t));
+    consume(n);
+    done += n;
+  }
+  return done;
+}
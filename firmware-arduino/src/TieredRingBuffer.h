@@ -0,0 +1,60 @@
+#ifndef TIEREDRINGBUFFER_H
+#define TIEREDRINGBUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Sample ring with a large backing store in PSRAM and a small hot window in
+// internal RAM. PSRAM is fast for long sequential copies but slow for short
+// scattered accesses, so the backing store is only ever touched with bulk
+// memcpy()s: write() copies whole blocks in, and the reader is served from the
+// hot window, which is refilled one window at a time. peek()/consume() let a
+// consumer work on the window in place.
+//
+// Falls back to internal RAM when the board has no PSRAM (see begin()). Not
+// thread safe: use it from one task, or serialize access. Plain C++ apart from
+// the allocation, so it can be tested on the host.
+class TieredRingBuffer {
+public:
+  ~TieredRingBuffer() { end(); }
+
+  // Allocates `capacity` samples in PSRAM, or `fallback_capacity` samples in
+  // internal RAM when there is no PSRAM, plus a `hot_capacity` window in
+  // internal RAM. Returns false if neither allocation works.
+  bool begin(size_t capacity, size_t hot_capacity, size_t fallback_capacity);
+  void end();
+  void reset();
+
+  // Copies up to `count` samples in; returns how many fitted.
+  size_t write(const int16_t *samples, size_t count);
+
+  // Copies up to `count` samples out; returns how many were available.
+  size_t read(int16_t *out, size_t count);
+
+  // Zero-copy read: the next contiguous samples in the hot window (refilled
+  // from the backing store when empty), and how many of them were used.
+  const int16_t *peek(size_t &count);
+  void consume(size_t count);
+
+  size_t available() const { return stored + (hot_end - hot_pos); }
+  size_t space() const { return capacity - stored; }
+  size_t capacitySamples() const { return capacity; }
+  bool inPsram() const { return psram; }
+
+protected:
+  int16_t *store = nullptr;  // backing ring, PSRAM when available
+  size_t capacity = 0;
+  size_t head = 0;           // next write position in `store`
+  size_t tail = 0;           // next read position in `store`
+  size_t stored = 0;         // samples in `store`, not counting the hot window
+  bool psram = false;
+
+  int16_t *hot = nullptr;    // internal RAM
+  size_t hot_capacity = 0;
+  size_t hot_pos = 0;
+  size_t hot_end = 0;
+
+  void refill();
+};
+
+#endif
@@ -3,75 +3,9 @@
 #include "BhajanAudio.h"
 #include "OTA.h"
 
-// Extended WebSocket message handling with bhajan support
-void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
-    switch(type) {
-        case WStype_DISCONNECTED:
-            Serial.println("WebSocket disconnected");
-            isWebSocketConnected = false;
-            break;
-            
-        case WStype_CONNECTED:
-            Serial.println("WebSocket connected");
-            isWebSocketConnected = true;
-            
-            // Send initial status including bhajan status
-            sendInitialStatus();
-            break;
-            
-        case WStype_TEXT:
-            {
-                Serial.print("Received WebSocket message: ");
-                Serial.println((char*)payload);
-                
-                StaticJsonDocument<1024> doc;
-                DeserializationError error = deserializeJson(doc, payload);
-                
-                if (error) {
-                    Serial.print("JSON parsing failed: ");
-                    Serial.println(error.c_str());
-                    return;
-                }
-                
-                // Handle different message types
-                const char* messageType = doc["type"];
-                
-                if (messageType) {
-                    if (strcmp(messageType, "auth_success") == 0) {
-                        const char* devId = doc["deviceId"];
-                        if (devId) {
-                            deviceId = String(devId);
-                            Serial.print("Device ID set: ");
-                            Serial.println(deviceId);
-                        }
-                    } else if (strcmp(messageType, "bhajan_play") == 0) {
-                        handleBhajanPlayMessage(doc);
-                    } else if (strcmp(messageType, "bhajan_control") == 0) {
-                        handleBhajanControlMessage(doc);
-                    } else if (strcmp(messageType, "bhajan_set_default") == 0) {
-                        handleBhajanSetDefaultMessage(doc);
-                    } else if (strcmp(messageType, "bhajan_get_status") == 0) {
-                        sendBhajanStatusUpdate();
-                    } else {
-                        // Handle other existing message types
-                        handleGenericWebSocketMessage(doc);
-                    }
-                }
-            }
-            break;
-            
-        case WStype_BIN:
-            // Handle binary messages if needed
-            break;
-            
-        case WStype_ERROR:
-            Serial.println("WebSocket error");
-            break;
-            
-        default:
-            break;
-    }
-}
+// webSocketEvent() in Audio.cpp, the handler websocketSetup() registers, only
+// routes bhajan_command and the "speed" of bhajan_control; the helpers below
+// are not reached from it.
 
 // Handle bhajan set default message
 void handleBhajanSetDefaultMessage(JsonDocument& doc) {
@@ -249,6 +183,7 @@ void sendEnhancedStatusUpdate() {
         // Audio info
         doc["volume"] = currentVolume;
         doc["pitch_factor"] = currentPitchFactor;
+        appendAudioTelemetry(doc);
         
         String jsonString;
         serializeJson(doc, jsonString);
@@ -0,0 +1,299 @@
+#include "Wsola.h"
+
+#include <string.h>
+
+struct WsolaPreset {
+  uint16_t seq_ms;
+  uint16_t overlap_ms;
+  uint16_t seek_ms;
+  uint8_t coarse_step;
+  uint8_t decimate;
+  ResampleQuality resample;
+};
+
+static const WsolaPreset presets[] = {
+  {40, 8, 10, 4, 4, RESAMPLE_FAST},     // WSOLA_LOW
+  {40, 8, 14, 2, 2, RESAMPLE_MEDIUM},   // WSOLA_MEDIUM
+  {40, 10, 16, 1, 1, RESAMPLE_HIGH},    // WSOLA_HIGH
+};
+
+static size_t msToSamples(uint32_t ms, uint32_t rate) { return (size_t)((uint64_t)ms * rate / 1000); }
+
+// grows `buf` to at least `size` samples; the contents are not kept
+static void growBuffer(int16_t *&buf, size_t &alloc, size_t size) {
+  if (alloc < size) {
+    delete[] buf;
+    buf = new int16_t[size];
+    alloc = size;
+  }
+}
+
+bool WsolaStretch::begin(uint32_t sample_rate, WsolaQuality quality, size_t max_input_block) {
+  if (sample_rate == 0 || max_input_block == 0) {
+    end();
+    return false;
+  }
+  const WsolaPreset &preset = presets[quality];
+  seq = msToSamples(preset.seq_ms, sample_rate);
+  overlap = msToSamples(preset.overlap_ms, sample_rate);
+  seek = msToSamples(preset.seek_ms, sample_rate);
+  coarse_step = preset.coarse_step;
+  decimate = preset.decimate;
+  if (overlap < 8 || seq < 3 * overlap) {
+    end();
+    return false;
+  }
+
+  // enough for the widest skip plus one full write on top
+  size_t max_skip = (size_t)((seq - overlap) * WSOLA_MAX_TEMPO) + 1;
+  input_cap = seek + (seq > max_skip + overlap ? seq : max_skip + overlap) + max_input_block;
+  growBuffer(input, input_alloc, input_cap);
+  growBuffer(mid, overlap_alloc, 3 * overlap);  // mid, ref and fade in one block
+  ref = mid + overlap;
+  fade = ref + overlap;
+  growBuffer(out, seq_alloc, seq);
+  for (size_t i = 0; i < overlap; i++) {
+    fade[i] = (int16_t)(i * 32768 / overlap);
+  }
+  setTempo(1.0f);
+  reset();
+  return true;
+}
+
+void WsolaStretch::end() {
+  delete[] input;
+  delete[] mid;
+  delete[] out;
+  input = mid = ref = fade = out = nullptr;
+  input_cap = 0;
+  input_alloc = overlap_alloc = seq_alloc = 0;
+}
+
+void WsolaStretch::reset() {
+  input_len = 0;
+  out_pos = out_len = 0;
+  skip_fract = 0;
+  sequence_count = 0;
+  if (mid) {
+    memset(mid, 0, overlap * sizeof(int16_t));
+    memset(ref, 0, overlap * sizeof(int16_t));
+  }
+}
+
+void WsolaStretch::setTempo(float t) {
+  t = t < WSOLA_MIN_TEMPO ? WSOLA_MIN_TEMPO : (t > WSOLA_MAX_TEMPO ? WSOLA_MAX_TEMPO : t);
+  skip_q16 = (uint32_t)((double)t * (seq - overlap) * 65536 + 0.5);
+}
+
+size_t WsolaStretch::requiredInput() const {
+  size_t skip = (skip_q16 >> 16) + 1;
+  return seek + (seq > skip + overlap ? seq : skip + overlap);
+}
+
+size_t WsolaStretch::write(const int16_t *in, size_t count) {
+  if (!input) {
+    return 0;
+  }
+  size_t n = input_cap - input_len < count ? input_cap - input_len : count;
+  memcpy(input + input_len, in, n * sizeof(int16_t));
+  input_len += n;
+  return n;
+}
+
+size_t WsolaStretch::read(int16_t *dst, size_t count) {
+  size_t done = 0;
+  while (done < count) {
+    if (out_pos == out_len) {
+      if (!input || input_len < requiredInput()) {
+        break;
+      }
+      runSequence();
+    }
+    size_t n = out_len - out_pos < count - done ? out_len - out_pos : count - done;
+    memcpy(dst + done, out + out_pos, n * sizeof(int16_t));
+    out_pos += n;
+    done += n;
+  }
+  return done;
+}
+
+// normalised cross-correlation with `ref`, kept signed: corr * |corr| / energy
+float WsolaStretch::score(size_t offset) const {
+  const int16_t *x = input + offset;
+  int64_t corr = 0;
+  int64_t energy = 1;
+  for (size_t i = 0; i < overlap; i += decimate) {
+    corr += (int32_t)ref[i] * x[i];
+    energy += (int32_t)x[i] * x[i];
+  }
+  float c = (float)corr;
+  return c * (c < 0 ? -c : c) / (float)energy;
+}
+
+size_t WsolaStretch::bestOffset() const {
+  size_t best = 0;
+  float best_value = score(0);
+  for (size_t offset = coarse_step; offset <= seek; offset += coarse_step) {
+    float value = score(offset);
+    if (value > best_value) {
+      best_value = value;
+      best = offset;
+    }
+  }
+  if (coarse_step > 1) {
+    size_t from = best > coarse_step - 1 ? best - (coarse_step - 1) : 0;
+    size_t to = best + coarse_step - 1 < seek ? best + coarse_step - 1 : seek;
+    size_t coarse_best = best;
+    for (size_t offset = from; offset <= to; offset++) {
+      if (offset == coarse_best) {
+        continue;
+      }
+      float value = score(offset);
+      if (value > best_value) {
+        best_value = value;
+        best = offset;
+      }
+    }
+  }
+  return best;
+}
+
+void WsolaStretch::runSequence() {
+  const int16_t *src = input + bestOffset();
+
+  // crossfade from the end of the last sequence into this one, then the body
+  for (size_t i = 0; i < overlap; i++) {
+    int32_t f = fade[i];
+    out[i] = (int16_t)(((int32_t)mid[i] * (32768 - f) + (int32_t)src[i] * f + 16384) >> 15);
+  }
+  memcpy(out + overlap, src + overlap, (seq - 2 * overlap) * sizeof(int16_t));
+  out_pos = 0;
+  out_len = seq - overlap;
+
+  // the tail becomes the next crossfade, and its weighted copy the search reference
+  memcpy(mid, src + seq - overlap, overlap * sizeof(int16_t));
+  const uint32_t half = (uint32_t)overlap * overlap / 4;
+  for (size_t i = 0; i < overlap; i++) {
+    uint32_t hat = (uint32_t)i * (overlap - i);  // 0 at the edges, `half` in the middle
+    ref[i] = (int16_t)(((int32_t)mid[i] * (int32_t)((hat << 15) / half)) >> 15);
+  }
+
+  skip_fract += skip_q16;
+  size_t skip = skip_fract >> 16;
+  skip_fract &= 0xffff;
+  skip = skip < input_len ? skip : input_len;
+  input_len -= skip;
+  memmove(input, input + skip, input_len * sizeof(int16_t));
+  sequence_count++;
+}
+
+// --- WsolaPitchShift --------------------------------------------------------
+
+bool WsolaPitchShift::begin(uint32_t sample_rate, float p, WsolaQuality quality) {
+  configured = false;
+  if (sample_rate == 0) {
+    end();
+    return false;
+  }
+  rate = sample_rate;
+  requested_pitch = p;
+  p = p < 0.5f ? 0.5f : (p > 2.0f ? 2.0f : p);
+  tier = quality;
+
+  // stretch by the pitch factor, then play the result back at that many times the rate
+  uint32_t stretched_rate = (uint32_t)(sample_rate * p + 0.5f);
+  if (!stretch.begin(sample_rate, quality, CHUNK) ||
+      !resampler.begin(stretched_rate, sample_rate, presets[quality].resample, CHUNK)) {
+    end();
+    return false;
+  }
+  stretch.setTempo((float)sample_rate / stretched_rate);
+
+  // the first output needs requiredInput() of input, which a chunk-sized call
+  // may overshoot by a chunk; from then on each sequence releases about as much
+  // as the input that pays for it. The FIFO also holds one sequence's burst.
+  latency = stretch.requiredInput() + CHUNK;
+  fifo_cap = latency + 2 * (stretch.sequenceOutput() * 2 + CHUNK);
+  if (!scratch) {
+    scratch = new int16_t[CHUNK];
+  }
+  growBuffer(fifo, fifo_alloc, fifo_cap);
+  configured = true;
+  reset();
+  return true;
+}
+
+bool WsolaPitchShift::reserve(uint32_t max_sample_rate, WsolaQuality quality) {
+  // every buffer grows with the rate, and the FIFO is largest at the lowest
+  // pitch, where the stretch needs the most input before its first output
+  bool ok = begin(max_sample_rate, 0.5f, quality);
+  configured = false;
+  return ok;
+}
+
+void WsolaPitchShift::end() {
+  stretch.end();
+  resampler.end();
+  delete[] scratch;
+  delete[] fifo;
+  scratch = fifo = nullptr;
+  fifo_cap = fifo_alloc = 0;
+  configured = false;
+}
+
+void WsolaPitchShift::reset() {
+  if (!configured) {
+    return;
+  }
+  stretch.reset();
+  resampler.reset();
+  memset(fifo, 0, latency * sizeof(int16_t));
+  fifo_start = 0;
+  fifo_len = latency;
+  underrun_samples = 0;
+}
+
+// stretched output -> resampler -> FIFO, as far as the buffered input goes
+void WsolaPitchShift::drain() {
+  size_t n;
+  while ((n = stretch.read(scratch, CHUNK)) > 0) {
+    size_t pos = 0;
+    while (pos < n) {
+      if (fifo_start + fifo_len + resampler.maxOutput(n - pos) > fifo_cap) {
+        memmove(fifo, fifo + fifo_start, fifo_len * sizeof(int16_t));
+        fifo_start = 0;
+      }
+      size_t space = fifo_cap - fifo_start - fifo_len;
+      size_t consumed = 0;
+      size_t produced = resampler.process(scratch + pos, n - pos, consumed, fifo + fifo_start + fifo_len, space);
+      fifo_len += produced;
+      pos += consumed;
+      if (consumed == 0 && produced == 0) {
+        // full, which the sizing in begin() rules out; drop the oldest output
+        size_t drop = fifo_len < CHUNK ? fifo_len : CHUNK;
+        fifo_start += drop;
+        fifo_len -= drop;
+      }
+    }
+  }
+}
+
+void WsolaPitchShift::process(int16_t *samples, size_t count) {
+  if (!configured) {
+    return;
+  }
+  // chunk by chunk, so a chunk's input is buffered before its output replaces it
+  for (size_t pos = 0; pos < count; pos += CHUNK) {
+    size_t n = count - pos < CHUNK ? count - pos : CHUNK;
+    stretch.write(samples + pos, n);
+    drain();
+    size_t ready = fifo_len < n ? fifo_len : n;
+    memcpy(samples + pos, fifo + fifo_start, ready * sizeof(int16_t));
+    fifo_start += ready;
+    fifo_len -= ready;
+    if (ready < n) {
+      memset(samples + pos + ready, 0, (n - ready) * sizeof(int16_t));
+      underrun_samples += n - ready;
+    }
+  }
+}
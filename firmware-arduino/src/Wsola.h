@@ -0,0 +1,150 @@
+#ifndef WSOLA_H
+#define WSOLA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Resampler.h"
+
+// WSOLA (waveform-similarity overlap-add) time stretch and pitch shift for mono
+// int16 audio. Plain C++ so it can be tested on the host.
+//
+// WsolaStretch cuts the input into sequences and joins each one to the last,
+// over a short crossfade, at the offset within a seek window where the two
+// waveforms line up best. Advancing the input by more or less than a sequence
+// per sequence changes the tempo without touching the pitch. WsolaPitchShift
+// stretches by the pitch factor and resamples back to the original length with
+// Resampler, which moves the pitch without changing the tempo.
+//
+// The sample path is integer only (Q15 crossfade, int64 correlation); the
+// search divides once in float per candidate offset. Every buffer is allocated
+// by begin() and each instance keeps its own state. Buffers only grow, so after
+// WsolaPitchShift::reserve() a begin() up to the reserved rate and tier merely
+// re-parameterises: it rebuilds the tables but allocates nothing.
+//
+// Tiers, per 20 ms block at 24 kHz and pitch 1.25 (the search plus the
+// resampler), as measured by test/wsola_test.cpp; SNR of a shifted 220 Hz /
+// 1 kHz tone against the ideal one, where the grain shifter reaches 0 dB or less:
+//   WSOLA_LOW    seek 10 ms, every 4th offset then refined, every 4th sample    ~9k MACs, 26 / 57 dB
+//   WSOLA_MEDIUM seek 14 ms, every 2nd offset then refined, every 2nd sample  ~41k MACs, 26 / 71 dB
+//   WSOLA_HIGH   seek 16 ms, every offset and sample                         ~175k MACs, 28 / 79 dB
+// At 2-3 cycles per MAC on the ESP32-S3 that is roughly 0.1, 0.4 and 1.8 ms of
+// a 240 MHz core per block (0.5%, 2% and 9%). All tiers use 40 ms sequences
+// with 8 ms overlaps (10 ms for HIGH); WsolaPitchShift adds about 65 ms of
+// latency at 24 kHz.
+
+enum WsolaQuality {
+  WSOLA_LOW,
+  WSOLA_MEDIUM,
+  WSOLA_HIGH
+};
+
+constexpr float WSOLA_MIN_TEMPO = 0.5f;
+constexpr float WSOLA_MAX_TEMPO = 2.0f;
+
+class WsolaStretch {
+public:
+  ~WsolaStretch() { end(); }
+
+  // `max_input_block` bounds how many samples one write() takes.
+  bool begin(uint32_t sample_rate, WsolaQuality quality, size_t max_input_block);
+  void end();
+
+  // Forget buffered input and output.
+  void reset();
+
+  // Input samples per output sample, WSOLA_MIN_TEMPO..WSOLA_MAX_TEMPO: 0.5 plays
+  // at half speed, 2 at double. Takes effect from the next sequence.
+  void setTempo(float tempo);
+  float tempo() const { return (float)skip_q16 / 65536 / (seq - overlap); }
+
+  // Buffers input; returns how much was taken, which is everything up to
+  // max_input_block once read() has drained the previous input.
+  size_t write(const int16_t *in, size_t count);
+
+  // Output as far as the buffered input allows, up to `count` samples.
+  size_t read(int16_t *out, size_t count);
+
+  // Input that must be buffered before the first output at the current tempo.
+  size_t requiredInput() const;
+  // Output produced per sequence.
+  size_t sequenceOutput() const { return seq - overlap; }
+  uint32_t sequences() const { return sequence_count; }
+
+protected:
+  size_t seq = 0;          // sequence length, including both overlaps
+  size_t overlap = 0;
+  size_t seek = 0;         // offsets 0..seek are searched
+  size_t coarse_step = 1;  // search offsets this far apart, then refine around the best
+  size_t decimate = 1;     // correlate every n-th sample of the overlap
+
+  uint32_t skip_q16 = 0;   // input advanced per sequence, Q16
+  uint32_t skip_fract = 0;
+
+  int16_t *input = nullptr;
+  size_t input_cap = 0;
+  size_t input_len = 0;
+  int16_t *mid = nullptr;  // end of the last sequence, faded into the next one
+  int16_t *ref = nullptr;  // `mid` weighted towards its centre for the search
+  int16_t *fade = nullptr; // Q15 weight of the new sequence across the overlap
+  int16_t *out = nullptr;  // output of the last sequence not yet read
+  size_t input_alloc = 0;  // samples allocated, at least what the current setup uses
+  size_t overlap_alloc = 0; // mid, ref and fade share one allocation
+  size_t seq_alloc = 0;
+  size_t out_pos = 0;
+  size_t out_len = 0;
+  uint32_t sequence_count = 0;
+
+  size_t bestOffset() const;
+  float score(size_t offset) const;
+  void runSequence();
+};
+
+class WsolaPitchShift {
+public:
+  ~WsolaPitchShift() { end(); }
+
+  // `pitch` as a frequency factor, 0.5..2.
+  bool begin(uint32_t sample_rate, float pitch, WsolaQuality quality);
+  void end();
+
+  // Allocates for any pitch at `quality` and rates up to `max_sample_rate`, so
+  // that later begin()s within that allocate nothing. Leaves the shifter inactive.
+  bool reserve(uint32_t max_sample_rate, WsolaQuality quality);
+
+  // Forget everything buffered; the next output starts with latencySamples() of silence.
+  void reset();
+
+  // In place, the same number of samples out as in, delayed by latencySamples().
+  void process(int16_t *samples, size_t count);
+
+  size_t latencySamples() const { return latency; }
+  bool active() const { return configured; }
+  uint32_t sampleRate() const { return rate; }
+  float pitch() const { return requested_pitch; }  // as passed to begin(), before clamping
+  WsolaQuality quality() const { return tier; }
+  uint32_t underruns() const { return underrun_samples; }
+  uint32_t sequences() const { return stretch.sequences(); }
+
+protected:
+  static constexpr size_t CHUNK = 256;
+
+  WsolaStretch stretch;
+  Resampler resampler;
+  uint32_t rate = 0;
+  float requested_pitch = 1.0f;
+  WsolaQuality tier = WSOLA_MEDIUM;
+
+  bool configured = false;
+  int16_t *scratch = nullptr;  // CHUNK stretched samples on their way to the resampler
+  int16_t *fifo = nullptr;     // output waiting to replace input, [fifo_start, fifo_start + fifo_len)
+  size_t fifo_cap = 0;
+  size_t fifo_alloc = 0;
+  size_t fifo_start = 0;
+  size_t fifo_len = 0;
+  size_t latency = 0;
+  uint32_t underrun_samples = 0;
+
+  void drain();
+};
+
+#endif
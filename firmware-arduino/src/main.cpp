@@ -11,6 +11,7 @@
 extern TaskHandle_t speakerTaskHandle;
 extern TaskHandle_t micTaskHandle;
 extern TaskHandle_t networkTaskHandle;
+extern TaskHandle_t decodeTaskHandle;
 TaskHandle_t bhajanAudioTaskHandle = NULL;
 
 // Global variables (shared definitions moved to Audio.cpp)
@@ -44,6 +45,7 @@ void enterSleep() {
   scheduleListeningRestart = false;
   i2sOutputFlushScheduled = true;
   i2sInputFlushScheduled = true;
+  notifySpeakerTask(SPEAKER_EVT_FLUSH | SPEAKER_EVT_STATE);
   vTaskDelay(10); // let all tasks accept state
 
   xSemaphoreTake(wsMutex, portMAX_DELAY);
@@ -147,6 +149,7 @@ void touchTask(void *parameter) {
   touch_pad_config(TOUCH_PAD_NUM2);
 
   bool touched = false;
+  bool bargedIn = false; // this press cancelled an answer, so it is not also a bhajan press
   unsigned long pressStartTime = 0;
   unsigned long lastTouchTime = 0;
   const unsigned long LONG_PRESS_DURATION = 500;
@@ -162,6 +165,12 @@ void touchTask(void *parameter) {
         touched = true;
         pressStartTime = currentTime;
         lastTouchTime = currentTime;
+
+        // Barge-in: cut the answer off on touch down rather than on release
+        if (deviceState == SPEAKING) {
+            requestSpeechCancel();
+            bargedIn = true;
+        }
     }
 
     // Check for different touch durations
@@ -173,7 +182,7 @@ void touchTask(void *parameter) {
             sleepRequested = true;
         } else if (pressDuration >= BHAJAN_CONTROL_DURATION && pressDuration < LONG_PRESS_DURATION) {
             // Medium press - bhajan control
-            if (!sleepRequested) {
+            if (!sleepRequested && !bargedIn) {
                 handleBhajanButtonPress();
             }
         }
@@ -182,6 +191,7 @@ void touchTask(void *parameter) {
     // Release detection
     if (!isTouched && touched) {
         touched = false;
+        bargedIn = false;
         pressStartTime = 0;
     }
 
@@ -212,7 +222,12 @@ void setup() {
   // SETUP
   setupDeviceMetadata();
   wsMutex = xSemaphoreCreateMutex();
+  jitterMutex = xSemaphoreCreateMutex();
+  jitterSpace = xSemaphoreCreateBinary();
   bhajanMutex = xSemaphoreCreateMutex();
+  initAudioOutput();
+  micRing.begin(MIC_RING_BYTES);
+  micReader.begin(&micRing, MIC_MAX_FRAME_SAMPLES * sizeof(int16_t));
 
   // Initialize bhajan system
   initBhajanSystem();
@@ -243,13 +258,24 @@ void setup() {
                           1           // Core 1 (application core)
   );
 
-  xTaskCreatePinnedToCore(audioStreamTask, // Function
-                          "Speaker Task",  // Name
-                          4096,            // Stack size
-                          NULL,            // Parameters
-                          3,               // Priority
-                          &speakerTaskHandle, // Handle
-                          1                // Core 1 (application core)
+  // Above the other audio tasks so a barge-in cancel is picked up at once
+  xTaskCreatePinnedToCore(audioStreamTask,          // Function
+                          "Speaker Task",           // Name
+                          SPEAKER_TASK_STACK_BYTES, // Stack size
+                          NULL,                     // Parameters
+                          6,                        // Priority
+                          &speakerTaskHandle,       // Handle
+                          1                         // Core 1 (application core)
+  );
+
+  // Opus decoding, fed by the network task through the jitter buffer
+  xTaskCreatePinnedToCore(audioDecodeTask,   // Function
+                          "Decode Task",     // Name
+                          8192,              // Stack size
+                          NULL,              // Parameters
+                          4,                 // Priority
+                          &decodeTaskHandle, // Handle
+                          1                  // Core 1 (application core)
   );
 
   xTaskCreatePinnedToCore(micTask,           // Function
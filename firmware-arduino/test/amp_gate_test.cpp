@@ -0,0 +1,108 @@
+/**
+ * @file amp_gate_test.cpp
+ * @brief Host-side checks of the amplifier power state machine.
+ *
+ * Build and run on the host (no board needed):
+ *   g++ -std=gnu++17 -O2 -Isrc test/amp_gate_test.cpp src/AmpGate.cpp -o amp_test && ./amp_test
+ *
+ * Replays conversation timelines in 10 ms steps (the mixer block) and checks
+ * when the amp is switched, and what the old fixed 50 ms wake and immediate
+ * switch-off would have cost in latency and on-time.
+ */
+#include <stdio.h>
+#include "AmpGate.h"
+#include "host/TestCheck.h"
+
+struct Turn {
+  uint32_t created_ms;     // RESPONSE.CREATED
+  uint32_t first_audio_ms; // first decoded block reaches the mixer
+  uint32_t end_ms;         // last block played, back to listening
+};
+
+struct Run {
+  uint32_t enables = 0;
+  uint32_t disables = 0;
+  uint32_t on_ms = 0;
+};
+
+static Run replay(AmpGate &amp, const Turn *turns, size_t count, uint32_t until_ms) {
+  Run r;
+  for (uint32_t now = 0; now < until_ms; now += 10) {
+    bool wanted = false, audio = false;
+    for (size_t i = 0; i < count; i++) {
+      wanted |= now >= turns[i].created_ms && now < turns[i].end_ms;
+      audio |= now >= turns[i].first_audio_ms && now < turns[i].end_ms;
+    }
+    AmpGate::Action a = amp.update(now, wanted, audio);
+    r.enables += a == AmpGate::AMP_ENABLE;
+    r.disables += a == AmpGate::AMP_DISABLE;
+    r.on_ms += amp.isOn() ? 10 : 0;
+  }
+  return r;
+}
+
+int main() {
+  AmpGateConfig cfg;
+  cfg.idle_hold_ms = 2000;
+
+  // an answer: on at RESPONSE.CREATED, warm when audio starts, off after the hold
+  {
+    AmpGate amp;
+    amp.begin(cfg, 0);
+    Turn t = {1000, 1350, 5000};
+    Run r = replay(amp, &t, 1, 10000);
+    CHECK(r.enables == 1);
+    CHECK(r.disables == 1);
+    CHECK(amp.stats().warm_starts == 1);
+    CHECK(amp.stats().cold_starts == 0);
+    CHECK(amp.stats().last_lead_ms == 350);
+    CHECK(r.on_ms == 4000 + 2000);
+    CHECK(!amp.isOn());
+  }
+
+  // answers closer together than the hold keep the amp on in between
+  {
+    AmpGate amp;
+    amp.begin(cfg, 0);
+    Turn turns[] = {{1000, 1300, 4000}, {5000, 5300, 8000}, {20000, 20300, 22000}};
+    Run r = replay(amp, turns, 3, 30000);
+    CHECK(r.enables == 2);
+    CHECK(r.disables == 2);
+
+    // the old scheme: on 50 ms after each RESPONSE.CREATED, off as soon as listening starts
+    uint32_t oldOn = 0;
+    for (const Turn &t : turns) {
+      oldOn += t.end_ms - (t.created_ms + 50);
+    }
+    printf("3 answers: amp on %u ms (was %u ms), %u switch-ons (was 3), 50 ms less to first audio per answer\n",
+           (unsigned)r.on_ms, (unsigned)oldOn, (unsigned)r.enables);
+    CHECK(amp.stats().on_ms + amp.stats().off_ms == 30000 - 10);
+  }
+
+  // audio without an announced answer (an earcon) is a cold start
+  {
+    AmpGate amp;
+    amp.begin(cfg, 0);
+    CHECK(amp.update(0, false, false) == AmpGate::AMP_KEEP);
+    CHECK(amp.update(100, false, true) == AmpGate::AMP_ENABLE);
+    CHECK(amp.stats().cold_starts == 1);
+    CHECK(amp.update(110, false, false) == AmpGate::AMP_KEEP);
+    CHECK(amp.msUntilOff(110) == 2000);
+    CHECK(amp.msUntilOff(1110) == 1000);
+    CHECK(amp.update(2109, false, false) == AmpGate::AMP_KEEP);
+    CHECK(amp.update(2110, false, false) == AmpGate::AMP_DISABLE);
+    CHECK(amp.msUntilOff(2110) == UINT32_MAX);
+  }
+
+  // a hold of 0 switches off on the first idle update
+  {
+    AmpGate amp;
+    AmpGateConfig c;
+    c.idle_hold_ms = 0;
+    amp.begin(c, 0);
+    CHECK(amp.update(0, true, false) == AmpGate::AMP_ENABLE);
+    CHECK(amp.update(10, false, false) == AmpGate::AMP_DISABLE);
+  }
+
+  return testResult();
+}
@@ -0,0 +1,100 @@
+/**
+ * @file audio_dsp_benchmark.cpp
+ * @brief Cycles per sample for each AudioDsp kernel on the board.
+ *
+ * Flash as a sketch with src/AudioDsp.* and src/SpeakerProtection.* next to
+ * it. On the S3 the aligned gain and mix lines take the esp-dsp SIMD path and
+ * the misaligned one the C++ loop; build once more with -DAUDIO_DSP_PORTABLE to
+ * compare against the plain per-sample loops. The speaker protection line is
+ * the worst case (3 EQ stages, every sample above the ceiling) and also gives
+ * cycles per 20 ms block.
+ *
+ * setup() first checks dspGain() and dspMix() against the scalar definitions
+ * and prints whether the samples match exactly; that is the only check of the
+ * SIMD path, since the host test runs the C++ loops.
+ */
+#include <Arduino.h>
+#include "AudioDsp.h"
+#include "SpeakerProtection.h"
+
+constexpr size_t BLOCK = 480;  // one 20 ms frame at 24 kHz
+constexpr int ROUNDS = 200;
+
+alignas(DSP_ALIGN_BYTES) static int16_t a[BLOCK], b[BLOCK + 8], out[BLOCK];
+static int32_t wide[BLOCK];
+static volatile uint32_t sink;
+static SpeakerProtection protection;
+
+template <typename F>
+static float cyclesPerSample(F kernel) {
+  uint32_t start = ESP.getCycleCount();
+  for (int r = 0; r < ROUNDS; r++) {
+    kernel();
+  }
+  return (float)(ESP.getCycleCount() - start) / (ROUNDS * BLOCK);
+}
+
+// dspGain and dspMix against the scalar definitions, aligned and misaligned,
+// for attenuation, unity and boost
+static bool matchesScalar() {
+  alignas(DSP_ALIGN_BYTES) static int16_t src[BLOCK + 8], dst[BLOCK + 8], ref[BLOCK];
+  const int32_t gains[] = {0, 16000, DSP_UNITY_Q15 - 1, DSP_UNITY_Q15, DSP_UNITY_Q15 * 2 - 1};
+  bool same = true;
+  for (int32_t gain : gains) {
+    for (size_t offset = 0; offset < 2; offset++) {
+      for (size_t i = 0; i < BLOCK; i++) {
+        src[offset + i] = (int16_t)esp_random();
+        dst[offset + i] = ref[i] = (int16_t)esp_random();
+      }
+      dspMix(dst + offset, src + offset, BLOCK, gain);
+      for (size_t i = 0; i < BLOCK; i++) {
+        same &= dst[offset + i] == dspSaturate(ref[i] + ((src[offset + i] * gain) >> 15));
+      }
+      for (size_t i = 0; i < BLOCK; i++) {
+        dst[offset + i] = ref[i] = (int16_t)esp_random();
+      }
+      dspGain(dst + offset, BLOCK, gain);
+      for (size_t i = 0; i < BLOCK; i++) {
+        same &= dst[offset + i] == dspSaturate((ref[i] * gain) >> 15);
+      }
+    }
+  }
+  return same;
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(2000);
+  for (size_t i = 0; i < BLOCK; i++) {
+    a[i] = (int16_t)esp_random();
+    b[i] = (int16_t)esp_random();
+    wide[i] = (int32_t)(int16_t)esp_random() << 8;
+  }
+  Serial.printf("SIMD matches scalar: %s\n", matchesScalar() ? "yes" : "NO");
+  SpeakerProtectionConfig cfg;
+  cfg.eq[0] = {BIQUAD_HIGHPASS, 180, 0.707f, 0};
+  cfg.eq[1] = {BIQUAD_PEAK, 2800, 1.2f, 3};
+  cfg.eq[2] = {BIQUAD_HIGHSHELF, 7000, 0.707f, -3};
+  protection.setGain(65535);
+  protection.begin(cfg);
+}
+
+void loop() {
+  Serial.printf("gain      %.2f cycles/sample\n", cyclesPerSample([] { dspGain(a, BLOCK, 32000); }));
+  Serial.printf("mix       %.2f cycles/sample\n", cyclesPerSample([] { dspMix(out, b, BLOCK, 16000); }));
+  Serial.printf("mix unity %.2f cycles/sample\n", cyclesPerSample([] { dspMix(out, b, BLOCK, DSP_UNITY_Q15); }));
+  Serial.printf("mix +1    %.2f cycles/sample (misaligned)\n", cyclesPerSample([] { dspMix(out, b + 1, BLOCK, 16000); }));
+  Serial.printf("crossfade %.2f cycles/sample\n", cyclesPerSample([] { dspCrossfade(out, a, b, BLOCK, 0, BLOCK); }));
+  Serial.printf("narrow    %.2f cycles/sample\n", cyclesPerSample([] { dspNarrow(out, wide, BLOCK, 8); }));
+  Serial.printf("levels    %.2f cycles/sample\n", cyclesPerSample([] { sink += dspLevels(a, BLOCK).rms; }));
+  float protect = cyclesPerSample([] {
+    for (size_t i = 0; i < BLOCK; i++) {
+      out[i] = (i & 1) ? 30000 : -30000;
+    }
+    protection.process(out, BLOCK);
+  });
+  Serial.printf("protect   %.2f cycles/sample, %.0f cycles per 20 ms block (refill included)\n", protect,
+                protect * BLOCK);
+  Serial.println();
+  delay(5000);
+}
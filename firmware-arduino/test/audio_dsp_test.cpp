@@ -0,0 +1,221 @@
+/**
+ * @file audio_dsp_test.cpp
+ * @brief Host unit tests and per-kernel benchmark for AudioDsp.
+ *
+ * Build and run on the host (no board needed):
+ *   g++ -std=gnu++17 -O2 -Isrc test/audio_dsp_test.cpp src/AudioDsp.cpp -o dsp_test && ./dsp_test
+ *
+ * On the host this runs the C++ fallback that the ESP32-S3 SIMD path must match.
+ * Add -DAUDIO_DSP_PORTABLE to compare against the plain per-sample loops. The
+ * benchmark reports ns/sample on the host; test/audio_dsp_benchmark.cpp gives
+ * cycles/sample on the board.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+#include "AudioDsp.h"
+#include "host/TestCheck.h"
+
+static uint32_t rng = 12345;
+static int16_t nextSample() {
+  rng = rng * 1103515245u + 12345u;
+  return (int16_t)(rng >> 16);
+}
+
+static void testGain() {
+  int16_t buf[7] = {0, 1000, -1000, 32767, -32768, 16384, -16384};
+  dspGain(buf, 7, DSP_UNITY_Q15 / 2);
+  CHECK(buf[1] == 500 && buf[2] == -500);
+  CHECK(buf[3] == 16383 && buf[4] == -16384);
+
+  int16_t loud[5] = {20000, -20000, 100, -100, 0};
+  dspGain(loud, 5, DSP_UNITY_Q15 * 2 - 1);  // boost saturates instead of wrapping
+  CHECK(loud[0] == 32767 && loud[1] == -32768);
+  CHECK(loud[2] == 199 && loud[3] == -200);
+
+  int16_t same[3] = {1, 2, 3};
+  dspGain(same, 3, DSP_UNITY_Q15);
+  CHECK(same[0] == 1 && same[2] == 3);
+
+  // SIMD on the S3, unrolled body and tail agree with the scalar definition,
+  // aligned and misaligned, for attenuation and boost
+  const size_t n = 1027;
+  alignas(DSP_ALIGN_BYTES) int16_t v[n + 8];
+  std::vector<int16_t> ref(n);
+  bool same_as_scalar = true;
+  for (int32_t gain : {0, 23000, (int)DSP_UNITY_Q15 - 1, (int)DSP_UNITY_Q15 * 2 - 1}) {
+    for (size_t offset : {0, 1, 8}) {
+      for (size_t i = 0; i < n; i++) {
+        v[offset + i] = ref[i] = nextSample();
+      }
+      dspGain(v + offset, n, gain);
+      for (size_t i = 0; i < n; i++) {
+        same_as_scalar &= v[offset + i] == dspSaturate((ref[i] * gain) >> 15);
+      }
+    }
+  }
+  CHECK(same_as_scalar);
+}
+
+static void testMix() {
+  int16_t dst[5] = {1000, 30000, -30000, 0, 7};
+  int16_t src[5] = {1000, 10000, -10000, -2000, 7};
+  dspMix(dst, src, 5, DSP_UNITY_Q15 / 2);
+  CHECK(dst[0] == 1500);
+  CHECK(dst[1] == 32767 && dst[2] == -32768);
+  CHECK(dst[3] == -1000);
+  CHECK(dst[4] == 10);
+
+  CHECK(dspGainFromPercent(100) == DSP_UNITY_Q15);
+  CHECK(dspGainFromPercent(50) == DSP_UNITY_Q15 / 2);
+  CHECK(dspGainFromPercent(-5) == 0);
+
+  // Every path (SIMD on the S3, unrolled body, tail) agrees with the scalar
+  // definition, for aligned and misaligned buffers, odd lengths, unity and boost.
+  const int32_t gains[] = {0, 23000, DSP_UNITY_Q15 - 1, DSP_UNITY_Q15, DSP_UNITY_Q15 * 2 - 1};
+  const size_t n = 1027;
+  alignas(DSP_ALIGN_BYTES) int16_t mix_src[n + 8], mix_dst[n + 8];
+  bool same_as_scalar = true;
+  for (int32_t gain : gains) {
+    for (size_t offset : {0, 1, 8}) {
+      for (size_t count : {n, (size_t)480, (size_t)13}) {
+        std::vector<int16_t> ref(count);
+        for (size_t i = 0; i < count; i++) {
+          mix_src[offset + i] = nextSample();
+          mix_dst[offset + i] = ref[i] = nextSample();
+        }
+        dspMix(mix_dst + offset, mix_src + offset, count, gain);
+        for (size_t i = 0; i < count; i++) {
+          same_as_scalar &= mix_dst[offset + i] == dspSaturate(ref[i] + ((mix_src[offset + i] * gain) >> 15));
+        }
+      }
+    }
+  }
+  CHECK(same_as_scalar);
+}
+
+static void testMixRamp() {
+  const size_t n = 64;
+  std::vector<int16_t> dst(n, 0), src(n, 20000);
+  dspMixRamp(dst.data(), src.data(), n, DSP_UNITY_Q15, 0);
+  CHECK(dst[0] == 20000);
+  CHECK(dst[n - 1] < 20000 / 32 + 1);
+  bool falling = true;
+  for (size_t i = 1; i < n; i++) {
+    falling &= dst[i] <= dst[i - 1];
+  }
+  CHECK(falling);
+
+  std::vector<int16_t> flat(n, 0);
+  dspMixRamp(flat.data(), src.data(), n, DSP_UNITY_Q15 / 2, DSP_UNITY_Q15 / 2);
+  CHECK(flat[0] == 10000 && flat[n - 1] == 10000);
+}
+
+static void testCrossfade() {
+  const size_t n = 100;
+  std::vector<int16_t> from(n, 10000), to(n, -10000), out(n);
+  dspCrossfade(out.data(), from.data(), to.data(), n, 0, n);
+  CHECK(out[0] == 10000);
+  CHECK(abs(out[n / 2]) <= 1);
+  CHECK(out[n - 1] < -9500);
+  bool monotonic = true;
+  for (size_t i = 1; i < n; i++) {
+    monotonic &= out[i] <= out[i - 1];
+  }
+  CHECK(monotonic);
+
+  // split over two blocks gives the same result as one block
+  std::vector<int16_t> split(n);
+  dspCrossfade(split.data(), from.data(), to.data(), 40, 0, n);
+  dspCrossfade(split.data() + 40, from.data() + 40, to.data() + 40, n - 40, 40, n);
+  CHECK(split == out);
+
+  // past the end of the fade, and in place
+  std::vector<int16_t> tail = from;
+  dspCrossfade(tail.data(), tail.data(), to.data(), n, n, n);
+  CHECK(tail[0] == -10000 && tail[n - 1] == -10000);
+}
+
+static void testNarrow() {
+  int32_t in[5] = {0, 1 << 16, -(1 << 16), 0x7fffffff, (int32_t)0x80000000};
+  int16_t out[5];
+  dspNarrow(out, in, 5, 8);
+  CHECK(out[0] == 0 && out[1] == 256 && out[2] == -256);
+  CHECK(out[3] == 32767 && out[4] == -32768);
+  dspNarrow(out, in, 5, 16);
+  CHECK(out[1] == 1 && out[3] == 32767 && out[4] == -32768);
+}
+
+static void testLevels() {
+  DspLevels silent = dspLevels(nullptr, 0);
+  CHECK(silent.peak == 0 && silent.rms == 0);
+
+  int16_t square[4] = {1000, -1000, 1000, -1000};
+  DspLevels sq = dspLevels(square, 4);
+  CHECK(sq.peak == 1000 && sq.rms == 1000 && sq.clipped == 0);
+
+  std::vector<int16_t> sine(2400);
+  for (size_t i = 0; i < sine.size(); i++) {
+    sine[i] = (int16_t)lrint(16384 * sin(2 * M_PI * 440 * i / 24000.0));
+  }
+  DspLevels s = dspLevels(sine.data(), sine.size());
+  CHECK(s.peak >= 16380);
+  CHECK(abs((int)s.rms - 11585) < 60);  // 16384 / sqrt(2)
+
+  int16_t clip[3] = {32767, -32768, 5};
+  DspLevels c = dspLevels(clip, 3);
+  CHECK(c.peak == 32767 && c.clipped == 2);
+
+  // the shared square root, for stages that gather their own sum of squares
+  CHECK(dspRms(0, 0) == 0);
+  CHECK(dspRms(4ull * 1000 * 1000, 4) == 1000);
+  CHECK(dspRms(2ull * 32768 * 32768, 2) == 32767);
+}
+
+// --- benchmark --------------------------------------------------------------
+
+template <typename F>
+static double nsPerSample(size_t samples, F kernel) {
+  const int rounds = 2000;
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    kernel();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / ((double)rounds * samples);
+}
+
+static void benchmark() {
+  const size_t n = 480;  // one 20 ms frame at 24 kHz
+  std::vector<int16_t> a(n), b(n), out(n);
+  std::vector<int32_t> wide(n);
+  for (size_t i = 0; i < n; i++) {
+    a[i] = nextSample();
+    b[i] = nextSample();
+    wide[i] = (int32_t)nextSample() << 8;
+  }
+  volatile uint32_t sink = 0;
+
+  printf("kernel      ns/sample (%zu-sample blocks)\n", n);
+  printf("gain        %.3f\n", nsPerSample(n, [&] { dspGain(a.data(), n, 32000); }));
+  printf("mix         %.3f\n", nsPerSample(n, [&] { dspMix(out.data(), b.data(), n, 16000); }));
+  printf("mix ramp    %.3f\n", nsPerSample(n, [&] { dspMixRamp(out.data(), b.data(), n, 32768, 8192); }));
+  printf("crossfade   %.3f\n", nsPerSample(n, [&] { dspCrossfade(out.data(), a.data(), b.data(), n, 0, n); }));
+  printf("narrow      %.3f\n", nsPerSample(n, [&] { dspNarrow(out.data(), wide.data(), n, 8); }));
+  printf("levels      %.3f\n", nsPerSample(n, [&] { sink += dspLevels(a.data(), n).rms; }));
+  (void)sink;
+}
+
+int main() {
+  testGain();
+  testMix();
+  testMixRamp();
+  testCrossfade();
+  testNarrow();
+  testLevels();
+  benchmark();
+
+  return testResult();
+}
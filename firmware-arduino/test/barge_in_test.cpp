@@ -0,0 +1,158 @@
+/**
+ * @file barge_in_test.cpp
+ * @brief Host test of the barge-in cancel path in AudioMixer.
+ *
+ * Build and run on the host (no board needed):
+ *   g++ -std=gnu++17 -O2 -Itest/host -Isrc test/barge_in_test.cpp src/AudioMixer.cpp \
+ *       src/PcmFramePool.cpp src/AudioDsp.cpp -o barge_in_test && ./barge_in_test
+ *
+ * Checks that fadeOut() ramps speech to silence within the fade, drops every
+ * queued frame, hands the frames back to the decoder, and leaves other sources
+ * playing. The I2S side (DMA ring, latency report) is exercised on the board.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "AudioMixer.h"
+#include "host/TestCheck.h"
+
+constexpr size_t BLOCK = 240;       // 10 ms at 24 kHz
+constexpr size_t FADE = 120;        // 5 ms
+constexpr size_t FRAME = 2880;      // 120 ms Opus packet
+
+static TaskHandle_t decoder = (TaskHandle_t)1;
+
+static void fill(PcmFramePool &pool, int16_t value) {
+  PcmFrame *frame;
+  while ((frame = pool.acquire(0)) != nullptr) {
+    for (size_t i = 0; i < frame->capacity; i++) {
+      frame->samples[i] = value;
+    }
+    frame->count = frame->capacity;
+    pool.submit(frame);
+  }
+}
+
+static size_t freeFrames(PcmFramePool &pool) {
+  PcmFrame *taken[16];
+  size_t n = 0;
+  while (n < 16 && (taken[n] = pool.acquire(0)) != nullptr) {
+    n++;
+  }
+  for (size_t i = 0; i < n; i++) {
+    pool.release(taken[i]);
+  }
+  return n;
+}
+
+static void setup(AudioMixer &mixer, PcmFramePool &speech, PcmFramePool *bhajan) {
+  mixer.begin(DSP_UNITY_Q15, 60);  // no gain ramp, so levels are exact
+  AudioMixer::SourceConfig s;
+  s.pool = &speech;
+  s.priority = 2;
+  s.producer = &decoder;
+  mixer.addSource(MIXER_SPEECH, s);
+  if (bhajan) {
+    AudioMixer::SourceConfig b;
+    b.pool = bhajan;
+    b.duck_gain_q15 = DSP_UNITY_Q15 / 4;
+    mixer.addSource(MIXER_BHAJAN, b);
+  }
+}
+
+static void speechOnly() {
+  PcmFramePool speech;
+  speech.begin(4, FRAME);
+  AudioMixer mixer;
+  setup(mixer, speech, nullptr);
+  fill(speech, 12000);
+
+  int16_t out[BLOCK];
+  for (int i = 0; i < 3; i++) {
+    CHECK(mixer.mix(out, BLOCK));
+  }
+  CHECK(out[0] == 12000 && out[BLOCK - 1] == 12000);
+
+  uint32_t notified = hostNotifyCount();
+  mixer.fadeOut(MIXER_SPEECH, FADE);
+  CHECK(mixer.mix(out, BLOCK));  // the fade block is still written
+
+  // ramp down, no step larger than a linear fade would take
+  int max_step = abs(12000 - out[0]);
+  for (size_t i = 1; i < BLOCK; i++) {
+    int step = abs(out[i] - out[i - 1]);
+    max_step = step > max_step ? step : max_step;
+  }
+  CHECK(out[0] > 11000);
+  CHECK(max_step <= 2 * 12000 / (int)FADE);
+  bool silent_after = true;
+  for (size_t i = FADE; i < BLOCK; i++) {
+    silent_after &= out[i] == 0;
+  }
+  CHECK(silent_after);
+
+  // everything queued was dropped and handed back to the decoder
+  CHECK(!mixer.isPlaying(MIXER_SPEECH));
+  CHECK(!mixer.isFading(MIXER_SPEECH));
+  CHECK(speech.readyCount() == 0);
+  CHECK(freeFrames(speech) == 4);
+  CHECK(hostNotifyCount() > notified);
+
+  // nothing else plays, so the owner may go back to sleep
+  CHECK(!mixer.mix(out, BLOCK));
+}
+
+static void underBhajan() {
+  PcmFramePool speech, bhajan;
+  speech.begin(4, FRAME);
+  bhajan.begin(4, 2048);
+  AudioMixer mixer;
+  setup(mixer, speech, &bhajan);
+
+  int16_t out[BLOCK];
+  fill(bhajan, 4000);
+  mixer.mix(out, BLOCK);
+  fill(speech, 12000);
+  fill(bhajan, 4000);
+  mixer.mix(out, BLOCK);
+  fill(bhajan, 4000);
+  mixer.mix(out, BLOCK);
+  fill(bhajan, 4000);
+  mixer.mix(out, BLOCK);                  // duck ramp finished
+  CHECK(out[0] == 12000 + 1000);          // bhajan ducked to a quarter
+
+  mixer.fadeOut(MIXER_SPEECH, FADE);
+  fill(bhajan, 4000);
+  CHECK(mixer.mix(out, BLOCK));
+  CHECK(out[FADE] == 1000);               // speech gone, bhajan keeps playing
+  CHECK(mixer.isPlaying(MIXER_BHAJAN));
+  CHECK(freeFrames(speech) == 4);
+
+  // a new answer after the cancel starts cleanly
+  fill(speech, 8000);
+  fill(bhajan, 4000);
+  mixer.mix(out, BLOCK);
+  CHECK(mixer.lastBlockSamples(MIXER_SPEECH) == BLOCK);
+}
+
+static void fadeLongerThanBlock() {
+  PcmFramePool speech;
+  speech.begin(2, FRAME);
+  AudioMixer mixer;
+  setup(mixer, speech, nullptr);
+  fill(speech, 10000);
+  int16_t out[BLOCK];
+  mixer.mix(out, BLOCK);
+
+  // fades are capped at one block so the cancel never waits for a second one
+  mixer.fadeOut(MIXER_SPEECH, BLOCK * 4);
+  mixer.mix(out, BLOCK);
+  CHECK(abs(out[BLOCK - 1]) < 10000 / 100);
+  CHECK(freeFrames(speech) == 2);
+}
+
+int main() {
+  speechOnly();
+  underBhajan();
+  fadeLongerThanBlock();
+  return testResult();
+}
@@ -0,0 +1,134 @@
+/**
+ * @file dma_tuner_test.cpp
+ * @brief Host-side checks of the I2S DMA auto-tuning policy.
+ *
+ * Build and run on the host (no board needed):
+ *   g++ -std=gnu++17 -O2 -Isrc test/dma_tuner_test.cpp src/DmaTuner.cpp -o dma_test && ./dma_test
+ *
+ * Simulates a stream whose DMA ring starves whenever it holds less than a given
+ * number of frames and checks that the tuner settles just above that point.
+ */
+#include <stdio.h>
+#include "DmaTuner.h"
+#include "host/TestCheck.h"
+
+static DmaTunerConfig outputConfig() {
+  DmaTunerConfig c;
+  c.min_buffers = 2;
+  c.max_buffers = 6;
+  c.min_frames = 120;
+  c.max_frames = 240;
+  c.frame_step = 40;
+  c.max_total_frames = 840;
+  c.grow_hold_ms = 2000;
+  c.shrink_after_ms = 60000;
+  c.max_shrink_after_ms = 1800000;
+  return c;
+}
+
+static DmaSettings make(uint8_t buffers, uint16_t frames) {
+  DmaSettings s;
+  s.buffers = buffers;
+  s.frames = frames;
+  return s;
+}
+
+// Runs `minutes` of streaming in 100 ms ticks. The ring starves once every
+// 5 s while it holds fewer than `needed` frames.
+static void simulate(DmaTuner &tuner, uint32_t &now, uint32_t &xruns, uint32_t needed, uint32_t minutes,
+                     uint32_t *changes = nullptr) {
+  for (uint32_t t = 0; t < minutes * 600; t++) {
+    now += 100;
+    if (tuner.settings().totalFrames() < needed && now % 5000 == 0) {
+      xruns++;
+    }
+    if (tuner.update(now, xruns, true) && changes) {
+      (*changes)++;
+    }
+  }
+}
+
+static void clampsToLimits() {
+  DmaTuner tuner;
+  tuner.begin(outputConfig(), make(12, 1024));
+  CHECK(tuner.settings().totalFrames() <= 840);
+  CHECK(tuner.settings().buffers <= 6 && tuner.settings().frames <= 240);
+
+  tuner.set(make(1, 16));
+  CHECK(tuner.settings() == make(2, 120));
+}
+
+static void growsOnXrunsAndHolds() {
+  DmaTuner tuner;
+  tuner.begin(outputConfig(), make(2, 120));
+  CHECK(!tuner.update(100, 0, true));
+  CHECK(tuner.update(200, 1, true));
+  CHECK(tuner.settings() == make(3, 120));  // buffers first
+  // a burst of xruns right after a grow is one event
+  CHECK(!tuner.update(300, 4, true));
+  CHECK(tuner.settings() == make(3, 120));
+  CHECK(tuner.update(2300, 5, true));
+  CHECK(tuner.settings() == make(4, 120));
+  CHECK(tuner.grows() == 2 && tuner.xruns() == 5);
+}
+
+static void neverExceedsTotal() {
+  DmaTuner tuner;
+  tuner.begin(outputConfig(), make(2, 240));
+  uint32_t now = 0;
+  for (uint32_t xruns = 1; xruns < 50; xruns++) {
+    now += 3000;
+    tuner.update(now, xruns, true);
+    CHECK(tuner.settings().totalFrames() <= 840);
+  }
+  CHECK(tuner.settings() == make(3, 240));
+}
+
+static void settlesNearTheLimit() {
+  DmaTuner tuner;
+  tuner.begin(outputConfig(), make(6, 120));
+  uint32_t now = 0, xruns = 0, changes = 0;
+  // the ring needs at least 480 frames; start large and shrink towards it
+  simulate(tuner, now, xruns, 480, 120, &changes);
+  uint32_t total = tuner.settings().totalFrames();
+  printf("settled on %u x %u frames after %u changes, %u xruns\n", tuner.settings().buffers,
+         tuner.settings().frames, changes, xruns);
+  CHECK(total >= 480 && total <= 600);
+  // backoff keeps the number of probing xruns small
+  CHECK(xruns <= 8);
+}
+
+static void idleTimeDoesNotShrink() {
+  DmaTuner tuner;
+  tuner.begin(outputConfig(), make(4, 120));
+  uint32_t now = 0;
+  for (int i = 0; i < 10000; i++) {
+    now += 100;
+    CHECK(!tuner.update(now, 0, false));
+  }
+  CHECK(tuner.settings() == make(4, 120));
+  // gaps between active periods do not count either
+  tuner.update(now, 0, true);
+  now += 10 * 60000;
+  CHECK(!tuner.update(now, 0, true));
+}
+
+static void autoTuneOff() {
+  DmaTuner tuner;
+  tuner.begin(outputConfig(), make(3, 120));
+  tuner.setAutoTune(false);
+  uint32_t now = 0, xruns = 0;
+  simulate(tuner, now, xruns, 800, 10);
+  CHECK(tuner.settings() == make(3, 120));
+  CHECK(tuner.xruns() == xruns && xruns > 0);
+}
+
+int main() {
+  clampsToLimits();
+  growsOnXrunsAndHolds();
+  neverExceedsTotal();
+  settlesNearTheLimit();
+  idleTimeDoesNotShrink();
+  autoTuneOff();
+  return testResult();
+}
@@ -0,0 +1,144 @@
+/**
+ * @file drift_estimator_test.cpp
+ * @brief Host-side checks of the clock drift estimator against a simulated stream.
+ *
+ * Build and run on the host (no board needed):
+ *   g++ -std=gnu++17 -O2 -Isrc test/drift_estimator_test.cpp src/DriftEstimator.cpp -o drift_test && ./drift_test
+ *
+ * A source sends 20 ms packets at its own clock, off by a given number of ppm
+ * and with random network jitter; playback consumes 10 ms blocks at the local
+ * clock, trimmed by the estimator's correction. Checks that the estimate finds
+ * the drift and the buffer stays centred where it would otherwise run away.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <initializer_list>
+#include "DriftEstimator.h"
+#include "host/TestCheck.h"
+
+constexpr uint32_t RATE = 24000;
+constexpr int32_t TARGET = 2400;  // 100 ms
+
+struct Result {
+  int32_t drift_ppm;
+  double max_error_ms;    // fill error over the second half of the run
+  double final_error_ms;  // average fill error over the last minute
+};
+
+// Runs `minutes` of a stream whose clock is `drift_ppm` off, with up to
+// `jitter_ms` of arrival jitter. `correct` applies the estimator's correction.
+static Result simulate(DriftEstimator &est, double drift_ppm, int jitter_ms, int minutes, bool correct,
+                       bool throttled = false) {
+  srand(7);
+  const uint32_t end_ms = minutes * 60000;
+  const uint32_t packet = RATE / 50;  // 20 ms
+  double fill = TARGET;
+  double next_send_ms = 0;            // source clock, in local ms
+  uint32_t next_arrival_ms = 0;
+  Result r = {0, 0, 0};
+  double last_minute = 0;
+  int last_count = 0;
+
+  for (uint32_t now = 0; now < end_ms; now += 10) {
+    // packets arrive in order, each delayed by up to jitter_ms
+    while (next_arrival_ms <= now) {
+      fill += packet;
+      next_send_ms += 20.0 / (1 + drift_ppm * 1e-6);
+      uint32_t arrival = (uint32_t)next_send_ms + (jitter_ms ? rand() % (jitter_ms + 1) : 0);
+      next_arrival_ms = arrival > next_arrival_ms ? arrival : next_arrival_ms;
+    }
+    int32_t ppm = est.update(now, (int32_t)fill, !throttled);
+    fill -= 240 * (1 + (correct ? ppm : 0) * 1e-6);
+
+    double error_ms = (fill - TARGET) * 1000.0 / RATE;
+    if (now >= end_ms / 2 && fabs(error_ms) > r.max_error_ms) {
+      r.max_error_ms = fabs(error_ms);
+    }
+    if (now >= end_ms - 60000) {
+      last_minute += error_ms;
+      last_count++;
+    }
+  }
+  r.drift_ppm = est.driftPpm();
+  r.final_error_ms = last_minute / last_count;
+  return r;
+}
+
+static DriftEstimator make() {
+  DriftEstimator est;
+  DriftEstimatorConfig cfg;
+  cfg.sample_rate = RATE;
+  est.begin(cfg);
+  est.setTarget(TARGET);
+  return est;
+}
+
+int main() {
+  printf("%9s  %9s  %12s  %12s  %14s\n", "drift", "estimate", "max err ms", "final err ms", "uncorrected ms");
+  for (double drift : {-250.0, -80.0, 0.0, 35.0, 200.0}) {
+    DriftEstimator est = make();
+    Result r = simulate(est, drift, 40, 60, true);
+    DriftEstimator open = make();
+    Result u = simulate(open, drift, 40, 60, false);
+    printf("%9.0f  %9d  %12.1f  %12.1f  %14.1f\n", drift, (int)r.drift_ppm, r.max_error_ms, r.final_error_ms,
+           u.final_error_ms);
+
+    CHECK(fabs(r.drift_ppm - drift) <= 25);
+    CHECK(abs(est.correctionPpm()) <= 300);
+    CHECK(r.max_error_ms < 60);  // mostly the 40 ms of jitter itself
+    CHECK(fabs(r.final_error_ms) < 15);
+    // without correction the fill runs away by the drift times the run time
+    if (fabs(drift) >= 80) {
+      CHECK(fabs(u.final_error_ms) > 200);
+    }
+  }
+
+  // beyond the correction limit the drift is still reported, the correction saturates
+  {
+    DriftEstimator est = make();
+    Result r = simulate(est, 600, 20, 30, true);
+    CHECK(fabs(r.drift_ppm - 600) <= 40);
+    CHECK(est.correctionPpm() == 300);
+  }
+
+  // a throttled source (e.g. a file downloaded into a full buffer) teaches nothing
+  {
+    DriftEstimator est = make();
+    simulate(est, 200, 20, 10, true, true);
+    CHECK(est.driftPpm() == 0);
+    CHECK(est.correctionPpm() == 0);
+    CHECK(est.stats().windows == 0);
+    CHECK(est.stats().skipped_windows > 0);
+  }
+
+  // reset() between streams keeps the estimate and applies it right away
+  {
+    DriftEstimator est = make();
+    simulate(est, -150, 20, 20, true);
+    int32_t learned = est.driftPpm();
+    est.reset();
+    CHECK(est.driftPpm() == learned);
+    CHECK(est.correctionPpm() == learned);
+  }
+
+  // target 0 centres on the first steady window, after the initial burst
+  {
+    DriftEstimator est;
+    DriftEstimatorConfig cfg;
+    est.begin(cfg);
+    uint32_t now = 0;
+    for (; now <= 10000; now += 10) {
+      est.update(now, now / 2, true);  // 20x real time
+    }
+    for (; now <= 40000; now += 10) {
+      est.update(now, 5000, true);
+    }
+    CHECK(est.targetFill() == 5000);
+    CHECK(est.stats().fill_error == 0);
+    CHECK(est.driftPpm() == 0);
+    CHECK(est.stats().skipped_windows == 1);
+  }
+
+  return testResult();
+}
@@ -0,0 +1,99 @@
+/**
+ * @file earcon_test.cpp
+ * @brief Host-side checks of flash earcon playback.
+ *
+ * Build and run on the host (no board needed):
+ *   g++ -std=gnu++17 -O2 -Isrc test/earcon_test.cpp src/Earcon.cpp -o earcon_test && ./earcon_test
+ *
+ * Plays the thinking cue as audioStreamTask does, one mixer block at a time,
+ * and checks its level, its loop period and the conversion to other rates.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "Earcon.h"
+#include "host/TestCheck.h"
+
+static std::vector<int16_t> play(EarconPlayer &p, size_t total, size_t block) {
+  std::vector<int16_t> out(total);
+  for (size_t i = 0; i < total; i += block) {
+    size_t n = total - i < block ? total - i : block;
+    size_t got = p.read(out.data() + i, n);
+    if (got < n) {
+      out.resize(i + got);
+      break;
+    }
+  }
+  return out;
+}
+
+int main() {
+  const EarconClip &clip = EARCON_THINKING;
+  CHECK(clip.sample_rate == 24000);
+  CHECK(clip.count > 0 && clip.count * 1000 / clip.sample_rate < clip.period_ms);
+
+  int peak = 0;
+  for (size_t i = 0; i < clip.count; i++) {
+    peak = abs(clip.samples[i]) > peak ? abs(clip.samples[i]) : peak;
+  }
+  printf("thinking cue: %u samples, peak %d, every %u ms\n", (unsigned)clip.count, peak, (unsigned)clip.period_ms);
+  CHECK(peak > 2000 && peak < 8000);
+  CHECK(abs(clip.samples[0]) < 50 && abs(clip.samples[clip.count - 1]) < 50);  // no click at either end
+
+  // at the clip rate: the clip, then silence, then the clip again
+  {
+    EarconPlayer p;
+    p.start(&clip, 24000);
+    std::vector<int16_t> out = play(p, 24000 * 3, 240);
+    size_t period = clip.sample_rate * clip.period_ms / 1000;
+    bool same = true, silent = true;
+    for (size_t i = 0; i < clip.count; i++) {
+      same &= out[i] == clip.samples[i] && out[period + i] == clip.samples[i];
+    }
+    for (size_t i = clip.count; i < period; i++) {
+      silent &= out[i] == 0;
+    }
+    CHECK(same);
+    CHECK(silent);
+    CHECK(p.active());
+  }
+
+  // at 48 kHz: twice the samples, the same shape
+  {
+    EarconPlayer p;
+    p.start(&clip, 48000);
+    std::vector<int16_t> out = play(p, 48000 * 2, 480);
+    int err = 0;
+    for (size_t i = 0; i + 1 < clip.count; i++) {
+      err = abs(out[2 * i] - clip.samples[i]) > err ? abs(out[2 * i] - clip.samples[i]) : err;
+    }
+    CHECK(err <= 1);
+    CHECK(out[48 * clip.period_ms + 2] == clip.samples[1]);
+  }
+
+  // at 16 kHz the loop period keeps its length in time
+  {
+    EarconPlayer p;
+    p.start(&clip, 16000);
+    std::vector<int16_t> out = play(p, 16000 * 4, 160);
+    size_t starts = 0;
+    for (size_t i = 1; i < out.size(); i++) {
+      starts += out[i - 1] == 0 && out[i] != 0 && (i < 16 || out[i - 16] == 0);
+    }
+    CHECK(starts == 3);  // at 0, 1.5 s and 3 s
+  }
+
+  // a one-shot clip ends
+  {
+    EarconClip once = clip;
+    once.period_ms = 0;
+    EarconPlayer p;
+    p.start(&once, 24000);
+    std::vector<int16_t> out = play(p, 24000, 240);
+    CHECK(out.size() == clip.count);
+    CHECK(!p.active());
+  }
+
+  return testResult();
+}
@@ -0,0 +1,68 @@
+/**
+ * @file Arduino.h
+ * @brief Minimal single-threaded stand-in for the Arduino/FreeRTOS API used by
+ * PcmFramePool, AudioMixer and OpusFrameDecoder, so they can be built into
+ * host tests with -Itest/host. Queues never block; task notifications are
+ * counted; Serial prints to stdout.
+ */
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <deque>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef void *TaskHandle_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xffffffffu
+
+struct HostQueue {
+  std::deque<void *> items;
+  size_t length;
+};
+typedef HostQueue *QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(size_t length, size_t) {
+  HostQueue *q = new HostQueue;
+  q->length = length;
+  return q;
+}
+inline void vQueueDelete(QueueHandle_t q) { delete q; }
+inline BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t) {
+  if (q->items.size() >= q->length) {
+    return pdFALSE;
+  }
+  q->items.push_back(*(void *const *)item);
+  return pdTRUE;
+}
+inline BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t) {
+  if (q->items.empty()) {
+    return pdFALSE;
+  }
+  *(void **)item = q->items.front();
+  q->items.pop_front();
+  return pdTRUE;
+}
+inline size_t uxQueueMessagesWaiting(QueueHandle_t q) { return q->items.size(); }
+
+// counts notifications per handle value (handles are plain integers in tests)
+inline uint32_t &hostNotifyCount() {
+  static uint32_t count = 0;
+  return count;
+}
+inline void xTaskNotifyGive(TaskHandle_t) { hostNotifyCount()++; }
+
+struct HostSerial {
+  template <class... Args>
+  void printf(const char *format, Args... args) { ::printf(format, args...); }
+  void println(const char *line) { ::puts(line); }
+};
+inline HostSerial Serial;
+
+#endif
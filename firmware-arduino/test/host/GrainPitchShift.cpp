@@ -0,0 +1,75 @@
+#include "GrainPitchShift.h"
+
+#include <array>
+#include <string.h>
+
+namespace {
+
+constexpr uint32_t GRAIN_MASK = PITCH_GRAIN_SAMPLES - 1;
+constexpr int FADE_SHIFT = 10;  // weights are Q10
+static_assert(PITCH_GRAIN_SAMPLES == 1u << FADE_SHIFT, "the fade spans one grain");
+
+// weight of the second tap: 0 for the first quarter of the grain, a linear
+// ramp across the middle half, 1 for the last quarter
+constexpr std::array<uint16_t, PITCH_GRAIN_SAMPLES> buildFade() {
+  std::array<uint16_t, PITCH_GRAIN_SAMPLES> fade{};
+  for (size_t i = 0; i < PITCH_GRAIN_SAMPLES; i++) {
+    if (i >= PITCH_GRAIN_SAMPLES * 3 / 4) {
+      fade[i] = PITCH_GRAIN_SAMPLES;
+    } else if (i >= PITCH_GRAIN_SAMPLES / 4) {
+      fade[i] = (uint16_t)((i - PITCH_GRAIN_SAMPLES / 4) * 2);
+    }
+  }
+  return fade;
+}
+
+constexpr std::array<uint16_t, PITCH_GRAIN_SAMPLES> FADE = buildFade();
+
+}  // namespace
+
+void GrainPitchShift::begin(float pitch) {
+  pitch_mul = (uint32_t)(pitch * 256.0f + 0.5f);
+  secondary_offset = PITCH_GRAIN_SAMPLES - (((pitch_mul * PITCH_GRAIN_SAMPLES) >> 8) & GRAIN_MASK);
+  reset();
+}
+
+void GrainPitchShift::reset() {
+  memset(grains, 0, sizeof(grains));
+  writing = 0;
+  write_pos = 0;
+}
+
+void GrainPitchShift::process(const int16_t *in, int16_t *out, size_t count) {
+  while (count > 0) {
+    // up to the end of the current grain
+    size_t run = PITCH_GRAIN_SAMPLES - write_pos;
+    if (run > count) {
+      run = count;
+    }
+    int16_t *dst = grains[writing];
+    const int16_t *src = grains[writing ^ 1];
+    const uint16_t *fade = FADE.data();
+    const uint32_t mul = pitch_mul, offset = secondary_offset;
+    uint32_t w = write_pos;
+    uint32_t read = w * mul;  // Q8 read position of the first tap
+
+    for (size_t i = 0; i < run; i++, w++) {
+      dst[w] = in[i];
+      uint32_t tap = read >> 8;
+      read += mul;
+      int32_t a = src[tap & GRAIN_MASK];
+      int32_t b = src[(tap + offset) & GRAIN_MASK];
+      int32_t f = fade[w];
+      out[i] = (int16_t)((a * ((int32_t)PITCH_GRAIN_SAMPLES - f) + b * f + (1 << (FADE_SHIFT - 1))) >> FADE_SHIFT);
+    }
+
+    in += run;
+    out += run;
+    count -= run;
+    write_pos = w;
+    if (write_pos == PITCH_GRAIN_SAMPLES) {
+      write_pos = 0;
+      writing ^= 1;
+    }
+  }
+}
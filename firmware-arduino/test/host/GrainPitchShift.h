@@ -0,0 +1,42 @@
+#ifndef GRAINPITCHSHIFT_H
+#define GRAINPITCHSHIFT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Two-grain pitch shifter for mono int16 audio: each grain is written at the
+// input rate while the previous one is read back at `pitch` times that rate,
+// from two taps crossfaded across the middle half of the grain. Plain C++ so it
+// can be tested on the host.
+//
+// Works on blocks: the grain size is a power of two so positions wrap with a
+// mask, the crossfade weights come from a table built at compile time, and a
+// block is split only where a grain ends, so the inner loop has no branches.
+//
+// The firmware no longer uses it: speech goes through WsolaPitchShift. It lives
+// here, outside src/, as the reference test/wsola_test.cpp measures WSOLA
+// against, and test/pitch_shift_test.cpp keeps its block-vs-per-sample checks.
+
+constexpr size_t PITCH_GRAIN_SAMPLES = 1024;
+static_assert((PITCH_GRAIN_SAMPLES & (PITCH_GRAIN_SAMPLES - 1)) == 0, "grain size must be a power of two");
+
+class GrainPitchShift {
+public:
+  // `pitch` as a frequency factor, e.g. 1.5; resolution 1/256.
+  void begin(float pitch);
+
+  // Forget both grains.
+  void reset();
+
+  // `in` and `out` may be the same buffer.
+  void process(const int16_t *in, int16_t *out, size_t count);
+
+protected:
+  int16_t grains[2][PITCH_GRAIN_SAMPLES] = {};
+  uint8_t writing = 0;              // grain being written; the other one is read
+  uint32_t write_pos = 0;
+  uint32_t pitch_mul = 256;         // Q8
+  uint32_t secondary_offset = 0;    // second read tap, behind the first
+};
+
+#endif
@@ -0,0 +1,23 @@
+// CHECK() and the pass/fail summary shared by the host tests in test/.
+// Included as "host/TestCheck.h", so no extra -I is needed.
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <stdio.h>
+
+static int failures = 0;
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);        \
+      failures++;                                                     \
+    }                                                                 \
+  } while (0)
+
+// Prints the summary line; main() returns this as the exit code.
+static inline int testResult() {
+  printf("%s (%d failures)\n", failures ? "FAILED" : "OK", failures);
+  return failures ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,245 @@
+/**
+ * @file jitter_buffer_test.cpp
+ * @brief Host-side replay of packet timing traces through JitterBuffer.
+ *
+ * Build and run on the host (no board needed):
+ *   g++ -std=gnu++17 -O2 -Isrc test/jitter_buffer_test.cpp src/JitterBuffer.cpp -o jb_test && ./jb_test
+ *
+ * Extra traces can be replayed by passing files with one "seq,arrival_ms" pair per
+ * line, e.g. the seq= and t= fields of the "[WSc] binary frame received" serial log.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "JitterBuffer.h"
+#include "host/TestCheck.h"
+
+struct Arrival {
+  uint16_t seq;
+  uint32_t ms;
+};
+
+struct ReplayResult {
+  uint32_t played = 0;
+  uint32_t concealed = 0;
+  uint32_t silent_ticks = 0;
+  uint32_t peak_target = 0;
+  uint32_t final_target = 0;
+  uint32_t first_play_ms = 0;
+  JitterBufferStats stats;
+};
+
+// Replays arrivals against a playout clock that consumes one packet every
+// `packet_ms`. A full buffer holds the sender back, like TCP backpressure does.
+static ReplayResult replay(const std::vector<Arrival> &trace, uint16_t packet_ms, JitterBufferConfig cfg) {
+  JitterBuffer jb;
+  jb.begin(cfg);
+  ReplayResult r;
+
+  uint8_t packet[8] = {0};
+  uint8_t out[400];
+  size_t next = 0;
+  bool playing = false;
+  uint32_t start = trace.empty() ? 0 : trace[0].ms;
+  uint32_t next_tick = start;
+  uint32_t end = trace.empty() ? 0 : trace.back().ms + 5000;
+
+  for (uint32_t now = start; now <= end; now++) {
+    while (next < trace.size() && trace[next].ms <= now) {
+      memcpy(packet, &trace[next].seq, sizeof(uint16_t));
+      if (!jb.push(trace[next].seq, packet, sizeof(packet), packet_ms, now) && jb.isFull()) {
+        break;  // sender blocked until the consumer frees a slot
+      }
+      next++;
+    }
+
+    if (now == next_tick) {
+      next_tick += packet_ms;
+      size_t len = 0;
+      uint16_t seq = 0;
+      JitterBuffer::PopResult res = jb.pop(now, out, sizeof(out), len, seq);
+      if (res == JitterBuffer::POP_PACKET) {
+        if (!playing) {
+          r.first_play_ms = now - start;
+        }
+        playing = true;
+        r.played++;
+      } else if (res == JitterBuffer::POP_MISSING) {
+        r.concealed++;
+      } else if (playing && next < trace.size()) {
+        r.silent_ticks++;
+      }
+    }
+    if (jb.targetDepthMs() > r.peak_target) {
+      r.peak_target = jb.targetDepthMs();
+    }
+  }
+  r.final_target = jb.targetDepthMs();
+  r.stats = jb.stats();
+  return r;
+}
+
+static void printResult(const char *name, const ReplayResult &r) {
+  printf("%-20s played=%u concealed=%u silent=%u underruns=%u late=%u jitter=%ums "
+         "target(peak/final)=%u/%ums max_depth=%ums first_play=%ums\n",
+         name, r.played, r.concealed, r.silent_ticks, r.stats.underruns, r.stats.late_packets,
+         r.stats.jitter_ms, r.peak_target, r.final_target, r.stats.max_depth_seen_ms, r.first_play_ms);
+}
+
+// --- traces -----------------------------------------------------------------
+// 20 ms packets. Small deterministic PRNG so the traces are reproducible.
+
+static uint32_t rng = 12345;
+static uint32_t nextRand(uint32_t mod) {
+  rng = rng * 1103515245u + 12345u;
+  return (rng >> 16) % mod;
+}
+
+static std::vector<Arrival> steadyTrace() {
+  std::vector<Arrival> t;
+  for (uint16_t i = 0; i < 500; i++) {
+    t.push_back({i, 1000u + i * 20u + nextRand(3)});
+  }
+  return t;
+}
+
+// Home Wi-Fi under load: mostly on time, with 150-250 ms stalls followed by bursts.
+static std::vector<Arrival> congestedTrace() {
+  std::vector<Arrival> t;
+  uint32_t stall_until = 0;
+  for (uint16_t i = 0; i < 1500; i++) {
+    uint32_t nominal = 1000u + i * 20u;
+    if (i > 100 && i < 700 && i % 90 == 0) {
+      stall_until = nominal + 150 + nextRand(100);
+    }
+    uint32_t arrival = nominal + nextRand(8);
+    if (arrival < stall_until) {
+      arrival = stall_until + nextRand(3);
+    }
+    t.push_back({i, arrival});
+  }
+  return t;
+}
+
+// Realtime API relays audio faster than real time, in bursts.
+static std::vector<Arrival> burstyFastTrace() {
+  std::vector<Arrival> t;
+  uint32_t now = 1000;
+  for (uint16_t i = 0; i < 400; i++) {
+    if (i % 25 == 0) {
+      now += 180;
+    }
+    now += 1;
+    t.push_back({i, now});
+  }
+  return t;
+}
+
+// Loss, reordering and a duplicate.
+static std::vector<Arrival> lossyTrace() {
+  std::vector<Arrival> t;
+  for (uint16_t i = 0; i < 300; i++) {
+    if (i == 50 || i == 51 || i == 120 || i == 200) {
+      continue;  // lost
+    }
+    t.push_back({i, 1000u + i * 20u + nextRand(5)});
+  }
+  std::swap(t[80], t[81]);   // reordered pair
+  t.push_back({150, 1000u + 150 * 20u + 400});  // duplicate, long after playout
+  return t;
+}
+
+static std::vector<Arrival> loadTrace(const char *path) {
+  std::vector<Arrival> t;
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    printf("cannot open %s\n", path);
+    return t;
+  }
+  unsigned seq, ms;
+  while (fscanf(f, "%u,%u", &seq, &ms) == 2) {
+    t.push_back({(uint16_t)seq, ms});
+  }
+  fclose(f);
+  return t;
+}
+
+int main(int argc, char **argv) {
+  JitterBufferConfig cfg;
+  cfg.capacity = 16;
+  cfg.min_depth_ms = 40;
+  cfg.max_depth_ms = 320;
+
+  if (argc > 1) {
+    for (int i = 1; i < argc; i++) {
+      printResult(argv[i], replay(loadTrace(argv[i]), 20, cfg));
+    }
+    return 0;
+  }
+
+  ReplayResult steady = replay(steadyTrace(), 20, cfg);
+  printResult("steady", steady);
+  CHECK(steady.played == 500);
+  CHECK(steady.stats.underruns == 0);
+  CHECK(steady.peak_target <= 60);
+
+  ReplayResult congested = replay(congestedTrace(), 20, cfg);
+  printResult("congested", congested);
+  CHECK(congested.played + congested.concealed >= 1500);
+  CHECK(congested.peak_target > cfg.min_depth_ms);
+  CHECK(congested.peak_target <= cfg.max_depth_ms);
+  CHECK(congested.final_target < congested.peak_target);  // shrinks once the stalls stop
+  CHECK(congested.stats.underruns <= 2);                   // adapts after the first stalls
+
+  // Same trace with a fixed minimal target shows what adaptation buys.
+  JitterBufferConfig fixed = cfg;
+  fixed.max_depth_ms = fixed.min_depth_ms;
+  ReplayResult congested_fixed = replay(congestedTrace(), 20, fixed);
+  printResult("congested(fixed)", congested_fixed);
+  CHECK(congested.stats.underruns < congested_fixed.stats.underruns);
+
+  ReplayResult bursty = replay(burstyFastTrace(), 20, cfg);
+  printResult("bursty-fast", bursty);
+  CHECK(bursty.played == 400);
+  CHECK(bursty.stats.overflow_drops == 0);
+  CHECK(bursty.final_target <= 60);  // early arrivals must not inflate the target
+
+  ReplayResult lossy = replay(lossyTrace(), 20, cfg);
+  printResult("lossy", lossy);
+  CHECK(lossy.played == 296);
+  CHECK(lossy.concealed == 4);
+  CHECK(lossy.stats.late_packets == 1);
+
+  // A prebuffer delays the start and holds off underruns on the congested trace
+  JitterBufferConfig prebuffered = cfg;
+  prebuffered.prebuffer_ms = 200;
+  ReplayResult steady_pre = replay(steadyTrace(), 20, prebuffered);
+  printResult("steady(prebuf 200)", steady_pre);
+  CHECK(steady_pre.first_play_ms >= 180);  // 10 x 20 ms buffered when packet #10 arrives
+  CHECK(steady_pre.first_play_ms > steady.first_play_ms);
+  CHECK(steady_pre.played == 500);
+  ReplayResult congested_pre = replay(congestedTrace(), 20, prebuffered);
+  printResult("congested(prebuf)", congested_pre);
+  CHECK(congested_pre.stats.underruns <= congested.stats.underruns);
+
+  // begin() sanity and dropOldest bookkeeping
+  JitterBuffer jb;
+  JitterBufferConfig small;
+  small.capacity = 2;
+  CHECK(jb.begin(small));
+  uint8_t p[4] = {1, 2, 3, 4};
+  CHECK(jb.push(10, p, 4, 20, 0));
+  CHECK(jb.push(11, p, 4, 20, 0));
+  CHECK(!jb.push(12, p, 4, 20, 0));
+  CHECK(jb.dropOldest());
+  CHECK(jb.push(12, p, 4, 20, 0));
+  uint8_t out[4];
+  size_t len;
+  uint16_t seq;
+  CHECK(jb.peek(12, out, sizeof(out), len) && len == 4 && jb.packetCount() == 2);  // FEC lookahead
+  CHECK(jb.pop(100, out, sizeof(out), len, seq) == JitterBuffer::POP_PACKET && seq == 11);
+  CHECK(jb.stats().overflow_drops == 1);
+
+  return testResult();
+}
@@ -0,0 +1,195 @@
+/**
+ * @file mic_frame_reader_test.cpp
+ * @brief Host tests for MicFrameReader and the message count and wire size of the mic uplink.
+ *
+ * Build and run on the host (no board needed):
+ *   g++ -std=gnu++17 -O2 -Isrc test/mic_frame_reader_test.cpp src/MicFrameReader.cpp src/SpscRing.cpp -o mic_frame_test && ./mic_frame_test
+ *
+ * micTask commits 10 ms reads into the ring while networkTask comes round every
+ * millisecond. The table compares, over 10 s of 16 kHz PCM and of 24 kbps Opus,
+ * the old uplink (64-byte copies, then whatever was committed per pass) with
+ * one message per 10, 20 or 40 ms frame: messages per second, payload and
+ * estimated wire rate (WebSocket, TLS and TCP/IP headers per message) and the
+ * framing share. On the board, the mic send time shows up as
+ * mic_uplink.send_time_avg_us and the whole wsMutex hold per networkTask pass
+ * as network_loop.ws_hold_avg_us in the telemetry.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "MicFrameReader.h"
+#include "host/TestCheck.h"
+
+constexpr size_t RING_BYTES = 16384;  // MIC_RING_BYTES
+constexpr size_t READ_BYTES = 320;    // MIC_READ_BYTES, 10 ms at 16 kHz
+constexpr size_t BYTES_PER_MS = 32;   // 16 kHz, 16-bit mono
+constexpr int SECONDS = 10;
+
+struct Uplink {
+  size_t messages = 0;
+  size_t payload = 0;
+  size_t wire = 0;
+
+  void send(size_t len) {
+    messages++;
+    payload += len;
+    wire += wsUplinkWireBytes(len, true);
+  }
+};
+
+static void report(const char *name, const Uplink &u) {
+  printf("%-32s %7.1f %9.1f %9.1f %9.1f%%\n", name, (double)u.messages / SECONDS, u.payload * 8.0 / SECONDS / 1000,
+         u.wire * 8.0 / SECONDS / 1000, 100.0 * (u.wire - u.payload) / u.wire);
+}
+
+// PCM through the ring: a 10 ms read every 10 ticks, networkTask every tick
+static Uplink pcmUplink(size_t frame_ms, size_t legacy_max) {
+  SpscRing ring;
+  ring.begin(RING_BYTES);
+  MicFrameReader reader;
+  reader.begin(&ring, 40 * BYTES_PER_MS);
+  reader.setFrameBytes(frame_ms * BYTES_PER_MS);
+  uint8_t block[READ_BYTES] = {};
+  Uplink u;
+  for (int ms = 0; ms < SECONDS * 1000; ms++) {
+    if (ms % 10 == 9) {
+      ring.write(block, sizeof(block));
+    }
+    if (legacy_max) {
+      size_t len;
+      while (ring.peek(len), len > 0) {
+        len = len < legacy_max ? len : legacy_max;
+        ring.consume(len);
+        u.send(len);
+      }
+    } else {
+      while (reader.peekFrame()) {
+        u.send(reader.frameBytes());
+        reader.consumeFrame();
+      }
+    }
+  }
+  return u;
+}
+
+static Uplink opusUplink(size_t frame_ms, uint32_t bitrate) {
+  Uplink u;
+  for (size_t ms = 0; ms < SECONDS * 1000; ms += frame_ms) {
+    u.send(bitrate / 8 * frame_ms / 1000);
+  }
+  return u;
+}
+
+int main() {
+  // frames come out whole and in order across the wrap point, whatever the read sizes
+  {
+    SpscRing ring;
+    ring.begin(RING_BYTES);
+    MicFrameReader reader;
+    CHECK(reader.begin(&ring, 1280));
+    reader.setFrameBytes(640);
+    uint8_t in[700];
+    uint8_t next_in = 0, next_out = 0;
+    size_t frames = 0;
+    bool ordered = true, whole = true;
+    for (int round = 0; round < 2000; round++) {
+      size_t n = 2 * (1 + (round * 37) % 350);
+      for (size_t i = 0; i < n; i++) {
+        in[i] = next_in++;
+      }
+      CHECK(ring.write(in, n) == n);
+      const uint8_t *frame;
+      while ((frame = reader.peekFrame()) != nullptr) {
+        CHECK(reader.peekFrame() == frame);  // held until consumed
+        for (size_t i = 0; i < reader.frameBytes(); i++) {
+          ordered &= frame[i] == next_out++;
+        }
+        reader.consumeFrame();
+        frames++;
+      }
+      whole &= ring.available() < reader.frameBytes();
+    }
+    CHECK(ordered);
+    CHECK(whole);
+    CHECK(frames > 1000);
+    CHECK(reader.copiedFrames() > 0);
+  }
+
+  // a partial frame waits; the size changes only between frames
+  {
+    SpscRing ring;
+    ring.begin(RING_BYTES);
+    MicFrameReader reader;
+    reader.begin(&ring, 1280);
+    reader.setFrameBytes(640);
+    uint8_t block[READ_BYTES] = {};
+    ring.write(block, sizeof(block));
+    CHECK(reader.peekFrame() == nullptr);
+    ring.write(block, sizeof(block));
+    CHECK(reader.peekFrame() != nullptr);
+    reader.setFrameBytes(320);
+    CHECK(reader.frameBytes() == 640);
+    reader.consumeFrame();
+    CHECK(ring.available() == 0);
+    reader.setFrameBytes(4096);
+    CHECK(reader.frameBytes() == 1280);
+
+    // reset() after a clear() drops the held frame without consuming again
+    ring.write(block, sizeof(block));
+    reader.setFrameBytes(320);
+    CHECK(reader.peekFrame() != nullptr);
+    ring.clear();
+    reader.reset();
+    CHECK(reader.peekFrame() == nullptr);
+    CHECK(ring.available() == 0);
+  }
+
+  // the framing size estimate
+  CHECK(wsUplinkWireBytes(64, false) == 64 + 6 + 40);
+  CHECK(wsUplinkWireBytes(640, true) == 640 + 8 + 29 + 40);
+
+  printf("uplink, 10 s                      msgs/s  payload kbps  wire kbps  framing\n");
+  Uplink copies = pcmUplink(0, 64);
+  Uplink committed = pcmUplink(0, 2048);
+  Uplink framed10 = pcmUplink(10, 0), framed20 = pcmUplink(20, 0), framed40 = pcmUplink(40, 0);
+  report("pcm, 64-byte copies (before)", copies);
+  report("pcm, per pass up to 2048 bytes", committed);
+  report("pcm, 10 ms frames", framed10);
+  report("pcm, 20 ms frames", framed20);
+  report("pcm, 40 ms frames", framed40);
+  Uplink opus10 = opusUplink(10, 24000), opus20 = opusUplink(20, 24000), opus40 = opusUplink(40, 24000);
+  report("opus 24 kbps, 10 ms frames", opus10);
+  report("opus 24 kbps, 20 ms frames", opus20);
+  report("opus 24 kbps, 40 ms frames", opus40);
+  CHECK(copies.messages == (size_t)SECONDS * 500);
+  CHECK(framed20.messages == (size_t)SECONDS * 50);
+  CHECK(framed20.payload == copies.payload);
+  CHECK(framed20.wire < copies.wire && framed40.wire < framed20.wire);
+
+  // benchmark: handing out a frame and releasing it, in place and across the wrap point
+  {
+    SpscRing ring;
+    ring.begin(RING_BYTES);
+    MicFrameReader reader;
+    reader.begin(&ring, 1280);
+    reader.setFrameBytes(640);
+    std::vector<uint8_t> block(640);
+    const int rounds = 1000000;
+    size_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+      ring.write(block.data(), block.size() - (r % 7 == 0 ? 2 : 0));
+      const uint8_t *frame;
+      while ((frame = reader.peekFrame()) != nullptr) {
+        sum += frame[0];
+        reader.consumeFrame();
+      }
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("write + frame hand-out: %.1f ns per 20 ms frame, %u of them copied (%zu)\n", ns / rounds,
+           (unsigned)reader.copiedFrames(), sum);
+  }
+
+  return testResult();
+}
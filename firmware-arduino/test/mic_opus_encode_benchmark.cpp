@@ -0,0 +1,81 @@
+/**
+ * @file mic_opus_encode_benchmark.cpp
+ * @brief On-board cost and stack use of the mic uplink's Opus encoding.
+ *
+ * Encodes 4 s of a voiced test signal at 16 kHz in 20 ms frames, as
+ * micEncodeTask does, for a grid of bitrates and complexities, and prints the
+ * cycles per frame, the share of a 240 MHz core, the bitrate on the wire and
+ * the latency from the first sample of a frame to its packet. The encoder runs
+ * in its own task with MIC_ENCODER_STACK_BYTES of stack; the high-water mark
+ * printed at the end is the headroom left after the most expensive setting,
+ * which is what MIC_ENCODER_STACK_BYTES should be sized from.
+ *
+ * Flash as a sketch (copy src/OpusFrameEncoder.* next to it) and read the
+ * serial output. test/mic_opus_encode_test.cpp runs the same grid on the host.
+ */
+#include "AudioTools.h"
+#include "OpusFrameEncoder.h"
+
+constexpr uint32_t SAMPLE_RATE = 16000;                // MIC_SAMPLE_RATE
+constexpr int FRAME_MS = 20;                           // MIC_FRAME_MS
+constexpr size_t FRAME_SAMPLES = SAMPLE_RATE * FRAME_MS / 1000;
+constexpr size_t MAX_PACKET = 800;                     // MIC_OPUS_MAX_PACKET
+constexpr uint32_t STACK_BYTES = 32768;                // MIC_ENCODER_STACK_BYTES
+constexpr size_t FRAMES = 200;                         // 4 s of speech
+
+static int16_t pcm[FRAME_SAMPLES];
+static uint8_t packet[MAX_PACKET];
+static OpusFrameEncoder encoder;
+
+// a 140 Hz buzz with a few formant-like harmonics and a 4 Hz syllable envelope
+static void makeSpeech(int16_t *out, size_t offset) {
+  for (size_t i = 0; i < FRAME_SAMPLES; i++) {
+    float t = (float)(offset + i) / SAMPLE_RATE;
+    float env = 0.5f + 0.5f * sinf(2 * PI * 4 * t);
+    float v = sinf(2 * PI * 140 * t) + 0.5f * sinf(2 * PI * 700 * t) + 0.3f * sinf(2 * PI * 1200 * t);
+    out[i] = (int16_t)(6000 * env * v);
+  }
+}
+
+static void benchTask(void *) {
+  Serial.println("bitrate  complexity  us/frame  max us  %core  kbps  latency ms");
+  for (uint32_t bitrate : {16000u, 24000u, 32000u}) {
+    for (int complexity : {0, 2, 5, 8, 10}) {
+      if (!encoder.begin(SAMPLE_RATE, FRAME_MS, bitrate, complexity)) {
+        Serial.println("encoder begin failed");
+        continue;
+      }
+      uint64_t cycles = 0;
+      uint32_t worst = 0;
+      size_t bytes = 0;
+      for (size_t f = 0; f < FRAMES; f++) {
+        makeSpeech(pcm, f * FRAME_SAMPLES);
+        uint32_t start = ESP.getCycleCount();
+        bytes += encoder.encode(pcm, packet, sizeof(packet));
+        uint32_t spent = ESP.getCycleCount() - start;
+        cycles += spent;
+        worst = spent > worst ? spent : worst;
+      }
+      float mhz = ESP.getCpuFreqMHz();
+      float us = cycles / mhz / FRAMES;
+      float kbps = bytes * 8.0f / (FRAMES * FRAME_MS);
+      float latency = FRAME_MS + encoder.lookaheadSamples() * 1000.0f / SAMPLE_RATE + us / 1000;
+      Serial.printf("%7u  %10d  %8.0f  %6.0f  %5.1f  %4.1f  %10.1f\n", (unsigned)bitrate, complexity, us,
+                    worst / mhz, us / (FRAME_MS * 10.0f), kbps, latency);
+      encoder.end();
+    }
+  }
+  Serial.printf("stack: %u of %u bytes never used\n", (unsigned)uxTaskGetStackHighWaterMark(nullptr),
+                (unsigned)STACK_BYTES);
+  vTaskDelete(nullptr);
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(2000);
+  xTaskCreatePinnedToCore(benchTask, "opusBench", STACK_BYTES, nullptr, 1, nullptr, 1);
+}
+
+void loop() {
+  delay(1000);
+}
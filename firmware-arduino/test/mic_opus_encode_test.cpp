@@ -0,0 +1,96 @@
+/**
+ * @file mic_opus_encode_test.cpp
+ * @brief Host cost, size and latency of the mic uplink's Opus encoding.
+ *
+ * Needs libopus (e.g. libopus-dev). Build and run on the host:
+ *   g++ -std=gnu++17 -O2 -Isrc test/mic_opus_encode_test.cpp src/OpusFrameEncoder.cpp $(pkg-config --cflags --libs opus) -o mic_opus_test && ./mic_opus_test
+ *
+ * Encodes 10 s of a voiced test signal at 16 kHz in 20 ms VOIP frames for a
+ * grid of bitrates and complexities, as micEncodeTask does, and prints the encode
+ * time per frame, the share of real time, the bitrate on the wire and the
+ * latency from the first sample of a frame to its packet (frame + encoder
+ * look-ahead + encode). Every stream is decoded again to check that it carries
+ * the signal. test/mic_opus_encode_benchmark.cpp measures the same on the board;
+ * the "mic_uplink" telemetry reports encode_avg_us and latency_avg_us live.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include "OpusFrameEncoder.h"
+#include "host/TestCheck.h"
+
+constexpr uint32_t RATE = 16000;           // MIC_SAMPLE_RATE
+constexpr int FRAME_MS = 20;               // MIC_FRAME_MS
+constexpr size_t FRAME = RATE * FRAME_MS / 1000;
+constexpr size_t MAX_PACKET = 800;         // MIC_OPUS_MAX_PACKET
+constexpr size_t FRAMES = 500;             // 10 s
+
+// a 140 Hz buzz with a few formant-like harmonics and a 4 Hz syllable envelope
+static std::vector<int16_t> speech() {
+  std::vector<int16_t> out(FRAME * FRAMES);
+  for (size_t i = 0; i < out.size(); i++) {
+    double t = (double)i / RATE;
+    double env = 0.5 + 0.5 * sin(2 * M_PI * 4 * t);
+    double v = sin(2 * M_PI * 140 * t) + 0.5 * sin(2 * M_PI * 700 * t) + 0.3 * sin(2 * M_PI * 1200 * t);
+    out[i] = (int16_t)(6000 * env * v);
+  }
+  return out;
+}
+
+static double rms(const int16_t *x, size_t n) {
+  double sum = 0;
+  for (size_t i = 0; i < n; i++) {
+    sum += (double)x[i] * x[i];
+  }
+  return sqrt(sum / n);
+}
+
+int main() {
+  std::vector<int16_t> pcm = speech();
+  std::vector<uint8_t> packet(MAX_PACKET);
+  std::vector<int16_t> decoded(FRAME);
+  printf("PCM uplink: %u kbps\n", (unsigned)(RATE * 16 / 1000));
+  printf("bitrate  complexity  us/frame  %%realtime  kbps  max bytes  latency ms  decoded/input rms\n");
+
+  for (uint32_t bitrate : {16000u, 24000u, 32000u}) {
+    for (int complexity : {0, 2, 5, 8, 10}) {
+      OpusFrameEncoder enc;
+      CHECK(enc.begin(RATE, FRAME_MS, bitrate, complexity));
+      int err = 0;
+      OpusDecoder *dec = opus_decoder_create(RATE, 1, &err);
+      size_t bytes = 0, largest = 0;
+      double in_energy = 0, out_energy = 0;
+      double worst_us = 0;
+      double total_us = 0;
+      for (size_t f = 0; f < FRAMES; f++) {
+        auto t0 = std::chrono::steady_clock::now();
+        size_t len = enc.encode(pcm.data() + f * FRAME, packet.data(), packet.size());
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        total_us += us;
+        worst_us = us > worst_us ? us : worst_us;
+        CHECK(len > 0 && len <= MAX_PACKET);
+        bytes += len;
+        largest = len > largest ? len : largest;
+        // skip the first second while the encoder settles
+        int n = opus_decode(dec, packet.data(), (opus_int32)len, decoded.data(), (int)FRAME, 0);
+        if (f >= 50 && n == (int)FRAME) {
+          in_energy += rms(pcm.data() + f * FRAME, FRAME);
+          out_energy += rms(decoded.data(), FRAME);
+        }
+      }
+      opus_decoder_destroy(dec);
+      double per_frame = total_us / FRAMES;
+      double kbps = bytes * 8.0 / (FRAMES * FRAME_MS);
+      double latency_ms = FRAME_MS + enc.lookaheadSamples() * 1000.0 / RATE + per_frame / 1000;
+      double ratio = out_energy / in_energy;
+      printf("%7u  %10d  %8.1f  %9.2f  %4.1f  %9zu  %10.1f  %17.2f\n", (unsigned)bitrate, complexity, per_frame,
+             per_frame / (FRAME_MS * 10.0), kbps, largest, latency_ms, ratio);
+      CHECK(kbps < bitrate / 1000.0 * 1.3);
+      CHECK(ratio > 0.7 && ratio < 1.3);
+      CHECK(enc.encodedFrames() == FRAMES && enc.errors() == 0);
+    }
+  }
+
+  return testResult();
+}
@@ -0,0 +1,135 @@
+/**
+ * @file opus_packet_overhead_benchmark.cpp
+ * @brief Per-message cost of the speech downlink for 20, 40 and 60 ms Opus packets.
+ *
+ * Encodes 6 s of a voiced test signal in 20 ms frames, then merges 2 or 3 of
+ * them into multi-frame packets with the Opus repacketizer, as the server does
+ * for a longer frame_ms. Every packet then takes the device's receive path:
+ * opus_packet_get_nb_samples(), a mutex-guarded JitterBuffer push and pop, and
+ * one opus_decode() call. Prints messages per second, the bookkeeping cost per
+ * message and per second of speech, and the decode cost per second of speech.
+ *
+ * TLS records and WebSocket framing need the server; on a real session they
+ * show up in the "downlink" telemetry (dispatch_avg_us, msgs_per_s). Flash as a
+ * sketch (copy src/JitterBuffer.* and src/OpusFrameDecoder.* next to it) and
+ * read the serial output.
+ */
+#include "AudioTools.h"
+#include "opus.h"
+#include "JitterBuffer.h"
+#include "OpusFrameDecoder.h"
+
+constexpr uint32_t SAMPLE_RATE = 24000;
+constexpr size_t FRAME_SAMPLES = SAMPLE_RATE / 50;  // 20 ms
+constexpr size_t FRAMES = 300;                      // 6 s of speech
+constexpr size_t MAX_PACKET_BYTES = 512;
+constexpr size_t MAX_PACKET_SAMPLES = FRAME_SAMPLES * 3;
+
+static uint8_t frames[FRAMES][MAX_PACKET_BYTES];
+static opus_int32 frameLen[FRAMES];
+static uint8_t packets[FRAMES][MAX_PACKET_BYTES];
+static opus_int32 packetLen[FRAMES];
+static uint8_t popped[MAX_PACKET_BYTES];
+static int16_t pcm[MAX_PACKET_SAMPLES];
+
+static JitterBuffer jitter;
+static OpusFrameDecoder decoder;
+static SemaphoreHandle_t mutex;
+
+// a 140 Hz buzz with a few formant-like harmonics and a 4 Hz syllable envelope
+static void makeSpeech(int16_t *out, size_t offset) {
+  for (size_t i = 0; i < FRAME_SAMPLES; i++) {
+    float t = (float)(offset + i) / SAMPLE_RATE;
+    float env = 0.5f + 0.5f * sinf(2 * PI * 4 * t);
+    float v = sinf(2 * PI * 140 * t) + 0.5f * sinf(2 * PI * 700 * t) + 0.3f * sinf(2 * PI * 1200 * t);
+    out[i] = (int16_t)(6000 * env * v);
+  }
+}
+
+static void encodeFrames() {
+  int err = 0;
+  OpusEncoder *enc = opus_encoder_create(SAMPLE_RATE, 1, OPUS_APPLICATION_VOIP, &err);
+  opus_encoder_ctl(enc, OPUS_SET_BITRATE(24000));
+  int16_t in[FRAME_SAMPLES];
+  for (size_t f = 0; f < FRAMES; f++) {
+    makeSpeech(in, f * FRAME_SAMPLES);
+    frameLen[f] = opus_encode(enc, in, FRAME_SAMPLES, frames[f], MAX_PACKET_BYTES);
+  }
+  opus_encoder_destroy(enc);
+}
+
+// merges `per` consecutive 20 ms frames into each packet, returns the packet count
+static size_t buildPackets(int per) {
+  OpusRepacketizer *rp = opus_repacketizer_create();
+  size_t count = 0;
+  for (size_t f = 0; f + per <= FRAMES; f += per) {
+    opus_repacketizer_init(rp);
+    for (int k = 0; k < per; k++) {
+      opus_repacketizer_cat(rp, frames[f + k], frameLen[f + k]);
+    }
+    packetLen[count] = opus_repacketizer_out(rp, packets[count], MAX_PACKET_BYTES);
+    count++;
+  }
+  opus_repacketizer_destroy(rp);
+  return count;
+}
+
+struct Result {
+  float overhead_us;   // per message, everything but the decode
+  float decode_us;     // per message
+};
+
+static Result run(size_t count) {
+  JitterBufferConfig cfg;
+  cfg.max_packet_bytes = MAX_PACKET_BYTES;
+  jitter.begin(cfg);
+  jitter.setPrebufferMs(0);
+  decoder.begin(SAMPLE_RATE, 1);
+
+  uint32_t overhead = 0;
+  uint32_t decode = 0;
+  uint32_t now = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint32_t start = ESP.getCycleCount();
+    int samples = opus_packet_get_nb_samples(packets[i], packetLen[i], SAMPLE_RATE);
+    uint16_t ms = (uint16_t)(samples * 1000 / SAMPLE_RATE);
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    jitter.push((uint16_t)i, packets[i], packetLen[i], ms, now);
+    xSemaphoreGive(mutex);
+
+    size_t len = 0;
+    uint16_t seq = 0;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    JitterBuffer::PopResult res = jitter.pop(now, popped, sizeof(popped), len, seq);
+    xSemaphoreGive(mutex);
+    uint32_t mid = ESP.getCycleCount();
+    if (res == JitterBuffer::POP_PACKET) {
+      decoder.decode(popped, len, pcm, MAX_PACKET_SAMPLES);
+    }
+    decode += ESP.getCycleCount() - mid;
+    overhead += mid - start;
+    now += ms;
+  }
+  float mhz = ESP.getCpuFreqMHz();
+  return {overhead / mhz / count, decode / mhz / count};
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(2000);
+  mutex = xSemaphoreCreateMutex();
+  encodeFrames();
+
+  Serial.println("packet  msgs/s  overhead us/msg  overhead us/s  decode us/msg  decode ms/s");
+  for (int per : {1, 2, 3}) {
+    size_t count = buildPackets(per);
+    Result r = run(count);
+    float perSecond = 1000.0f / (20 * per);
+    Serial.printf("%3d ms  %6.1f  %15.1f  %13.1f  %13.1f  %11.2f\n", 20 * per, perSecond, r.overhead_us,
+                  r.overhead_us * perSecond, r.decode_us, r.decode_us * perSecond / 1000);
+  }
+}
+
+void loop() {
+  delay(1000);
+}
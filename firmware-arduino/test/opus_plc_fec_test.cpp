@@ -0,0 +1,211 @@
+/**
+ * @file opus_plc_fec_test.cpp
+ * @brief Host test of how the speech playout fills sequence gaps with FEC or PLC.
+ *
+ * Build and run on the host (no board needed):
+ *   g++ -std=gnu++17 -O2 -Isrc -Itest/host test/opus_plc_fec_test.cpp src/JitterBuffer.cpp -o plc_test && ./plc_test
+ * With libopus (e.g. libopus-dev) the same playout also runs the real decoder:
+ *   g++ -std=gnu++17 -O2 -DHAVE_LIBOPUS -Isrc -Itest/host -I/usr/include/opus test/opus_plc_fec_test.cpp \
+ *       src/JitterBuffer.cpp src/OpusFrameDecoder.cpp -lopus -o plc_test && ./plc_test
+ *
+ * 20 ms packets arrive on time except for the dropped ones and go through
+ * JitterBuffer, takePlayoutSlot() and decodePlayoutSlot() exactly as in
+ * audioDecodeTask. A stand-in decoder whose packets carry their own index (and
+ * the previous one as "FEC") shows which frame filled each slot; with libopus
+ * the frames rebuilt from FEC are compared with concealment against a lossless
+ * decode. Gaps only exist when the server numbers its packets ("audio_seq");
+ * the last case shows that arrival numbering hides them.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <set>
+#include <vector>
+#include "SpeechPlayout.h"
+#include "host/TestCheck.h"
+#ifdef HAVE_LIBOPUS
+#include "OpusFrameDecoder.h"
+#endif
+
+constexpr uint32_t RATE = 24000;
+constexpr int FRAME = RATE / 50;   // 20 ms
+constexpr int PACKETS = 60;
+constexpr size_t MAX_PACKET = 400;
+constexpr int16_t CONCEALED = -1;
+
+// Packets are {index, index of the packet before}; every sample of a frame
+// holds the index it was decoded from.
+struct IndexDecoder {
+  int last = FRAME;
+  uint32_t decoded = 0, recovered = 0, concealed = 0;
+
+  int decode(const uint8_t *packet, size_t len, int16_t *pcm, int max_samples) {
+    int n = FRAME < max_samples ? FRAME : max_samples;
+    fill(pcm, len >= 2 ? packet[0] : CONCEALED, n);
+    decoded++;
+    return last = n;
+  }
+  int recover(const uint8_t *next, size_t len, int16_t *pcm, int samples) {
+    fill(pcm, len >= 2 ? next[1] : CONCEALED, samples);
+    recovered++;
+    return samples;
+  }
+  int conceal(int16_t *pcm, int samples) {
+    fill(pcm, CONCEALED, samples);
+    concealed++;
+    return samples;
+  }
+  int lastFrameSamples() const { return last; }
+
+  static void fill(int16_t *pcm, int16_t value, int n) {
+    for (int i = 0; i < n; i++) {
+      pcm[i] = value;
+    }
+  }
+};
+
+struct Stream {
+  std::vector<std::vector<uint8_t>> packets;
+};
+
+// Delivers every packet not in `lost` at 20 ms intervals, numbered by the
+// server or on arrival, and plays out one slot per 20 ms. Returns the frames.
+template <class Decoder>
+static std::vector<std::vector<int16_t>> play(Decoder &decoder, const Stream &stream, const std::set<int> &lost,
+                                              bool fec, bool server_seq = true) {
+  JitterBufferConfig cfg;
+  cfg.capacity = 32;
+  cfg.max_packet_bytes = MAX_PACKET;
+  JitterBuffer jb;
+  jb.begin(cfg);
+  uint8_t packet[MAX_PACKET], fec_packet[MAX_PACKET];
+  int16_t pcm[FRAME * 3];
+  std::vector<std::vector<int16_t>> frames;
+  uint16_t arrival_seq = 0;
+  for (uint32_t now = 0; now < (PACKETS + 20) * 20; now += 20) {
+    int i = (int)(now / 20);
+    if (i < PACKETS && !lost.count(i)) {
+      const std::vector<uint8_t> &p = stream.packets[i];
+      jb.push(server_seq ? (uint16_t)i : arrival_seq++, p.data(), p.size(), 20, now);
+    }
+    PlayoutSlot slot = takePlayoutSlot(jb, now, fec, packet, sizeof(packet), fec_packet, sizeof(fec_packet));
+    int n = decodePlayoutSlot(decoder, slot, packet, fec_packet, pcm, FRAME * 3);
+    if (n > 0) {
+      frames.emplace_back(pcm, pcm + n);
+    }
+  }
+  return frames;
+}
+
+static Stream indexStream() {
+  Stream s;
+  for (int i = 0; i < PACKETS; i++) {
+    s.packets.push_back({(uint8_t)i, (uint8_t)(i > 0 ? i - 1 : 0)});
+  }
+  return s;
+}
+
+#ifdef HAVE_LIBOPUS
+// a 140 Hz buzz with a few formant-like harmonics and a 4 Hz syllable envelope
+static Stream opusStream() {
+  int err = 0;
+  OpusEncoder *enc = opus_encoder_create(RATE, 1, OPUS_APPLICATION_VOIP, &err);
+  opus_encoder_ctl(enc, OPUS_SET_BITRATE(24000));
+  opus_encoder_ctl(enc, OPUS_SET_INBAND_FEC(1));
+  opus_encoder_ctl(enc, OPUS_SET_PACKET_LOSS_PERC(20));
+  Stream s;
+  int16_t pcm[FRAME];
+  uint8_t packet[MAX_PACKET];
+  for (int f = 0; f < PACKETS; f++) {
+    for (int i = 0; i < FRAME; i++) {
+      double t = (double)(f * FRAME + i) / RATE;
+      double env = 0.5 + 0.5 * sin(2 * M_PI * 4 * t);
+      double v = sin(2 * M_PI * 140 * t) + 0.5 * sin(2 * M_PI * 700 * t) + 0.3 * sin(2 * M_PI * 1200 * t);
+      pcm[i] = (int16_t)(6000 * env * v);
+    }
+    int len = opus_encode(enc, pcm, FRAME, packet, sizeof(packet));
+    s.packets.emplace_back(packet, packet + (len > 0 ? len : 0));
+  }
+  opus_encoder_destroy(enc);
+  return s;
+}
+
+static double snrDb(const std::vector<int16_t> &ref, const std::vector<int16_t> &x) {
+  double sig = 1, err = 1;
+  for (size_t i = 0; i < ref.size() && i < x.size(); i++) {
+    sig += (double)ref[i] * ref[i];
+    err += ((double)ref[i] - x[i]) * ((double)ref[i] - x[i]);
+  }
+  return 10 * log10(sig / err);
+}
+#endif
+
+int main() {
+  Stream stream = indexStream();
+  // one single loss, then two in a row: the first of those has no next packet to take FEC from
+  std::set<int> lost = {10, 30, 31};
+
+  // FEC rebuilds a gap whose next packet is queued; the rest is concealed
+  {
+    IndexDecoder dec;
+    std::vector<std::vector<int16_t>> frames = play(dec, stream, lost, true);
+    CHECK(frames.size() == PACKETS);
+    bool exact = true;
+    for (int i = 0; i < (int)frames.size(); i++) {
+      int16_t want = i == 30 ? CONCEALED : (int16_t)i;
+      exact &= frames[i].size() == FRAME && frames[i][0] == want && frames[i][FRAME - 1] == want;
+    }
+    CHECK(exact);
+    CHECK(dec.recovered == 2 && dec.concealed == 1 && dec.decoded == PACKETS - 3);
+    printf("fec: %u decoded, %u recovered, %u concealed of %d slots\n", dec.decoded, dec.recovered, dec.concealed,
+           PACKETS);
+  }
+
+  // without FEC every gap is concealed at the length of the last frame
+  {
+    IndexDecoder dec;
+    std::vector<std::vector<int16_t>> frames = play(dec, stream, lost, false);
+    CHECK(frames.size() == PACKETS);
+    bool exact = true;
+    for (int i = 0; i < (int)frames.size(); i++) {
+      int16_t want = lost.count(i) ? CONCEALED : (int16_t)i;
+      exact &= frames[i].size() == FRAME && frames[i][0] == want;
+    }
+    CHECK(exact);
+    CHECK(dec.recovered == 0 && dec.concealed == 3);
+  }
+
+  // numbered on arrival, a loss leaves no gap: the audio just skips
+  {
+    IndexDecoder dec;
+    std::vector<std::vector<int16_t>> frames = play(dec, stream, lost, true, false);
+    CHECK(frames.size() == PACKETS - lost.size());
+    CHECK(dec.recovered == 0 && dec.concealed == 0);
+  }
+
+#ifdef HAVE_LIBOPUS
+  {
+    Stream opus = opusStream();
+    OpusFrameDecoder lossless, withFec, withPlc;
+    lossless.begin(RATE, 1);
+    withFec.begin(RATE, 1);
+    withPlc.begin(RATE, 1);
+    std::vector<std::vector<int16_t>> ref = play(lossless, opus, {}, false);
+    std::vector<std::vector<int16_t>> fec = play(withFec, opus, lost, true);
+    std::vector<std::vector<int16_t>> plc = play(withPlc, opus, lost, false);
+    CHECK(ref.size() == PACKETS && fec.size() == PACKETS && plc.size() == PACKETS);
+    CHECK(withFec.recoveredFrames() == 2 && withPlc.concealedFrames() == 3);
+    if (ref.size() == PACKETS && fec.size() == PACKETS && plc.size() == PACKETS) {
+      for (int i : {10, 31}) {
+        double f = snrDb(ref[i], fec[i]), p = snrDb(ref[i], plc[i]);
+        printf("libopus, lost frame %d: FEC %.1f dB, PLC %.1f dB against the lossless decode\n", i, f, p);
+        CHECK(f > p);
+      }
+    }
+  }
+#else
+  printf("libopus not built in (-DHAVE_LIBOPUS), real decoder skipped\n");
+#endif
+
+  return testResult();
+}
@@ -0,0 +1,108 @@
+/**
+ * @file pcm_frame_pool_benchmark.cpp
+ * @brief Compares the old speech output chain with the PcmFramePool path.
+ *
+ * Old: decoded PCM -> BufferRTOS -> QueueStream -> StreamCopy -> VolumeStream -> sink
+ * New: decoded PCM written in place into a PcmFrame -> Q15 gain in place -> sink
+ *
+ * The sink is a NullStream so only the copies and gain are measured. Flash as a
+ * sketch (copy src/PcmFramePool.* next to it) and read the serial output.
+ */
+#include "AudioTools.h"
+#include "PcmFramePool.h"
+
+constexpr size_t FRAME_SAMPLES = 2880;   // one 120 ms Opus packet at 24 kHz
+constexpr size_t FRAMES_PER_RUN = 50;    // 6 s of speech
+constexpr uint32_t SAMPLE_RATE = 24000;
+
+AudioInfo info(SAMPLE_RATE, 1, 16);
+NullStream sink;
+int16_t decoded[FRAME_SAMPLES];          // stands in for the Opus decoder output
+
+// old chain
+BufferRTOS<uint8_t> audioBuffer(1024 * 10, 1024);
+QueueStream<uint8_t> queue(audioBuffer);
+VolumeStream volume(sink);
+StreamCopy copier(volume, queue);
+
+// new path
+PcmFramePool pool;
+
+static void fakeDecode(int16_t *out) {
+  for (size_t i = 0; i < FRAME_SAMPLES; i++) {
+    out[i] = (int16_t)((i * 37) & 0x3fff);
+  }
+}
+
+static uint32_t runOldChain() {
+  uint32_t cycles = 0;
+  for (size_t f = 0; f < FRAMES_PER_RUN; f++) {
+    fakeDecode(decoded);
+    uint32_t start = ESP.getCycleCount();
+    const uint8_t *p = (const uint8_t *)decoded;
+    size_t left = sizeof(decoded);
+    while (left > 0) {
+      size_t n = audioBuffer.writeArray(p, left);
+      p += n;
+      left -= n;
+      while (audioBuffer.available() > 0) {
+        copier.copy();
+      }
+    }
+    cycles += ESP.getCycleCount() - start;
+  }
+  return cycles;
+}
+
+static uint32_t runPool() {
+  uint32_t cycles = 0;
+  int32_t gain = 70 * 32768 / 100;
+  for (size_t f = 0; f < FRAMES_PER_RUN; f++) {
+    PcmFrame *frame = pool.acquire(0);
+    fakeDecode(frame->samples);
+    frame->count = FRAME_SAMPLES;
+    uint32_t start = ESP.getCycleCount();
+    pool.submit(frame);
+    frame = pool.receive(0);
+    for (size_t i = 0; i < frame->count; i++) {
+      int32_t v = (frame->samples[i] * gain) >> 15;
+      frame->samples[i] = v > 32767 ? 32767 : (v < -32768 ? -32768 : v);
+    }
+    sink.write((const uint8_t *)frame->samples, frame->count * sizeof(int16_t));
+    pool.release(frame);
+    cycles += ESP.getCycleCount() - start;
+  }
+  return cycles;
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(2000);
+
+  sink.begin(info);
+  audioBuffer.setReadMaxWait(0);
+  queue.begin();
+  auto vcfg = volume.defaultConfig();
+  vcfg.copyFrom(info);
+  vcfg.allow_boost = true;
+  volume.begin(vcfg);
+  volume.setVolume(0.7f);
+
+  pool.begin(4, FRAME_SAMPLES);
+}
+
+void loop() {
+  uint32_t samples = FRAMES_PER_RUN * FRAME_SAMPLES;
+  uint32_t seconds = samples / SAMPLE_RATE;
+  uint32_t oldCycles = runOldChain();
+  uint32_t poolCycles = runPool();
+
+  Serial.printf("old chain: %lu cycles/s of speech (%.2f cycles/sample)\n",
+                (unsigned long)(oldCycles / seconds), (float)oldCycles / samples);
+  Serial.printf("frame pool: %lu cycles/s of speech (%.2f cycles/sample)\n",
+                (unsigned long)(poolCycles / seconds), (float)poolCycles / samples);
+  Serial.printf("CPU at %lu MHz: old %.2f%%, pool %.2f%%\n", (unsigned long)ESP.getCpuFreqMHz(),
+                100.0f * oldCycles / seconds / (ESP.getCpuFreqMHz() * 1000000.0f),
+                100.0f * poolCycles / seconds / (ESP.getCpuFreqMHz() * 1000000.0f));
+  delay(5000);
+}
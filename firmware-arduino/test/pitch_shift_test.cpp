@@ -0,0 +1,154 @@
+/**
+ * @file pitch_shift_test.cpp
+ * @brief Host checks and before/after benchmark for the block pitch shifter.
+ *
+ * Build and run on the host (no board needed):
+ *   g++ -std=gnu++17 -O2 -Isrc test/pitch_shift_test.cpp test/host/GrainPitchShift.cpp -o pitch_test && ./pitch_test
+ *
+ * "before" is the per-sample shifter the firmware's pitch output used to have,
+ * with one virtual write per sample into the output; "after" is GrainPitchShift
+ * on 256-sample blocks with one write per block.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+#include "host/GrainPitchShift.h"
+#include "host/TestCheck.h"
+
+constexpr size_t BLOCK = 256;  // the block size the pitch output used
+
+// the previous implementation, kept as the reference
+struct LegacyPitchShift {
+  static constexpr unsigned long GRAINSIZE = 1024;
+  int16_t buf1[GRAINSIZE] = {};
+  int16_t buf2[GRAINSIZE] = {};
+  int16_t *buf = buf1;
+  int16_t *buf_ = buf2;
+  unsigned long writeAddress = 0;
+  uint32_t pitchMul = 256;
+  unsigned long secondaryOffset = 0;
+
+  void begin(float pitch) {
+    pitchMul = (uint32_t)(pitch * 256.0f + 0.5f);
+    secondaryOffset = GRAINSIZE - (((pitchMul * GRAINSIZE) >> 8) % GRAINSIZE);
+  }
+
+  int16_t pitchShift(int16_t value) {
+    buf_[writeAddress] = value;
+    int ii1 = (writeAddress * pitchMul) >> 8;
+    int output1 = buf[ii1 % GRAINSIZE];
+    int ii2 = ii1 + secondaryOffset;
+    int output2 = buf[ii2 % GRAINSIZE];
+    unsigned long f = 0;
+    if (writeAddress >= GRAINSIZE * 3 / 4) {
+      f = GRAINSIZE;
+    } else if (writeAddress >= GRAINSIZE / 4) {
+      f = (writeAddress - GRAINSIZE / 4) * 2;
+    }
+    int output = (output1 * (int)(GRAINSIZE - f) + output2 * (int)f) / (int)GRAINSIZE;
+    writeAddress++;
+    if (writeAddress >= GRAINSIZE) {
+      writeAddress = 0;
+      buf_ = buf;
+      buf = buf == buf1 ? buf2 : buf1;
+    }
+    return output;
+  }
+};
+
+// stands in for the I2S stream behind the pitch output
+struct Sink {
+  virtual ~Sink() {}
+  virtual size_t write(const uint8_t *data, size_t len) = 0;
+};
+struct CountingSink : Sink {
+  size_t calls = 0;
+  uint64_t sum = 0;
+  __attribute__((noinline)) size_t write(const uint8_t *data, size_t len) override {
+    calls++;
+    sum += data[0] + len;
+    return len;
+  }
+};
+
+static std::vector<int16_t> noise(size_t count) {
+  std::vector<int16_t> v(count);
+  for (size_t i = 0; i < count; i++) {
+    v[i] = (int16_t)((rand() % 60000) - 30000);
+  }
+  return v;
+}
+
+int main() {
+  // same output as the per-sample version, for any block split, within rounding
+  for (float pitch : {0.75f, 1.25f, 1.5f, 2.0f}) {
+    std::vector<int16_t> in = noise(24000);
+    LegacyPitchShift legacy;
+    legacy.begin(pitch);
+    GrainPitchShift shifter;
+    shifter.begin(pitch);
+    std::vector<int16_t> out(in.size());
+    for (size_t i = 0; i < in.size();) {
+      size_t n = 1 + rand() % 700;
+      n = n < in.size() - i ? n : in.size() - i;
+      shifter.process(in.data() + i, out.data() + i, n);
+      i += n;
+    }
+    int worst = 0;
+    for (size_t i = 0; i < in.size(); i++) {
+      int d = abs(out[i] - legacy.pitchShift(in[i]));
+      worst = d > worst ? d : worst;
+    }
+    CHECK(worst <= 1);
+  }
+
+  // in place matches separate buffers
+  {
+    std::vector<int16_t> in = noise(5000);
+    GrainPitchShift a, b;
+    a.begin(1.5f);
+    b.begin(1.5f);
+    std::vector<int16_t> out(in.size());
+    a.process(in.data(), out.data(), in.size());
+    b.process(in.data(), in.data(), in.size());
+    CHECK(in == out);
+  }
+
+  // benchmark, 24 kHz mono
+  {
+    const size_t total = 24000 * 20;
+    std::vector<int16_t> in = noise(total);
+    CountingSink before_sink, after_sink;
+    Sink *volatile sink = &before_sink;  // a real call, as into I2SStream
+
+    LegacyPitchShift legacy;
+    legacy.begin(1.5f);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < total; i++) {
+      int16_t v = legacy.pitchShift(in[i]);
+      sink->write((const uint8_t *)&v, sizeof(v));
+    }
+    double before_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    sink = &after_sink;
+    GrainPitchShift shifter;
+    shifter.begin(1.5f);
+    int16_t block[BLOCK];
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < total; i += BLOCK) {
+      size_t n = total - i < BLOCK ? total - i : BLOCK;
+      shifter.process(in.data() + i, block, n);
+      sink->write((const uint8_t *)block, n * sizeof(int16_t));
+    }
+    double after_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("before: %.1f Msamples/s, %zu writes\n", total / before_s / 1e6, before_sink.calls);
+    printf("after:  %.1f Msamples/s, %zu writes (%.1fx)\n", total / after_s / 1e6, after_sink.calls,
+           before_s / after_s);
+    CHECK(after_sink.calls == (total + BLOCK - 1) / BLOCK);
+  }
+
+  return testResult();
+}
@@ -0,0 +1,150 @@
+/**
+ * @file psram_ring_benchmark.cpp
+ * @brief PSRAM vs internal RAM throughput for the access patterns audio uses.
+ *
+ * Measures MB/s for bulk block copies (how TieredRingBuffer touches PSRAM),
+ * single-sample sequential reads, and cache-line strided reads on regions
+ * larger than the data cache. Then it compares streaming 10 ms blocks through
+ * a TieredRingBuffer with a plain ring read one sample at a time from PSRAM.
+ * Flash as a sketch on a board with PSRAM (copy src/TieredRingBuffer.* next to
+ * it, build with -DBOARD_HAS_PSRAM) and read the serial output.
+ */
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include "TieredRingBuffer.h"
+
+constexpr size_t REGION_BYTES = 128 * 1024;  // well above the 32 KB data cache
+constexpr size_t BLOCK_SAMPLES = 240;        // one mixer block, 10 ms at 24 kHz
+constexpr size_t COPY_BYTES = 2048;          // one hot-window refill
+constexpr int PASSES = 8;
+
+static uint8_t *psram;
+static uint8_t *dram;
+static uint8_t copyBuf[COPY_BYTES];
+static volatile uint32_t sink;
+
+static float mbPerSec(size_t bytes, uint32_t us) {
+  return us ? (float)bytes / us : 0;
+}
+
+static uint32_t bulkCopy(uint8_t *region) {
+  uint32_t start = micros();
+  for (int p = 0; p < PASSES; p++) {
+    for (size_t off = 0; off + COPY_BYTES <= REGION_BYTES; off += COPY_BYTES) {
+      memcpy(copyBuf, region + off, COPY_BYTES);
+    }
+  }
+  return micros() - start;
+}
+
+static uint32_t bulkWrite(uint8_t *region) {
+  uint32_t start = micros();
+  for (int p = 0; p < PASSES; p++) {
+    for (size_t off = 0; off + COPY_BYTES <= REGION_BYTES; off += COPY_BYTES) {
+      memcpy(region + off, copyBuf, COPY_BYTES);
+    }
+  }
+  return micros() - start;
+}
+
+static uint32_t sampleReads(uint8_t *region) {
+  const volatile int16_t *s = (const volatile int16_t *)region;
+  uint32_t acc = 0;
+  uint32_t start = micros();
+  for (int p = 0; p < PASSES; p++) {
+    for (size_t i = 0; i < REGION_BYTES / 2; i++) {
+      acc += s[i];
+    }
+  }
+  sink = acc;
+  return micros() - start;
+}
+
+// one 16-bit read per 32-byte cache line: every access misses
+static uint32_t stridedReads(uint8_t *region) {
+  const volatile int16_t *s = (const volatile int16_t *)region;
+  uint32_t acc = 0;
+  uint32_t start = micros();
+  for (int p = 0; p < PASSES * 16; p++) {
+    for (size_t i = 0; i < REGION_BYTES / 2; i += 16) {
+      acc += s[i];
+    }
+  }
+  sink = acc;
+  return micros() - start;
+}
+
+static void report(const char *name, size_t bytes, uint32_t dram_us, uint32_t psram_us) {
+  Serial.printf("%-22s DRAM %7.1f MB/s  PSRAM %7.1f MB/s  (%.1fx)\n", name, mbPerSec(bytes, dram_us),
+                mbPerSec(bytes, psram_us), psram_us ? (float)psram_us / dram_us : 0);
+}
+
+// 8 s of audio through the tiered ring: block writes in, block reads out
+static uint32_t tieredRing(TieredRingBuffer &ring, size_t total) {
+  static int16_t block[BLOCK_SAMPLES];
+  uint32_t acc = 0;
+  uint32_t start = micros();
+  for (size_t done = 0; done < total; done += BLOCK_SAMPLES) {
+    ring.write(block, BLOCK_SAMPLES);
+    ring.read(block, BLOCK_SAMPLES);
+    acc += block[0];
+  }
+  sink = acc;
+  return micros() - start;
+}
+
+// the same through a plain ring in PSRAM, one sample at a time
+static uint32_t plainRing(int16_t *store, size_t capacity, size_t total) {
+  static int16_t block[BLOCK_SAMPLES];
+  size_t head = 0, tail = 0;
+  uint32_t start = micros();
+  for (size_t done = 0; done < total; done += BLOCK_SAMPLES) {
+    for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+      store[head] = block[i];
+      head = head + 1 == capacity ? 0 : head + 1;
+    }
+    for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+      block[i] = store[tail];
+      tail = tail + 1 == capacity ? 0 : tail + 1;
+    }
+  }
+  sink = block[0];
+  return micros() - start;
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(2000);
+
+  psram = (uint8_t *)heap_caps_malloc(REGION_BYTES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  dram = (uint8_t *)heap_caps_malloc(REGION_BYTES, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  if (!psram || !dram) {
+    Serial.println("Allocation failed; is PSRAM enabled for this board?");
+    return;
+  }
+  memset(psram, 1, REGION_BYTES);
+  memset(dram, 1, REGION_BYTES);
+  Serial.printf("PSRAM free %u, internal free %u\n", (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM),
+                (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+
+  size_t bytes = REGION_BYTES * PASSES;
+  report("bulk copy out (2 KB)", bytes, bulkCopy(dram), bulkCopy(psram));
+  report("bulk copy in (2 KB)", bytes, bulkWrite(dram), bulkWrite(psram));
+  report("per-sample reads", bytes, sampleReads(dram), sampleReads(psram));
+  report("strided reads", REGION_BYTES * PASSES, stridedReads(dram), stridedReads(psram));
+
+  const size_t total = 24000 * 8;
+  TieredRingBuffer ring;
+  ring.begin(total, 1024, 8192);
+  int16_t *plain = (int16_t *)heap_caps_malloc(total * sizeof(int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  uint32_t tiered_us = tieredRing(ring, total * 4);
+  uint32_t plain_us = plainRing(plain, total, total * 4);
+  Serial.printf("8 s ring, 32 s of audio: tiered %u us (%s), plain PSRAM %u us, %.1f%% of a core at 24 kHz\n",
+                (unsigned)tiered_us, ring.inPsram() ? "PSRAM" : "DRAM", (unsigned)plain_us,
+                tiered_us / 320000.0f);
+  heap_caps_free(plain);
+}
+
+void loop() {
+  delay(1000);
+}
@@ -0,0 +1,178 @@
+/**
+ * @file resampler_test.cpp
+ * @brief Host SNR, stopband and throughput checks for Resampler presets.
+ *
+ * Build and run on the host (no board needed):
+ *   g++ -std=gnu++17 -O2 -Isrc test/resampler_test.cpp src/Resampler.cpp -o rs_test && ./rs_test
+ */
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include "Resampler.h"
+#include "host/TestCheck.h"
+
+static const char *presetName(ResampleQuality q) {
+  return q == RESAMPLE_FAST ? "fast" : q == RESAMPLE_MEDIUM ? "medium" : "high";
+}
+
+static std::vector<int16_t> sine(double freq, uint32_t rate, size_t count, double amplitude) {
+  std::vector<int16_t> v(count);
+  for (size_t i = 0; i < count; i++) {
+    v[i] = (int16_t)lrint(amplitude * sin(2 * M_PI * freq * i / rate));
+  }
+  return v;
+}
+
+// Streams `in` through the resampler in odd-sized blocks, like a network source.
+static std::vector<int16_t> run(Resampler &rs, const std::vector<int16_t> &in) {
+  std::vector<int16_t> out;
+  int16_t block[700];
+  size_t pos = 0;
+  size_t chunk = 1;
+  while (pos < in.size()) {
+    size_t n = in.size() - pos < chunk ? in.size() - pos : chunk;
+    size_t consumed = 0;
+    size_t produced = rs.process(in.data() + pos, n, consumed, block, sizeof(block) / sizeof(block[0]));
+    out.insert(out.end(), block, block + produced);
+    pos += consumed;
+    chunk = chunk * 7 % 509 + 1;
+  }
+  // drain output that did not fit into the last blocks
+  size_t consumed = 0;
+  size_t produced;
+  while ((produced = rs.process(nullptr, 0, consumed, block, sizeof(block) / sizeof(block[0]))) > 0) {
+    out.insert(out.end(), block, block + produced);
+  }
+  return out;
+}
+
+// Signal-to-(noise+distortion) against the best-fitting sine at `freq`.
+static double snrDb(const std::vector<int16_t> &y, double freq, uint32_t rate, size_t skip) {
+  double ss = 0, sc = 0, cc = 0, ys = 0, yc = 0;
+  for (size_t i = skip; i < y.size() - skip; i++) {
+    double s = sin(2 * M_PI * freq * i / rate);
+    double c = cos(2 * M_PI * freq * i / rate);
+    ss += s * s;
+    sc += s * c;
+    cc += c * c;
+    ys += y[i] * s;
+    yc += y[i] * c;
+  }
+  double det = ss * cc - sc * sc;
+  double a = (ys * cc - yc * sc) / det;
+  double b = (yc * ss - ys * sc) / det;
+  double signal = 0, noise = 0;
+  for (size_t i = skip; i < y.size() - skip; i++) {
+    double fit = a * sin(2 * M_PI * freq * i / rate) + b * cos(2 * M_PI * freq * i / rate);
+    signal += fit * fit;
+    noise += (y[i] - fit) * (y[i] - fit);
+  }
+  return 10 * log10(signal / (noise > 1e-9 ? noise : 1e-9));
+}
+
+static double rms(const std::vector<int16_t> &y, size_t skip) {
+  double sum = 0;
+  for (size_t i = skip; i < y.size() - skip; i++) {
+    sum += (double)y[i] * y[i];
+  }
+  return sqrt(sum / (y.size() - 2 * skip));
+}
+
+int main() {
+  const uint32_t out_rate = 24000;
+  const uint32_t in_rates[] = {8000, 16000, 22050, 44100, 48000};
+  const ResampleQuality qualities[] = {RESAMPLE_FAST, RESAMPLE_MEDIUM, RESAMPLE_HIGH};
+  const double min_snr[] = {30, 60, 75};
+  const double min_stop[] = {-20, -40, -60};
+
+  printf("%-7s %6s  %8s  %10s  %10s\n", "preset", "in Hz", "SNR dB", "stop dB", "ns/out");
+  for (int qi = 0; qi < 3; qi++) {
+    ResampleQuality q = qualities[qi];
+    for (uint32_t in_rate : in_rates) {
+      Resampler rs;
+      CHECK(rs.begin(in_rate, out_rate, q, 512));
+
+      // 1 kHz tone, 1 s
+      std::vector<int16_t> out = run(rs, sine(1000, in_rate, in_rate, 16000));
+      size_t expected = out_rate;
+      CHECK(out.size() <= expected + 1 && out.size() + 64 >= expected);  // minus half a filter at the end
+      double snr = snrDb(out, 1000, out_rate, 200);
+      CHECK(snr >= min_snr[qi]);
+      CHECK(fabs(rms(out, 200) - 16000 / sqrt(2.0)) < 16000 * 0.02);  // passband gain ~1
+
+      // a tone above the output Nyquist frequency must not alias back in
+      double stop_db = 0;
+      if (in_rate > out_rate) {
+        rs.reset();
+        std::vector<int16_t> alias = run(rs, sine(out_rate * 0.75, in_rate, in_rate, 16000));
+        stop_db = 20 * log10(rms(alias, 200) / (16000 / sqrt(2.0)) + 1e-9);
+        CHECK(stop_db < min_stop[qi]);
+      }
+
+      // throughput on a long block
+      rs.reset();
+      std::vector<int16_t> noise(in_rate * 2);
+      uint32_t seed = 1;
+      for (auto &s : noise) {
+        seed = seed * 1103515245u + 12345u;
+        s = (int16_t)(seed >> 16);
+      }
+      auto start = std::chrono::steady_clock::now();
+      std::vector<int16_t> bench = run(rs, noise);
+      auto end = std::chrono::steady_clock::now();
+      double ns = std::chrono::duration<double, std::nano>(end - start).count() / bench.size();
+
+      printf("%-7s %6u  %8.1f  %10.1f  %10.2f\n", presetName(q), in_rate, snr, stop_db, ns);
+    }
+  }
+
+  // equal rates pass samples through untouched
+  Resampler same;
+  CHECK(same.begin(24000, 24000, RESAMPLE_HIGH, 256));
+  std::vector<int16_t> tone = sine(440, 24000, 1000, 8000);
+  CHECK(run(same, tone) == tone);
+
+  // a rate adjustment at equal rates switches from passthrough to filtering
+  // without a gap or a click, and trims the output length by the ppm given
+  Resampler drift;
+  CHECK(drift.begin(24000, 24000, RESAMPLE_MEDIUM, 512));
+  std::vector<int16_t> before = run(drift, sine(440, 24000, 4800, 8000));
+  CHECK(before == sine(440, 24000, 4800, 8000));
+  drift.setRateAdjust(300);
+  CHECK(!drift.passthrough());
+  std::vector<int16_t> rest(240000);
+  for (size_t i = 0; i < rest.size(); i++) {
+    rest[i] = (int16_t)lrint(8000 * sin(2 * M_PI * 440 * (i + 4800) / 24000));
+  }
+  std::vector<int16_t> after = run(drift, rest);
+  double expected_after = rest.size() / 1.0003;
+  CHECK(fabs(after.size() - expected_after) < 16);  // minus half a filter at the end
+  int max_step = 0;
+  for (size_t i = 1; i < 2400; i++) {
+    int step = abs(after[i] - after[i - 1]);
+    max_step = step > max_step ? step : max_step;
+  }
+  CHECK(abs(after[0] - before.back()) <= 1.1 * 2 * M_PI * 440 / 24000 * 8000);
+  CHECK(max_step <= 1.1 * 2 * M_PI * 440 / 24000 * 8000);
+  std::vector<int16_t> head(after.begin(), after.begin() + 24000);
+  double drift_snr = snrDb(head, 440 * 1.0003, 24000, 0);
+  CHECK(drift_snr >= 60);
+  drift.setRateAdjust(-300);
+  CHECK(drift.rateAdjust() == -300);
+  after = run(drift, rest);
+  CHECK(fabs(after.size() - rest.size() / 0.9997) < 16);
+  printf("rate adjust: SNR %.1f dB across the switch from passthrough\n", drift_snr);
+
+  // maxOutput() is an upper bound for process()
+  Resampler bound;
+  bound.begin(44100, 24000, RESAMPLE_MEDIUM, 512);
+  std::vector<int16_t> chunk = sine(300, 44100, 441, 8000);
+  int16_t out[512];
+  size_t consumed;
+  size_t limit = bound.maxOutput(chunk.size());
+  CHECK(bound.process(chunk.data(), chunk.size(), consumed, out, 512) <= limit);
+  CHECK(consumed == chunk.size());
+
+  return testResult();
+}
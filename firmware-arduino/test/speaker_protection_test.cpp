@@ -0,0 +1,214 @@
+/**
+ * @file speaker_protection_test.cpp
+ * @brief Host unit tests and benchmark for the EQ + look-ahead limiter output stage.
+ *
+ * Build and run on the host (no board needed):
+ *   g++ -std=gnu++17 -O2 -Isrc test/speaker_protection_test.cpp src/SpeakerProtection.cpp src/AudioDsp.cpp -o speaker_test && ./speaker_test
+ *
+ * The benchmark reports ns per 20 ms block on the host for the default chain,
+ * with every sample above the ceiling (the worst case); test/audio_dsp_benchmark.cpp
+ * gives cycles per block on the board.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+#include "SpeakerProtection.h"
+#include "host/TestCheck.h"
+
+constexpr uint32_t RATE = 24000;
+constexpr size_t BLOCK = 240;  // the mixer's 10 ms block
+
+static std::vector<int16_t> sine(float freq, float amplitude, size_t count) {
+  std::vector<int16_t> out(count);
+  for (size_t i = 0; i < count; i++) {
+    out[i] = (int16_t)lrintf(amplitude * sinf(2 * (float)M_PI * freq * i / RATE));
+  }
+  return out;
+}
+
+static void run(SpeakerProtection &sp, std::vector<int16_t> &pcm) {
+  for (size_t i = 0; i < pcm.size(); i += BLOCK) {
+    size_t n = pcm.size() - i < BLOCK ? pcm.size() - i : BLOCK;
+    sp.process(pcm.data() + i, n);
+  }
+}
+
+static double rmsOf(const std::vector<int16_t> &pcm, size_t from) {
+  double sum = 0;
+  for (size_t i = from; i < pcm.size(); i++) {
+    sum += (double)pcm[i] * pcm[i];
+  }
+  return sqrt(sum / (pcm.size() - from));
+}
+
+static int peakOf(const std::vector<int16_t> &pcm, size_t from = 0) {
+  int peak = 0;
+  for (size_t i = from; i < pcm.size(); i++) {
+    peak = abs(pcm[i]) > peak ? abs(pcm[i]) : peak;
+  }
+  return peak;
+}
+
+static SpeakerProtectionConfig flatConfig() {
+  SpeakerProtectionConfig cfg;
+  cfg.sample_rate = RATE;
+  return cfg;
+}
+
+// single-stage gain at `freq` in dB
+static double eqGainDb(const BiquadSpec &spec, float freq) {
+  SpeakerProtectionConfig cfg = flatConfig();
+  cfg.eq[0] = spec;
+  cfg.ceiling = 32767;
+  SpeakerProtection sp;
+  sp.setGain(8192);  // -12 dB headroom so the limiter stays out of it
+  sp.begin(cfg);
+  std::vector<int16_t> in = sine(freq, 8000, RATE);
+  std::vector<int16_t> out = in;
+  run(sp, out);
+  return 20 * log10(rmsOf(out, RATE / 2) / (rmsOf(in, RATE / 2) / 4));
+}
+
+int main() {
+  // flat, below the ceiling: a pure delay by the look-ahead
+  {
+    SpeakerProtection sp;
+    sp.begin(flatConfig());
+    size_t delay = sp.latencySamples();
+    CHECK(delay == 48);  // 2 ms at 24 kHz
+    std::vector<int16_t> in(4800);
+    for (size_t i = 0; i < in.size(); i++) {
+      in[i] = (int16_t)((rand() % 40000) - 20000);
+    }
+    std::vector<int16_t> out = in;
+    run(sp, out);
+    bool same = true;
+    for (size_t i = delay; i < in.size(); i++) {
+      same &= out[i] == in[i - delay];
+    }
+    CHECK(same);
+    CHECK(sp.stats().limited_samples == 0);
+  }
+
+  // a 2x boost of a full-scale sine never leaves the ceiling, and keeps its level
+  {
+    SpeakerProtection sp;
+    SpeakerProtectionConfig cfg = flatConfig();
+    sp.setGain(65535);
+    sp.begin(cfg);
+    std::vector<int16_t> pcm = sine(440, 30000, RATE);
+    run(sp, pcm);
+    printf("boosted sine: peak %d, rms %.0f\n", peakOf(pcm), rmsOf(pcm, RATE / 2));
+    CHECK(peakOf(pcm) <= cfg.ceiling);
+    CHECK(rmsOf(pcm, RATE / 2) > 0.6 * cfg.ceiling);  // limited, not gated
+    CHECK(sp.stats().limited_samples > 0);
+  }
+
+  // random peaks of any size stay under the ceiling
+  {
+    SpeakerProtection sp;
+    SpeakerProtectionConfig cfg = flatConfig();
+    cfg.eq[0] = {BIQUAD_PEAK, 2500, 1.0f, 6};
+    sp.setGain(60000);
+    sp.begin(cfg);
+    std::vector<int16_t> pcm(RATE * 2);
+    for (size_t i = 0; i < pcm.size(); i++) {
+      pcm[i] = (i / 300) % 3 == 0 ? (int16_t)((rand() % 65536) - 32768) : (int16_t)((rand() % 2000) - 1000);
+    }
+    run(sp, pcm);
+    CHECK(peakOf(pcm) <= cfg.ceiling);
+  }
+
+  // the levels measured on the way out match a separate pass over the output
+  {
+    SpeakerProtection sp;
+    sp.setGain(65535);
+    sp.begin(flatConfig());
+    bool match = true;
+    uint32_t clipped = 0;
+    std::vector<int16_t> pcm = sine(440, 25000, BLOCK * 20);
+    for (size_t i = 0; i < pcm.size(); i += BLOCK) {
+      DspLevels tap = sp.process(pcm.data() + i, BLOCK);
+      DspLevels pass = dspLevels(pcm.data() + i, BLOCK);
+      match &= tap.peak == pass.peak && tap.rms == pass.rms;
+      clipped += tap.clipped;
+    }
+    CHECK(match);
+    CHECK(clipped > 0);  // 2 x 25000 is past full scale
+  }
+
+  // after a loud burst the gain comes back within the release time
+  {
+    SpeakerProtection sp;
+    SpeakerProtectionConfig cfg = flatConfig();
+    sp.begin(cfg);
+    std::vector<int16_t> pcm = sine(300, 32000, RATE / 2);
+    std::vector<int16_t> quiet = sine(300, 10000, RATE / 2);
+    pcm.insert(pcm.end(), quiet.begin(), quiet.end());
+    run(sp, pcm);
+    CHECK(sp.stats().min_gain_q15 < 32768);
+    size_t settled = RATE / 2 + sp.latencySamples() + cfg.release_ms * RATE / 1000;
+    CHECK(peakOf(pcm, settled) >= 9990 && peakOf(pcm, settled) <= 10000);
+  }
+
+  // the EQ matches its design
+  {
+    BiquadSpec hp = {BIQUAD_HIGHPASS, 150, 0.707f, 0};
+    BiquadSpec peak = {BIQUAD_PEAK, 2000, 1.0f, 6};
+    BiquadSpec shelf = {BIQUAD_LOWSHELF, 300, 0.707f, -6};
+    double hpLow = eqGainDb(hp, 50), hpPass = eqGainDb(hp, 2000);
+    double peakAt = eqGainDb(peak, 2000), peakOff = eqGainDb(peak, 200);
+    double shelfLow = eqGainDb(shelf, 60), shelfHigh = eqGainDb(shelf, 4000);
+    printf("highpass 150 Hz: %.1f dB at 50 Hz, %.2f dB at 2 kHz\n", hpLow, hpPass);
+    printf("peak +6 dB 2 kHz: %.2f dB at 2 kHz, %.2f dB at 200 Hz\n", peakAt, peakOff);
+    printf("low shelf -6 dB: %.2f dB at 60 Hz, %.2f dB at 4 kHz\n", shelfLow, shelfHigh);
+    CHECK(hpLow < -18);
+    CHECK(fabs(hpPass) < 0.2);
+    CHECK(fabs(peakAt - 6) < 0.2);
+    CHECK(fabs(peakOff) < 0.3);
+    CHECK(fabs(shelfLow + 6) < 0.3);
+    CHECK(fabs(shelfHigh) < 0.2);
+  }
+
+  // silence in, silence out: the error feedback must not idle-tone
+  {
+    SpeakerProtection sp;
+    SpeakerProtectionConfig cfg = flatConfig();
+    cfg.eq[0] = {BIQUAD_HIGHPASS, 150, 0.707f, 0};
+    cfg.eq[1] = {BIQUAD_PEAK, 2500, 1.0f, 4};
+    sp.begin(cfg);
+    std::vector<int16_t> pcm = sine(1000, 20000, RATE / 10);
+    pcm.resize(RATE * 2, 0);
+    run(sp, pcm);
+    CHECK(peakOf(pcm, RATE) <= 1);
+  }
+
+  // benchmark: three stages, every sample above the ceiling, 20 ms at 24 and 48 kHz
+  for (uint32_t rate : {24000u, 48000u}) {
+    SpeakerProtection sp;
+    SpeakerProtectionConfig cfg;
+    cfg.sample_rate = rate;
+    cfg.eq[0] = {BIQUAD_HIGHPASS, 150, 0.707f, 0};
+    cfg.eq[1] = {BIQUAD_PEAK, 2500, 1.0f, 4};
+    cfg.eq[2] = {BIQUAD_HIGHSHELF, 6000, 0.707f, -3};
+    sp.setGain(65535);
+    sp.begin(cfg);
+    size_t block = rate / 50;
+    std::vector<int16_t> pcm(block);
+    const int rounds = 20000;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+      for (size_t i = 0; i < block; i++) {
+        pcm[i] = (i & 1) ? 30000 : -30000;
+      }
+      sp.process(pcm.data(), block);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("%u Hz: %.2f ns/sample, %.1f us per 20 ms block\n", (unsigned)rate, ns / rounds / block,
+           ns / rounds / 1000);
+  }
+
+  return testResult();
+}
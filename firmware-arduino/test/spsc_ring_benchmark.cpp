@@ -0,0 +1,104 @@
+/**
+ * @file spsc_ring_benchmark.cpp
+ * @brief Bytes per second through SpscRing vs BufferRTOS, producer and consumer on different cores.
+ *
+ * Each run streams 4 MB from a producer task on core 1 to a consumer on core 0
+ * in fixed-size chunks: BufferRTOS with writeArray()/readArray() (a FreeRTOS
+ * stream buffer), SpscRing with write()/read(), and SpscRing in place with
+ * reserve()/commit() and peek()/consume(). Flash as a sketch (copy
+ * src/SpscRing.* next to it) and read the serial output.
+ */
+#include "AudioTools.h"
+#include "SpscRing.h"
+
+constexpr size_t RING_BYTES = 16384;
+constexpr size_t TOTAL_BYTES = 4 * 1024 * 1024;
+
+enum Mode { MODE_BUFFER_RTOS, MODE_SPSC_COPY, MODE_SPSC_IN_PLACE };
+
+static BufferRTOS<uint8_t> rtos(RING_BYTES, 1);
+static SpscRing spsc;
+static volatile Mode mode;
+static volatile size_t chunk;
+static SemaphoreHandle_t done;
+static uint8_t producerChunk[2048];
+static uint8_t consumerChunk[2048];
+
+static void producerTask(void *) {
+  size_t sent = 0;
+  while (sent < TOTAL_BYTES) {
+    size_t n = 0;
+    if (mode == MODE_BUFFER_RTOS) {
+      n = rtos.writeArray(producerChunk, chunk);
+    } else if (mode == MODE_SPSC_COPY) {
+      n = spsc.write(producerChunk, chunk);
+    } else {
+      uint8_t *dst = spsc.reserve(n);
+      n = n < chunk ? n : chunk;
+      memset(dst, 0x55, n);  // stands in for decoding or an I2S read into the ring
+      spsc.commit(n);
+    }
+    sent += n;
+    if (n == 0) {
+      taskYIELD();
+    }
+  }
+  vTaskDelete(NULL);
+}
+
+static void consumerTask(void *) {
+  size_t received = 0;
+  uint32_t sum = 0;
+  while (received < TOTAL_BYTES) {
+    size_t n = 0;
+    if (mode == MODE_BUFFER_RTOS) {
+      n = rtos.readArray(consumerChunk, chunk);
+    } else if (mode == MODE_SPSC_COPY) {
+      n = spsc.read(consumerChunk, chunk);
+    } else {
+      const uint8_t *src = spsc.peek(n);
+      n = n < chunk ? n : chunk;
+      sum += n ? src[0] : 0;  // stands in for sending or DMA straight from the ring
+      spsc.consume(n);
+    }
+    received += n;
+    if (n == 0) {
+      taskYIELD();
+    }
+  }
+  (void)sum;
+  xSemaphoreGive(done);
+  vTaskDelete(NULL);
+}
+
+static float run(Mode m, size_t c) {
+  mode = m;
+  chunk = c;
+  rtos.reset();
+  spsc.clear();
+  uint32_t start = micros();
+  xTaskCreatePinnedToCore(consumerTask, "consumer", 4096, NULL, 5, NULL, 0);
+  xTaskCreatePinnedToCore(producerTask, "producer", 4096, NULL, 5, NULL, 1);
+  xSemaphoreTake(done, portMAX_DELAY);
+  return (float)TOTAL_BYTES / (micros() - start);
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(2000);
+  done = xSemaphoreCreateBinary();
+  spsc.begin(RING_BYTES);
+  memset(producerChunk, 0x55, sizeof(producerChunk));
+
+  Serial.println("chunk  BufferRTOS MB/s  SpscRing MB/s  SpscRing in place MB/s");
+  for (size_t c : {2, 64, 512, 2048}) {
+    float a = run(MODE_BUFFER_RTOS, c);
+    float b = run(MODE_SPSC_COPY, c);
+    float d = run(MODE_SPSC_IN_PLACE, c);
+    Serial.printf("%5u  %15.2f  %13.2f  %22.2f\n", (unsigned)c, a, b, d);
+  }
+}
+
+void loop() {
+  delay(1000);
+}
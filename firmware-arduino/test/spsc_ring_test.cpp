@@ -0,0 +1,295 @@
+/**
+ * @file spsc_ring_test.cpp
+ * @brief Host stress test and throughput comparison for SpscRing.
+ *
+ * Build and run on the host (no board needed), once plain and once under
+ * ThreadSanitizer:
+ *   g++ -std=gnu++17 -O2 -pthread -Isrc test/spsc_ring_test.cpp src/SpscRing.cpp -o spsc_test && ./spsc_test
+ *   g++ -std=gnu++17 -O1 -g -fsanitize=thread -pthread -Isrc test/spsc_ring_test.cpp src/SpscRing.cpp \
+ *       -o spsc_tsan && ./spsc_tsan
+ *
+ * A producer and a consumer thread stream a counting byte pattern through the
+ * ring in random-sized pieces, using both the copying and the in-place API, and
+ * the consumer checks every byte; a second run streams length-prefixed records
+ * while the consumer clear()s at random and checks that no header is torn. The throughput table compares the ring with
+ * a mutex-guarded ring, which stands in for the locking of a FreeRTOS stream
+ * buffer (BufferRTOS), first interleaved on one thread and then on two threads
+ * (skipped on single-core hosts). test/spsc_ring_benchmark.cpp compares against
+ * BufferRTOS itself on the board.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "SpscRing.h"
+#include "host/TestCheck.h"
+
+static void singleThreaded() {
+  SpscRing ring;
+  CHECK(ring.begin(1000));
+  CHECK(ring.capacity() == 1024);
+  CHECK(ring.space() == 1024 && ring.available() == 0);
+
+  uint8_t in[1024], out[1024];
+  for (int i = 0; i < 1024; i++) {
+    in[i] = (uint8_t)i;
+  }
+  CHECK(ring.write(in, 1000) == 1000);
+  CHECK(ring.write(in, 100) == 24);  // only what fits
+  CHECK(ring.space() == 0);
+  size_t len;
+  ring.reserve(len);
+  CHECK(len == 0);
+
+  CHECK(ring.read(out, 600) == 600);
+  CHECK(memcmp(out, in, 600) == 0);
+  // the writable region stops at the wrap point
+  uint8_t *w = ring.reserve(len);
+  CHECK(len == 600 && w != nullptr);
+  ring.commit(10);
+  const uint8_t *r = ring.peek(len);
+  CHECK(len == 424 && r[0] == (uint8_t)600);
+  ring.consume(len);
+  r = ring.peek(len);
+  CHECK(len == 10);  // continues at the start of the buffer
+
+  ring.clear();
+  CHECK(ring.available() == 0 && ring.space() == 1024);
+}
+
+struct Lcg {
+  uint32_t s;
+  size_t next(size_t max) {
+    s = s * 1103515245u + 12345u;
+    return (s >> 16) % max + 1;
+  }
+};
+
+static void stress(size_t capacity, size_t total) {
+  SpscRing ring;
+  ring.begin(capacity);
+  bool ok = true;
+
+  std::thread producer([&] {
+    Lcg rng{7};
+    size_t sent = 0;
+    std::vector<uint8_t> chunk(capacity);
+    while (sent < total) {
+      size_t want = rng.next(capacity / 2);
+      if (want > total - sent) {
+        want = total - sent;
+      }
+      if (rng.next(2) == 1) {
+        size_t len;
+        uint8_t *dst = ring.reserve(len);
+        if (len > want) {
+          len = want;
+        }
+        for (size_t i = 0; i < len; i++) {
+          dst[i] = (uint8_t)(sent + i);
+        }
+        ring.commit(len);
+        sent += len;
+      } else {
+        for (size_t i = 0; i < want; i++) {
+          chunk[i] = (uint8_t)(sent + i);
+        }
+        sent += ring.write(chunk.data(), want);
+      }
+      if (rng.next(8) == 1) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  std::thread consumer([&] {
+    Lcg rng{11};
+    size_t received = 0;
+    std::vector<uint8_t> chunk(capacity);
+    while (received < total) {
+      size_t want = rng.next(capacity / 2);
+      if (rng.next(2) == 1) {
+        size_t len;
+        const uint8_t *src = ring.peek(len);
+        if (len > want) {
+          len = want;
+        }
+        for (size_t i = 0; i < len; i++) {
+          ok &= src[i] == (uint8_t)(received + i);
+        }
+        ring.consume(len);
+        received += len;
+      } else {
+        size_t n = ring.read(chunk.data(), want);
+        for (size_t i = 0; i < n; i++) {
+          ok &= chunk[i] == (uint8_t)(received + i);
+        }
+        received += n;
+      }
+      if (rng.next(8) == 1) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  producer.join();
+  consumer.join();
+  CHECK(ok);
+  CHECK(ring.available() == 0);
+}
+
+// Length-prefixed records, as micTask queues Opus packets, with the consumer
+// clear()ing at random like networkTask does when a turn ends. Each write() is
+// one commit, so a clear() only ever lands between records and the consumer
+// never takes payload bytes for a header.
+static void recordsSurviveClear(size_t capacity, size_t records) {
+  SpscRing ring;
+  ring.begin(capacity);
+  const size_t max_payload = capacity / 4;
+  bool ok = true;
+  std::atomic<bool> done{false};
+
+  std::thread producer([&] {
+    Lcg rng{3};
+    std::vector<uint8_t> record(2 + max_payload);
+    for (size_t r = 0; r < records;) {
+      uint16_t len = (uint16_t)rng.next(max_payload);
+      if (ring.space() < 2u + len) {
+        std::this_thread::yield();
+        continue;
+      }
+      memcpy(record.data(), &len, 2);
+      memset(record.data() + 2, (uint8_t)len, len);
+      ring.write(record.data(), 2u + len);
+      r++;
+    }
+    done = true;
+  });
+
+  Lcg rng{5};
+  std::vector<uint8_t> payload(max_payload);
+  size_t clears = 0;
+  while (!done || ring.available() > 0) {
+    if (rng.next(16) == 1) {
+      ring.clear();
+      clears++;
+      continue;
+    }
+    uint16_t len;
+    if (ring.available() < 2) {
+      std::this_thread::yield();
+      continue;
+    }
+    ring.read((uint8_t *)&len, 2);
+    ok &= len >= 1 && len <= max_payload && ring.available() >= len;
+    if (!ok) {
+      break;
+    }
+    ring.read(payload.data(), len);
+    for (size_t i = 0; i < len; i++) {
+      ok &= payload[i] == (uint8_t)len;
+    }
+  }
+  producer.join();
+  CHECK(ok);
+  CHECK(clears > 0);
+}
+
+// the same interface behind one mutex with memcpy()s, as a FreeRTOS stream buffer works
+class LockedRing {
+public:
+  explicit LockedRing(size_t capacity) : buf(capacity) {}
+  size_t write(const uint8_t *src, size_t len) {
+    std::lock_guard<std::mutex> lock(m);
+    size_t n = len < buf.size() - count ? len : buf.size() - count;
+    size_t at = (start + count) % buf.size();
+    size_t first = n < buf.size() - at ? n : buf.size() - at;
+    memcpy(&buf[at], src, first);
+    memcpy(&buf[0], src + first, n - first);
+    count += n;
+    return n;
+  }
+  size_t read(uint8_t *out, size_t len) {
+    std::lock_guard<std::mutex> lock(m);
+    size_t n = len < count ? len : count;
+    size_t first = n < buf.size() - start ? n : buf.size() - start;
+    memcpy(out, &buf[start], first);
+    memcpy(out + first, &buf[0], n - first);
+    start = (start + n) % buf.size();
+    count -= n;
+    return n;
+  }
+
+private:
+  std::mutex m;
+  std::vector<uint8_t> buf;
+  size_t start = 0, count = 0;
+};
+
+// per-chunk cost without scheduling effects: write and read alternately
+template <typename Ring>
+static double interleaved(Ring &ring, size_t chunk, size_t total) {
+  std::vector<uint8_t> data(chunk, 0x55), out(chunk);
+  auto t0 = std::chrono::steady_clock::now();
+  for (size_t done = 0; done < total; done += chunk) {
+    ring.write(data.data(), chunk);
+    ring.read(out.data(), chunk);
+  }
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  return total / s / 1e6;
+}
+
+// producer and consumer on two threads
+template <typename Ring>
+static double threaded(Ring &ring, size_t chunk, size_t total) {
+  auto t0 = std::chrono::steady_clock::now();
+  std::thread producer([&] {
+    std::vector<uint8_t> data(chunk, 0x55);
+    size_t sent = 0;
+    while (sent < total) {
+      size_t n = ring.write(data.data(), chunk);
+      sent += n;
+      if (n == 0) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  std::vector<uint8_t> out(chunk);
+  size_t received = 0;
+  while (received < total) {
+    size_t n = ring.read(out.data(), chunk);
+    received += n;
+    if (n == 0) {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  return received / s / 1e6;
+}
+
+int main() {
+  singleThreaded();
+  stress(64, 256 << 10);
+  stress(4096, 4 << 20);
+  recordsSurviveClear(256, 200000);
+
+  // two-thread figures only mean something with a core per thread
+  bool parallel = std::thread::hardware_concurrency() > 1;
+  printf("%-6s %12s %12s %14s %14s\n", "chunk", "spsc MB/s", "locked MB/s", "spsc 2T MB/s", "locked 2T MB/s");
+  for (size_t chunk : {64, 512, 2048}) {
+    SpscRing spsc;
+    spsc.begin(16384);
+    LockedRing locked(16384);
+    double a = interleaved(spsc, chunk, 64 << 20);
+    double b = interleaved(locked, chunk, 64 << 20);
+    double c = parallel ? threaded(spsc, chunk, 64 << 20) : 0;
+    double d = parallel ? threaded(locked, chunk, 64 << 20) : 0;
+    printf("%-6zu %12.1f %12.1f %14.1f %14.1f\n", chunk, a, b, c, d);
+  }
+
+  return testResult();
+}
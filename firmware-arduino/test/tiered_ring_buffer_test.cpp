@@ -0,0 +1,106 @@
+/**
+ * @file tiered_ring_buffer_test.cpp
+ * @brief Host checks of TieredRingBuffer ordering, wrap-around and accounting.
+ *
+ * Build and run on the host (no board needed):
+ *   g++ -std=gnu++17 -O2 -Isrc test/tiered_ring_buffer_test.cpp src/TieredRingBuffer.cpp -o ring_test && ./ring_test
+ *
+ * The host has no PSRAM, so this runs on the internal-RAM fallback; the PSRAM
+ * and DRAM throughput comparison is test/psram_ring_benchmark.cpp on the board.
+ */
+#include <stdio.h>
+#include <vector>
+#include "TieredRingBuffer.h"
+#include "host/TestCheck.h"
+
+static uint32_t seed = 1;
+static size_t rnd(size_t max) {
+  seed = seed * 1103515245u + 12345u;
+  return (seed >> 16) % (max + 1);
+}
+
+static void fallsBackWithoutPsram() {
+  TieredRingBuffer ring;
+  CHECK(ring.begin(96000, 1024, 4000));
+  CHECK(!ring.inPsram());
+  CHECK(ring.capacitySamples() == 4000);
+  CHECK(ring.space() == 4000 && ring.available() == 0);
+  CHECK(!ring.begin(1000, 0, 1000));
+}
+
+// random-sized writes and reads, mixing read() and peek()/consume()
+static void keepsOrderAcrossWraps() {
+  TieredRingBuffer ring;
+  CHECK(ring.begin(0, 96, 1000));
+  std::vector<int16_t> in(700), out(700);
+  int16_t next_in = 0, next_out = 0;
+  size_t total_in = 0, total_out = 0;
+  bool ordered = true, accounted = true;
+
+  for (int round = 0; round < 20000; round++) {
+    size_t n = rnd(in.size() - 1);
+    for (size_t i = 0; i < n; i++) {
+      in[i] = next_in + (int16_t)i;
+    }
+    size_t space = ring.space();
+    size_t w = ring.write(in.data(), n);
+    accounted &= w == (n < space ? n : space);
+    next_in += (int16_t)w;
+    total_in += w;
+
+    if (round % 3 == 0) {
+      size_t avail;
+      const int16_t *p = ring.peek(avail);
+      size_t use = rnd(avail);
+      for (size_t i = 0; i < use; i++) {
+        ordered &= p[i] == next_out++;
+      }
+      ring.consume(use);
+      total_out += use;
+    } else {
+      size_t r = ring.read(out.data(), rnd(out.size() - 1));
+      for (size_t i = 0; i < r; i++) {
+        ordered &= out[i] == next_out++;
+      }
+      total_out += r;
+    }
+    accounted &= ring.available() == total_in - total_out;
+  }
+  CHECK(ordered);
+  CHECK(accounted);
+
+  // drain the rest
+  size_t r;
+  while ((r = ring.read(out.data(), out.size())) > 0) {
+    for (size_t i = 0; i < r; i++) {
+      ordered &= out[i] == next_out++;
+    }
+    total_out += r;
+  }
+  CHECK(ordered);
+  CHECK(total_out == total_in);
+  CHECK(ring.available() == 0 && ring.space() == ring.capacitySamples());
+}
+
+// data waiting in the hot window does not count against the backing store
+static void hotWindowFreesSpace() {
+  TieredRingBuffer ring;
+  CHECK(ring.begin(0, 64, 256));
+  int16_t block[256] = {};
+  CHECK(ring.write(block, 256) == 256);
+  CHECK(ring.space() == 0);
+  size_t n;
+  ring.peek(n);
+  CHECK(n == 64);
+  CHECK(ring.space() == 64);
+  CHECK(ring.available() == 256);
+  ring.reset();
+  CHECK(ring.available() == 0 && ring.space() == 256);
+}
+
+int main() {
+  fallsBackWithoutPsram();
+  keepsOrderAcrossWraps();
+  hotWindowFreesSpace();
+  return testResult();
+}
@@ -0,0 +1,258 @@
+/**
+ * @file wsola_test.cpp
+ * @brief Host quality and throughput checks for the WSOLA pitch and tempo engine.
+ *
+ * Build and run on the host (no board needed):
+ *   g++ -std=gnu++17 -O2 -Isrc test/wsola_test.cpp src/Wsola.cpp src/Resampler.cpp test/host/GrainPitchShift.cpp -o wsola_test && ./wsola_test
+ *
+ * Quality is the SNR of a shifted tone against an ideal tone at the shifted
+ * frequency, fitted over 2048-sample windows, next to the grain shifter it
+ * replaces. Throughput is host time per 20 ms block at 24 kHz for each tier,
+ * for the pitch shift and for the time stretch bhajans use. A reserved shifter
+ * must re-parameterise without allocating.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <new>
+#include <vector>
+#include "Wsola.h"
+#include "host/GrainPitchShift.h"
+#include "host/TestCheck.h"
+
+// counts the engine's buffer allocations, to show what reserve() saves the audio task
+static size_t arrayAllocations = 0;
+void *operator new[](size_t size) {
+  arrayAllocations++;
+  void *p = malloc(size);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+constexpr uint32_t RATE = 24000;
+constexpr size_t BLOCK = RATE / 50;  // 20 ms
+
+static const char *tierName(WsolaQuality q) {
+  return q == WSOLA_LOW ? "low" : q == WSOLA_MEDIUM ? "medium" : "high";
+}
+
+static std::vector<int16_t> sine(double freq, size_t count, double amplitude = 12000) {
+  std::vector<int16_t> v(count);
+  for (size_t i = 0; i < count; i++) {
+    v[i] = (int16_t)lrint(amplitude * sin(2 * M_PI * freq * i / RATE));
+  }
+  return v;
+}
+
+// vowel-like: 140 Hz fundamental with falling harmonics, slowly gliding
+static std::vector<int16_t> voice(size_t count) {
+  std::vector<int16_t> v(count);
+  double phase = 0;
+  for (size_t i = 0; i < count; i++) {
+    double f0 = 140 + 20 * sin(2 * M_PI * 0.7 * i / RATE);
+    phase += 2 * M_PI * f0 / RATE;
+    double s = 0;
+    for (int h = 1; h <= 12; h++) {
+      s += sin(h * phase) / h;
+    }
+    v[i] = (int16_t)lrint(5000 * s);
+  }
+  return v;
+}
+
+// mean SNR of `x` against the best-fitting tone at `freq`, window by window
+static double toneSnrDb(const std::vector<int16_t> &x, size_t from, double freq) {
+  const size_t window = 2048;
+  double total = 0;
+  int windows = 0;
+  for (size_t start = from; start + window <= x.size(); start += window) {
+    double ss = 0, sc = 0, cc = 0, xs = 0, xc = 0, xx = 0;
+    for (size_t i = 0; i < window; i++) {
+      double w = 2 * M_PI * freq * (start + i) / RATE;
+      double s = sin(w), c = cos(w), v = x[start + i];
+      ss += s * s, sc += s * c, cc += c * c, xs += v * s, xc += v * c, xx += v * v;
+    }
+    double det = ss * cc - sc * sc;
+    double a = (xs * cc - xc * sc) / det, b = (xc * ss - xs * sc) / det;
+    double fitted = a * xs + b * xc;  // energy of the projection
+    double noise = xx - fitted;
+    total += 10 * log10(fitted / (noise > 1e-9 ? noise : 1e-9));
+    windows++;
+  }
+  return windows ? total / windows : 0;
+}
+
+static std::vector<int16_t> shifted(std::vector<int16_t> pcm, float pitch, WsolaQuality q, size_t &latency,
+                                    uint32_t *underruns = nullptr) {
+  WsolaPitchShift shift;
+  shift.begin(RATE, pitch, q);
+  latency = shift.latencySamples();
+  for (size_t i = 0; i < pcm.size();) {
+    size_t n = 1 + rand() % 1200;  // decoder frames come in any size
+    n = n < pcm.size() - i ? n : pcm.size() - i;
+    shift.process(pcm.data() + i, n);
+    i += n;
+  }
+  if (underruns) {
+    *underruns = shift.underruns();
+  }
+  return pcm;
+}
+
+int main() {
+  const WsolaQuality tiers[] = {WSOLA_LOW, WSOLA_MEDIUM, WSOLA_HIGH};
+
+  // quality: a shifted tone against the ideal one, and against the grain shifter
+  for (float pitch : {0.8f, 1.25f, 1.5f}) {
+    for (double freq : {220.0, 1000.0}) {
+      double target = freq * lrintf(RATE * pitch) / RATE;
+      std::vector<int16_t> grain = sine(freq, RATE * 3);
+      GrainPitchShift old;
+      old.begin(pitch);
+      old.process(grain.data(), grain.data(), grain.size());
+      double grain_snr = toneSnrDb(grain, RATE / 2, target);
+      printf("pitch %.2f, %4.0f Hz: grain %5.1f dB", pitch, freq, grain_snr);
+      for (WsolaQuality q : tiers) {
+        size_t latency;
+        uint32_t underruns;
+        std::vector<int16_t> out = shifted(sine(freq, RATE * 3), pitch, q, latency, &underruns);
+        double snr = toneSnrDb(out, latency + RATE / 2, target);
+        printf(", %s %5.1f dB", tierName(q), snr);
+        CHECK(underruns == 0);
+        CHECK(snr > grain_snr + 6);
+        CHECK(snr > (q == WSOLA_LOW ? 15 : 20));
+      }
+      printf("\n");
+    }
+  }
+
+  // same count out as in, delayed by the stated latency: a click comes out once, where expected
+  {
+    size_t latency;
+    std::vector<int16_t> pcm(RATE, 0);
+    pcm[RATE / 4] = 30000;
+    std::vector<int16_t> out = shifted(pcm, 1.25f, WSOLA_MEDIUM, latency);
+    size_t loudest = 0;
+    for (size_t i = 0; i < out.size(); i++) {
+      loudest = abs(out[i]) > abs(out[loudest]) ? i : loudest;
+    }
+    printf("latency %zu samples (%.1f ms), click at +%d\n", latency, latency * 1000.0 / RATE,
+           (int)loudest - RATE / 4);
+    CHECK(out.size() == pcm.size());
+    CHECK(loudest >= RATE / 4 && loudest <= RATE / 4 + latency);
+  }
+
+  // reserve(): begin()s up to the reserved rate only re-parameterise, and the
+  // reused buffers give the same output as a fresh shifter
+  {
+    WsolaPitchShift reserved, fresh;
+    CHECK(reserved.reserve(48000, WSOLA_HIGH));
+    CHECK(!reserved.active());
+    size_t before = arrayAllocations;
+    for (uint32_t rate : {16000u, 48000u, RATE}) {
+      for (float pitch : {2.0f, 0.5f, 0.8f, 1.3f}) {
+        CHECK(reserved.begin(rate, pitch, WSOLA_HIGH));
+      }
+    }
+    CHECK(arrayAllocations == before);
+    CHECK(reserved.active());
+    fresh.begin(RATE, 1.3f, WSOLA_HIGH);
+    std::vector<int16_t> a = voice(RATE), b = a;
+    for (size_t i = 0; i < a.size(); i += BLOCK) {
+      reserved.process(a.data() + i, BLOCK);
+      fresh.process(b.data() + i, BLOCK);
+    }
+    CHECK(a == b);
+  }
+
+  // reentrant: two interleaved instances match one run each
+  {
+    std::vector<int16_t> a = voice(RATE), b = sine(500, RATE);
+    std::vector<int16_t> a2 = a, b2 = b;
+    WsolaPitchShift x, y, solo;
+    x.begin(RATE, 1.3f, WSOLA_MEDIUM);
+    y.begin(RATE, 0.7f, WSOLA_HIGH);
+    for (size_t i = 0; i < a.size(); i += BLOCK) {
+      x.process(a.data() + i, BLOCK);
+      y.process(b.data() + i, BLOCK);
+    }
+    solo.begin(RATE, 1.3f, WSOLA_MEDIUM);
+    solo.process(a2.data(), a2.size());
+    solo.begin(RATE, 0.7f, WSOLA_HIGH);
+    solo.process(b2.data(), b2.size());
+    CHECK(a == a2);
+    CHECK(b == b2);
+  }
+
+  // time stretch: the length follows the tempo, the pitch stays
+  for (float tempo : {0.5f, 0.75f, 1.5f, 2.0f}) {
+    WsolaStretch stretch;
+    stretch.begin(RATE, WSOLA_MEDIUM, BLOCK);
+    stretch.setTempo(tempo);
+    std::vector<int16_t> in = sine(440, RATE * 4);
+    std::vector<int16_t> out;
+    std::vector<int16_t> block(BLOCK * 4);
+    for (size_t i = 0; i < in.size(); i += BLOCK) {
+      stretch.write(in.data() + i, BLOCK);
+      size_t n;
+      while ((n = stretch.read(block.data(), block.size())) > 0) {
+        out.insert(out.end(), block.begin(), block.begin() + n);
+      }
+    }
+    double expected = in.size() / tempo;
+    double snr = toneSnrDb(out, RATE / 4, 440);
+    printf("tempo %.2f: %zu samples for %.0f expected, 440 Hz SNR %.1f dB\n", tempo, out.size(), expected, snr);
+    CHECK(fabs(out.size() - expected) < stretch.requiredInput() / tempo + stretch.sequenceOutput());
+    CHECK(snr > 20);
+  }
+
+  // throughput: 20 ms blocks of voice at 24 kHz
+  std::vector<int16_t> speech = voice(RATE * 10);
+  for (WsolaQuality q : tiers) {
+    WsolaPitchShift shift;
+    shift.begin(RATE, 1.25f, q);
+    std::vector<int16_t> pcm = speech;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < 5; round++) {
+      for (size_t i = 0; i + BLOCK <= pcm.size(); i += BLOCK) {
+        shift.process(pcm.data() + i, BLOCK);
+      }
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    size_t blocks = 5 * (pcm.size() / BLOCK);
+    printf("%-6s %.2f us per 20 ms block (%.0fx real time)\n", tierName(q), us / blocks, 20000.0 / (us / blocks));
+  }
+
+  // time stretch throughput, per 20 ms of output, fed the way bhajanAudioTask does
+  for (WsolaQuality q : tiers) {
+    printf("stretch %-6s", tierName(q));
+    for (float tempo : {0.75f, 1.25f, 2.0f}) {
+      WsolaStretch stretch;
+      stretch.begin(RATE, q, 256);
+      stretch.setTempo(tempo);
+      std::vector<int16_t> block(BLOCK);
+      size_t fed = 0, produced = 0;
+      auto start = std::chrono::steady_clock::now();
+      for (int round = 0; round < 5; round++) {
+        fed = 0;
+        while (fed + 256 <= speech.size()) {
+          size_t n = stretch.read(block.data(), BLOCK);
+          produced += n;
+          if (n < BLOCK) {
+            fed += stretch.write(speech.data() + fed, 256);
+          }
+        }
+      }
+      double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+      printf("  x%.2f %.2f us", tempo, us / ((double)produced / BLOCK));
+    }
+    printf(" per 20 ms\n");
+  }
+
+  return testResult();
+}